@@ -22,43 +22,68 @@
 
 using glm::uvec2;
 
-MelonDsDs::PixelBuffer::PixelBuffer(unsigned width, unsigned height) noexcept :
-    PixelBuffer(uvec2(width, height)) {
+// Written as a plain loop over contiguous pixels so that the compiler can vectorize it
+static void ConvertXrgb8888ToRgb565(uint16_t* destination, const uint32_t* source, size_t count) noexcept {
+    for (size_t i = 0; i < count; ++i) {
+        uint32_t pixel = source[i];
+        destination[i] = ((pixel >> 8) & 0xF800) | ((pixel >> 5) & 0x07E0) | ((pixel >> 3) & 0x001F);
+    }
+}
+
+static void CopyPixels(uint32_t* destination, const uint32_t* source, size_t count) noexcept {
+    memcpy(destination, source, count * sizeof(uint32_t));
+}
+
+static void CopyPixels(uint16_t* destination, const uint32_t* source, size_t count) noexcept {
+    ConvertXrgb8888ToRgb565(destination, source, count);
 }
 
-MelonDsDs::PixelBuffer::PixelBuffer(uvec2 size) noexcept :
+template<typename TPixel>
+MelonDsDs::BasicPixelBuffer<TPixel>::BasicPixelBuffer(unsigned width, unsigned height) noexcept :
+    BasicPixelBuffer(uvec2(width, height)) {
+}
+
+template<typename TPixel>
+MelonDsDs::BasicPixelBuffer<TPixel>::BasicPixelBuffer(uvec2 size) noexcept :
     size(size),
-    stride(size.x * sizeof(uint32_t)),
+    stride(size.x * sizeof(TPixel)),
     buffer(size.x * size.y, 0) {
 }
 
-void MelonDsDs::PixelBuffer::SetSize(uvec2 newSize) noexcept {
+template<typename TPixel>
+void MelonDsDs::BasicPixelBuffer<TPixel>::SetSize(uvec2 newSize) noexcept {
     ZoneScopedN(TracyFunction);
     if (newSize == size)
         return;
 
     size = newSize;
-    stride = size.x * sizeof(uint32_t);
+    stride = size.x * sizeof(TPixel);
     buffer.resize(size.x * size.y);
 }
 
-void MelonDsDs::PixelBuffer::Clear() noexcept {
+template<typename TPixel>
+void MelonDsDs::BasicPixelBuffer<TPixel>::Clear() noexcept {
     memset(buffer.data(), 0, buffer.size() * sizeof(buffer[0]));
 }
 
-void MelonDsDs::PixelBuffer::CopyDirect(const uint32_t* source, uvec2 destination) noexcept {
+template<typename TPixel>
+void MelonDsDs::BasicPixelBuffer<TPixel>::CopyDirect(const uint32_t* source, uvec2 destination) noexcept {
     ZoneScopedN(TracyFunction);
-    memcpy(&this->operator[](destination), source, NDS_SCREEN_AREA<size_t> * PIXEL_SIZE);
+    CopyPixels(&this->operator[](destination), source, NDS_SCREEN_AREA<size_t>);
 }
 
-void MelonDsDs::PixelBuffer::CopyRows(const uint32_t* source, uvec2 destination, uvec2 destinationSize) noexcept {
+template<typename TPixel>
+void MelonDsDs::BasicPixelBuffer<TPixel>::CopyRows(const uint32_t* source, uvec2 destination, uvec2 destinationSize) noexcept {
     ZoneScopedN(TracyFunction);
     for (unsigned y = 0; y < destinationSize.y; y++) {
         // For each row of the rendered screen...
-        memcpy(
+        CopyPixels(
             &this->operator[](uvec2(destination.x, destination.y + y)),
             source + (y * destinationSize.x),
-            destinationSize.x * PIXEL_SIZE
+            destinationSize.x
         );
     }
-}
\ No newline at end of file
+}
+
+template class MelonDsDs::BasicPixelBuffer<uint32_t>;
+template class MelonDsDs::BasicPixelBuffer<uint16_t>;
@@ -27,28 +27,32 @@
 #include "std/span.hpp"
 
 namespace MelonDsDs {
-    class PixelBuffer {
+    /// A 2D array of pixels in the format given by TPixel.
+    /// Source pixels are always XRGB8888 (as melonDS renders them),
+    /// and are converted as they're copied in if TPixel is narrower.
+    template<typename TPixel>
+    class BasicPixelBuffer {
     public:
-        PixelBuffer(unsigned width, unsigned height) noexcept;
-        explicit PixelBuffer(glm::uvec2 size) noexcept;
-        PixelBuffer(const PixelBuffer&) noexcept = default;
-        PixelBuffer(PixelBuffer&&) noexcept = default;
-        PixelBuffer& operator=(const PixelBuffer&) noexcept = default;
-        PixelBuffer& operator=(PixelBuffer&&) noexcept = default;
-
-        [[nodiscard]] uint32_t operator[](glm::uvec2 pos) const noexcept {
+        BasicPixelBuffer(unsigned width, unsigned height) noexcept;
+        explicit BasicPixelBuffer(glm::uvec2 size) noexcept;
+        BasicPixelBuffer(const BasicPixelBuffer&) noexcept = default;
+        BasicPixelBuffer(BasicPixelBuffer&&) noexcept = default;
+        BasicPixelBuffer& operator=(const BasicPixelBuffer&) noexcept = default;
+        BasicPixelBuffer& operator=(BasicPixelBuffer&&) noexcept = default;
+
+        [[nodiscard]] TPixel operator[](glm::uvec2 pos) const noexcept {
             return buffer[pos.y * size.x + pos.x];
         }
 
-        [[nodiscard]] uint32_t& operator[](glm::uvec2 pos) noexcept {
+        [[nodiscard]] TPixel& operator[](glm::uvec2 pos) noexcept {
             return buffer[pos.y * size.x + pos.x];
         }
 
-        [[nodiscard]] uint32_t* operator[](unsigned row) noexcept {
+        [[nodiscard]] TPixel* operator[](unsigned row) noexcept {
             return buffer.data() + row * size.x;
         }
 
-        [[nodiscard]] const uint32_t* operator[](unsigned row) const noexcept {
+        [[nodiscard]] const TPixel* operator[](unsigned row) const noexcept {
             return buffer.data() + row * size.x;
         }
 
@@ -57,16 +61,23 @@ namespace MelonDsDs {
         [[nodiscard]] unsigned Width() const noexcept { return size.x; }
         [[nodiscard]] unsigned Height() const noexcept { return size.y; }
         [[nodiscard]] unsigned Stride() const noexcept { return stride; }
-        [[nodiscard]] std::span<uint32_t> Buffer() noexcept { return buffer; }
-        [[nodiscard]] std::span<const uint32_t> Buffer() const noexcept { return buffer; }
+        [[nodiscard]] std::span<TPixel> Buffer() noexcept { return buffer; }
+        [[nodiscard]] std::span<const TPixel> Buffer() const noexcept { return buffer; }
         void Clear() noexcept;
         void CopyDirect(const uint32_t* source, glm::uvec2 destination) noexcept;
         void CopyRows(const uint32_t* source, glm::uvec2 destination, glm::uvec2 destinationSize) noexcept;
     private:
         glm::uvec2 size;
         unsigned stride;
-        std::vector<uint32_t> buffer;
+        std::vector<TPixel> buffer;
     };
+
+    /// Stores pixels as XRGB8888, exactly as melonDS renders them.
+    using PixelBuffer = BasicPixelBuffer<uint32_t>;
+
+    /// Stores pixels as RGB565,
+    /// so the composited frame is never stored at full depth.
+    using Rgb565PixelBuffer = BasicPixelBuffer<uint16_t>;
 }
 
 #endif //MELONDS_DS_BUFFER_HPP
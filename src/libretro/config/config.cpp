@@ -27,6 +27,7 @@
 #include <memory>
 #include <span>
 #include <string_view>
+#include <thread>
 #include <utility>
 #include <vector>
 #include <sys/stat.h>
@@ -54,6 +55,7 @@
 #include "config/constants.hpp"
 #include "config/definitions.hpp"
 #include "config/definitions/categories.hpp"
+#include "config/sysfiles.hpp"
 #include "../core/core.hpp"
 #include "embedded/melondsds_default_wfc_config.h"
 #include "environment.hpp"
@@ -74,7 +76,6 @@
 
 using namespace melonDS;
 using std::array;
-using std::find_if;
 using std::from_chars;
 using std::from_chars_result;
 using std::initializer_list;
@@ -98,6 +99,10 @@ const char* const DEFAULT_DSI_SDCARD_DIR_NAME = "dsi_sd_card";
 const initializer_list<unsigned> CURSOR_TIMEOUTS = {1, 2, 3, 5, 10, 15, 20, 30, 60};
 const initializer_list<unsigned> DS_POWER_OK_THRESHOLDS = {0, 10, 20, 30, 40, 50, 60, 70, 80, 90, 100};
 const initializer_list<unsigned> POWER_UPDATE_INTERVALS = {1, 2, 3, 5, 10, 15, 20, 30, 60};
+const initializer_list<unsigned> BATTERY_SAVER_THRESHOLDS = {0, 10, 20, 30, 40, 50};
+const initializer_list<unsigned> INSTANT_BOOT_FRAMES = {0, 30, 60, 120, 300, 600, 1200};
+const initializer_list<unsigned> FRAMESKIP_THRESHOLDS = {15, 20, 25, 33, 40, 50, 60};
+const initializer_list<unsigned> MAX_CONSECUTIVE_FRAMESKIPS = {1, 2, 3, 4, 5, 6, 8, 10};
 const initializer_list<uint16_t> RUMBLE_INTENSITY_VALUES = {0, 6554, 13107, 19661, 26214, 32768, 39321, 45875, 52428, 58982, 65535};
 const initializer_list<int> RELATIVE_DAY_OFFSETS = {
     -364, -180, -150, -120, -90, -60, -30, -14, -13, -12, -11, -10, -9, -8, -7, -6, -5, -4, -3, -2, -1,
@@ -132,6 +137,49 @@ void MelonDsDs::ParseConfig(CoreConfig& config) noexcept {
     config::ParseNetworkOptions(config);
     config::ParseScreenOptions(config);
     config::ParseVideoOptions(config);
+
+    // Not exposed as an option yet, but the battery saver may have changed it
+    config.SetFlushDelay(config::DEFAULT_FLUSH_DELAY);
+
+    if (config.RollbackMode()) {
+        // If netplay may roll back and resimulate frames...
+        // ...then nothing the console sees can come from the host,
+        // since the host's clock, light sensor and microphone differ between peers and between replays.
+        if (config.StartTimeMode() == StartTimeMode::Sync) {
+            config.SetStartTimeMode(StartTimeMode::Real);
+        }
+
+        if (config.MicInputMode() == MicInputMode::HostMic) {
+            config.SetMicInputMode(MicInputMode::WhiteNoise);
+        }
+
+        config.SetUseRealLightSensor(false);
+    }
+}
+
+void MelonDsDs::ApplyBatterySaverProfile(CoreConfig& config) noexcept {
+    ZoneScopedN(TracyFunction);
+
+    // Rendering at native resolution is by far the biggest saving
+    config.SetScaleFactor(1);
+
+#ifdef HAVE_THREADED_RENDERER
+    if (std::thread::hardware_concurrency() <= 2) {
+        // If the rendering thread would compete with the emulation thread for a core...
+        config.SetThreadedSoftRenderer(false);
+    }
+#endif
+
+    // Write save data to disk a quarter as often
+    config.SetFlushDelay(config::BATTERY_SAVER_FLUSH_DELAY);
+
+    config.SetShowMicState(false);
+    config.SetShowCameraState(false);
+    config.SetShowCurrentLayout(false);
+    config.SetShowLidState(false);
+    config.SetShowSensorReading(false);
+    config.SetShowFrameskipStats(false);
+    config.SetShowPointerCoordinates(false);
 }
 
 static void MelonDsDs::config::ParseSystemOptions(CoreConfig& config) noexcept {
@@ -155,6 +203,13 @@ static void MelonDsDs::config::ParseSystemOptions(CoreConfig& config) noexcept {
         config.SetSlot2Device(Slot2Device::Auto);
     }
 
+    if (optional<bool> value = ParseBoolean(get_variable(storage::GBA_SAVE_COMPRESSION))) {
+        config.SetGbaSaveCompression(*value);
+    } else {
+        retro::warn("Failed to get value for {}; defaulting to {}", storage::GBA_SAVE_COMPRESSION, values::DISABLED);
+        config.SetGbaSaveCompression(false);
+    }
+
     if (optional<BootMode> value = ParseBootMode(get_variable(BOOT_MODE))) {
         config.SetBootMode(*value);
     } else {
@@ -191,6 +246,46 @@ static void MelonDsDs::config::ParseSystemOptions(CoreConfig& config) noexcept {
         retro::warn("Failed to get value for {}; defaulting to 15 seconds", BATTERY_UPDATE_INTERVAL);
         config.SetPowerUpdateInterval(15);
     }
+
+    if (optional<unsigned> value = ParseIntegerInList(get_variable(BATTERY_SAVER_THRESHOLD), BATTERY_SAVER_THRESHOLDS)) {
+        config.SetBatterySaverThreshold(*value);
+    }
+    else {
+        retro::warn("Failed to get value for {}; defaulting to disabled", BATTERY_SAVER_THRESHOLD);
+        config.SetBatterySaverThreshold(0);
+    }
+
+    if (optional<unsigned> value = ParseIntegerInList(get_variable(INSTANT_BOOT), INSTANT_BOOT_FRAMES)) {
+        config.SetInstantBootFrames(*value);
+    }
+    else {
+        retro::warn("Failed to get value for {}; defaulting to disabled", INSTANT_BOOT);
+        config.SetInstantBootFrames(0);
+    }
+
+    if (optional<bool> value = ParseBoolean(get_variable(ROLLBACK_MODE))) {
+        config.SetRollbackMode(*value);
+    }
+    else {
+        retro::warn("Failed to get value for {}; defaulting to {}", ROLLBACK_MODE, values::DISABLED);
+        config.SetRollbackMode(false);
+    }
+
+    if (optional<bool> value = ParseBoolean(get_variable(FRAME_PROFILE))) {
+        config.SetFrameProfile(*value);
+    }
+    else {
+        retro::warn("Failed to get value for {}; defaulting to {}", FRAME_PROFILE, values::DISABLED);
+        config.SetFrameProfile(false);
+    }
+
+    if (optional<bool> value = ParseBoolean(get_variable(VERIFY_SYSTEM_FILES))) {
+        config.SetVerifySystemFiles(*value);
+    }
+    else {
+        retro::warn("Failed to get value for {}; defaulting to {}", VERIFY_SYSTEM_FILES, values::DISABLED);
+        config.SetVerifySystemFiles(false);
+    }
 }
 
 void MelonDsDs::config::ParseTimeOptions(CoreConfig& config) noexcept {
@@ -343,6 +438,13 @@ void MelonDsDs::config::ParseOsdOptions(CoreConfig& config) noexcept {
         retro::warn("Failed to get value for {}; defaulting to {}", SENSOR_READING, definitions::ShowSensorReading.default_value);
         config.SetShowSensorReading(true);
     }
+
+    if (optional<bool> value = ParseBoolean(get_variable(osd::FRAMESKIP_STATS))) {
+        config.SetShowFrameskipStats(*value);
+    } else {
+        retro::warn("Failed to get value for {}; defaulting to {}", FRAMESKIP_STATS, values::DISABLED);
+        config.SetShowFrameskipStats(false);
+    }
 }
 
 static void MelonDsDs::config::ParseJitOptions(CoreConfig& config) noexcept {
@@ -392,6 +494,15 @@ static void MelonDsDs::config::ParseJitOptions(CoreConfig& config) noexcept {
     }
 #endif
 #endif
+
+#ifdef HAVE_HUGE_PAGES
+    if (optional<bool> value = ParseBoolean(retro::get_variable(cpu::HUGE_PAGES))) {
+        config.SetHugePages(*value);
+    } else {
+        retro::warn("Failed to get value for {}; defaulting to {}", cpu::HUGE_PAGES, values::DISABLED);
+        config.SetHugePages(false);
+    }
+#endif
 }
 
 static void MelonDsDs::config::ParseHomebrewSaveOptions(CoreConfig& config) noexcept {
@@ -468,6 +579,13 @@ static void MelonDsDs::config::ParseDsiStorageOptions(CoreConfig& config) noexce
         config.SetDsiSdEnable(true);
     }
 
+    if (optional<DsiwareInstallMode> value = ParseDsiwareInstallMode(get_variable(storage::DSIWARE_INSTALL_MODE))) {
+        config.SetDsiwareInstallMode(*value);
+    } else {
+        retro::warn("Failed to get value for {}; defaulting to {}", storage::DSIWARE_INSTALL_MODE, values::TEMPORARY);
+        config.SetDsiwareInstallMode(DsiwareInstallMode::Temporary);
+    }
+
     {
         optional<string> imagePath = retro::get_save_subdir_path(DEFAULT_DSI_SDCARD_IMAGE_NAME);
         config.SetDsiSdImagePath(std::move(*imagePath));
@@ -627,10 +745,17 @@ static void MelonDsDs::config::ParseAudioOptions(CoreConfig& config) noexcept {
 }
 
 static void MelonDsDs::config::ParseNetworkOptions(CoreConfig& config) noexcept {
-#ifdef HAVE_NETWORKING
     ZoneScopedN(TracyFunction);
     using retro::get_variable;
 
+    if (optional<bool> value = ParseBoolean(get_variable(network::MP_BATCHING))) {
+        config.SetMpBatching(*value);
+    } else {
+        retro::warn("Failed to get value for {}; defaulting to {}", network::MP_BATCHING, values::DISABLED);
+        config.SetMpBatching(false);
+    }
+
+#ifdef HAVE_NETWORKING
     if (optional<NetworkMode> value = ParseNetworkMode(get_variable(network::NETWORK_MODE))) {
         config.SetNetworkMode(*value);
     } else {
@@ -728,8 +853,49 @@ static void MelonDsDs::config::ParseVideoOptions(CoreConfig& config) noexcept {
         config.SetScreenFilter(*value);
     }
 
+#ifdef HAVE_THREADS
+    if (optional<bool> value = ParseBoolean(get_variable(THREADED_COMPOSITION))) {
+        config.SetThreadedComposition(*value);
+    } else {
+        retro::warn("Failed to get value for {}; defaulting to {}", THREADED_COMPOSITION, values::DISABLED);
+        config.SetThreadedComposition(false);
+    }
+#endif
+
+    if (optional<PixelFormat> value = ParsePixelFormat(get_variable(PIXEL_FORMAT))) {
+        config.SetPixelFormat(*value);
+    } else {
+        retro::warn("Failed to get value for {}; defaulting to {}", PIXEL_FORMAT, values::XRGB8888);
+        config.SetPixelFormat(PixelFormat::Xrgb8888);
+    }
+
+    if (optional<FrameskipMode> value = ParseFrameskipMode(get_variable(FRAMESKIP))) {
+        config.SetFrameskipMode(*value);
+    } else {
+        retro::warn("Failed to get value for {}; defaulting to {}", FRAMESKIP, values::DISABLED);
+        config.SetFrameskipMode(FrameskipMode::Disabled);
+    }
+
+    if (optional<unsigned> value = ParseIntegerInList(get_variable(FRAMESKIP_THRESHOLD), FRAMESKIP_THRESHOLDS)) {
+        config.SetFrameskipThreshold(*value);
+    } else {
+        retro::warn("Failed to get value for {}; defaulting to 33%", FRAMESKIP_THRESHOLD);
+        config.SetFrameskipThreshold(33);
+    }
+
+    if (optional<unsigned> value = ParseIntegerInList(get_variable(FRAMESKIP_MAX), MAX_CONSECUTIVE_FRAMESKIPS)) {
+        config.SetMaxConsecutiveFrameskips(*value);
+    } else {
+        retro::warn("Failed to get value for {}; defaulting to 3", FRAMESKIP_MAX);
+        config.SetMaxConsecutiveFrameskips(3);
+    }
+
 #if defined(HAVE_THREADS) && defined(HAVE_THREADED_RENDERER)
-    if (optional<bool> value = ParseBoolean(get_variable(THREADED_RENDERER))) {
+    if (get_variable(THREADED_RENDERER) == values::AUTO) {
+        unsigned cores = std::thread::hardware_concurrency();
+        retro::debug("{} threads available to the software renderer", cores);
+        config.SetThreadedSoftRenderer(cores > 2);
+    } else if (optional<bool> value = ParseBoolean(get_variable(THREADED_RENDERER))) {
         config.SetThreadedSoftRenderer(*value);
     } else {
         retro::warn("Failed to get value for {}; defaulting to {}", THREADED_RENDERER, values::ENABLED);
@@ -821,12 +987,23 @@ struct AdapterOption {
 
 // If I make an option depend on the game (e.g. different defaults for different games),
 // then I can have set_core_option accept a NDSHeader
+template<size_t N>
+static void ResetDynamicOptions(array<retro_core_option_v2_definition, N>& definitions) noexcept {
+    for (size_t i : MelonDsDs::config::definitions::DynamicOptionIndexes) {
+        definitions[i] = MelonDsDs::config::definitions::CoreOptionDefinitions[i];
+    }
+}
+
 bool MelonDsDs::RegisterCoreOptions() noexcept {
     ZoneScopedN(TracyFunction);
     using namespace MelonDsDs::config;
 
-    array categories = definitions::OptionCategories;
-    array definitions = definitions::CoreOptionDefinitions;
+    // These are constant-initialized, so registering the options doesn't copy the whole table onto the stack.
+    // Only the few entries listed in DynamicOptionIndexes are ever modified,
+    // and they're restored to their defaults once the frontend has the options.
+    static array categories = definitions::OptionCategories;
+    static array definitions = definitions::CoreOptionDefinitions;
+    ResetDynamicOptions(definitions);
 
     optional<string_view> subdir = retro::get_system_subdirectory();
 
@@ -840,20 +1017,28 @@ bool MelonDsDs::RegisterCoreOptions() noexcept {
         u8 headerBytes[sizeof(Firmware::FirmwareHeader)];
         Firmware::FirmwareHeader& header = *reinterpret_cast<Firmware::FirmwareHeader*>(headerBytes);
         memset(headerBytes, 0, sizeof(headerBytes));
+        SystemFileCache sysfileCache = SystemFileCache::Load();
         array paths = {*sysdir, *subdir};
         for (const string_view& path: paths) {
             ZoneScopedN("MelonDsDs::config::set_core_options::find_system_files::paths");
             for (const retro::dirent& d : retro::readdir(string(path), true)) {
                 ZoneScopedN("MelonDsDs::config::set_core_options::find_system_files::paths::dirent");
-                if (IsDsiNandImage(d)) {
-                    dsiNandPaths.emplace_back(d.path);
-                } else if (IsFirmwareImage(d, header)) {
-                    struct stat statbuf;
-                    stat(d.path, &statbuf);
-                    firmware.emplace_back(FirmwareEntry {d.path, header, statbuf});
+                switch (sysfileCache.Classify(d, header)) {
+                    case SystemFileType::DsiNand:
+                        dsiNandPaths.emplace_back(d.path);
+                        break;
+                    case SystemFileType::Firmware: {
+                        struct stat statbuf;
+                        stat(d.path, &statbuf);
+                        firmware.emplace_back(FirmwareEntry {d.path, header, statbuf});
+                        break;
+                    }
+                    default:
+                        break;
                 }
             }
         }
+        sysfileCache.Save();
 
     } else {
         retro::set_error_message("Failed to get system directory, anything that needs it won't work.");
@@ -862,11 +1047,8 @@ bool MelonDsDs::RegisterCoreOptions() noexcept {
     if (!dsiNandPaths.empty()) {
         ZoneScopedN("MelonDsDs::config::set_core_options::init_dsi_nand_options");
         // If we found at least one DSi NAND image...
-        retro_core_option_v2_definition* dsiNandPathOption = find_if(definitions.begin(), definitions.end(), [](const auto& def) {
-            return string_is_equal(def.key, MelonDsDs::config::storage::DSI_NAND_PATH);
-        });
-
-        retro_assert(dsiNandPathOption != definitions.end());
+        retro_core_option_v2_definition* dsiNandPathOption = &definitions[definitions::DsiNandPathIndex];
+        retro_assert(string_is_equal(dsiNandPathOption->key, storage::DSI_NAND_PATH));
 
         memset(dsiNandPathOption->values, 0, sizeof(dsiNandPathOption->values));
         int length = std::min((int)dsiNandPaths.size(), (int)RETRO_NUM_CORE_OPTION_VALUES_MAX - 1);
@@ -885,15 +1067,10 @@ bool MelonDsDs::RegisterCoreOptions() noexcept {
     if (!firmware.empty()) {
         ZoneScopedN("MelonDsDs::config::set_core_options::init_firmware_options");
         // If we found at least one firmware image...
-        retro_core_option_v2_definition* firmwarePathOption = find_if(definitions.begin(), definitions.end(), [](const auto& def) {
-            return string_is_equal(def.key, MelonDsDs::config::system::FIRMWARE_PATH);
-        });
-        retro_core_option_v2_definition* firmwarePathDsiOption = find_if(definitions.begin(), definitions.end(), [](const auto& def) {
-            return string_is_equal(def.key, MelonDsDs::config::system::FIRMWARE_DSI_PATH);
-        });
-
-        retro_assert(firmwarePathOption != definitions.end());
-        retro_assert(firmwarePathDsiOption != definitions.end());
+        retro_core_option_v2_definition* firmwarePathOption = &definitions[definitions::FirmwarePathIndex];
+        retro_core_option_v2_definition* firmwarePathDsiOption = &definitions[definitions::DsiFirmwarePathIndex];
+        retro_assert(string_is_equal(firmwarePathOption->key, system::FIRMWARE_PATH));
+        retro_assert(string_is_equal(firmwarePathDsiOption->key, system::FIRMWARE_DSI_PATH));
 
         int length = std::min((int)firmware.size(), (int)RETRO_NUM_CORE_OPTION_VALUES_MAX - 1);
         for (int i = 0; i < length; ++i) {
@@ -926,10 +1103,8 @@ bool MelonDsDs::RegisterCoreOptions() noexcept {
         ZoneScopedN("MelonDsDs::config::set_core_options::init_adapter_options");
         // If we successfully initialized PCap and got some adapters...
         vector<AdapterData> availableAdapters = pcap->GetAdapters();
-        retro_core_option_v2_definition* wifiAdapterOption = find_if(definitions.begin(), definitions.end(), [](const auto& def) {
-            return string_is_equal(def.key, MelonDsDs::config::network::DIRECT_NETWORK_INTERFACE);
-        });
-        retro_assert(wifiAdapterOption != definitions.end());
+        retro_core_option_v2_definition* wifiAdapterOption = &definitions[definitions::NetworkInterfaceIndex];
+        retro_assert(string_is_equal(wifiAdapterOption->key, network::DIRECT_NETWORK_INTERFACE));
 
         // Zero all option values except for the first (Automatic)
         memset(wifiAdapterOption->values + 1, 0, sizeof(retro_core_option_value) * (RETRO_NUM_CORE_OPTION_VALUES_MAX - 1));
@@ -984,7 +1159,12 @@ bool MelonDsDs::RegisterCoreOptions() noexcept {
     }
 #endif
 
-    if (!retro::set_core_options(optionsUs)) {
+    bool optionsSet = retro::set_core_options(optionsUs);
+
+    // The dynamic options point to strings that are about to go out of scope
+    ResetDynamicOptions(definitions);
+
+    if (!optionsSet) {
         retro::set_error_message("Failed to set core option definitions, functionality will be limited.");
         return false;
     }
@@ -60,6 +60,11 @@ namespace MelonDsDs {
 
     void ParseConfig(CoreConfig& config) noexcept;
 
+    /// Overrides the parsed configuration with cheaper settings
+    /// for when the host is running low on battery power.
+    /// Call ParseConfig to restore the user's own settings.
+    void ApplyBatterySaverProfile(CoreConfig& config) noexcept;
+
     bool RegisterCoreOptions() noexcept;
 
     using std::string;
@@ -149,6 +154,14 @@ namespace MelonDsDs {
 #   endif
 #endif
 
+#ifdef HAVE_HUGE_PAGES
+        [[nodiscard]] bool HugePages() const noexcept { return _hugePages; }
+        void SetHugePages(bool enable) noexcept { _hugePages = enable; }
+#endif
+
+        [[nodiscard]] bool MpBatching() const noexcept { return _mpBatching; }
+        void SetMpBatching(bool batching) noexcept { _mpBatching = batching; }
+
 #ifdef HAVE_NETWORKING
         [[nodiscard]] MelonDsDs::NetworkMode NetworkMode() const noexcept { return _networkMode; }
         void SetNetworkMode(MelonDsDs::NetworkMode mode) noexcept { _networkMode = mode; }
@@ -186,6 +199,9 @@ namespace MelonDsDs {
         [[nodiscard]] bool ShowSensorReading() const noexcept { return _showSensorReading; }
         void SetShowSensorReading(bool show) noexcept { _showSensorReading = show; }
 
+        [[nodiscard]] bool ShowFrameskipStats() const noexcept { return _showFrameskipStats; }
+        void SetShowFrameskipStats(bool show) noexcept { _showFrameskipStats = show; }
+
         [[nodiscard]] bool ShowLidState() const noexcept { return showLidState; }
         void SetShowLidState(bool show) noexcept { showLidState = show; }
 
@@ -235,6 +251,9 @@ namespace MelonDsDs {
         [[nodiscard]] bool DsiSdReadOnly() const noexcept { return _dsiSdReadOnly; }
         void SetDsiSdReadOnly(bool readOnly) noexcept { _dsiSdReadOnly = readOnly; }
 
+        [[nodiscard]] MelonDsDs::DsiwareInstallMode DsiwareInstallMode() const noexcept { return _dsiwareInstallMode; }
+        void SetDsiwareInstallMode(MelonDsDs::DsiwareInstallMode mode) noexcept { _dsiwareInstallMode = mode; }
+
         [[nodiscard]] string_view DsiSdImagePath() const noexcept { return _dsiSdImagePath; }
         void SetDsiSdImagePath(string_view path) noexcept { _dsiSdImagePath = path; }
         void SetDsiSdImagePath(string&& path) noexcept { _dsiSdImagePath = std::move(path); }
@@ -297,6 +316,27 @@ namespace MelonDsDs {
         [[nodiscard]] unsigned PowerUpdateInterval() const noexcept { return _powerUpdateInterval; }
         void SetPowerUpdateInterval(unsigned powerUpdateInterval) noexcept { _powerUpdateInterval = powerUpdateInterval; }
 
+        /// The battery percentage below which the battery saver profile is applied, or 0 if it's disabled.
+        [[nodiscard]] unsigned BatterySaverThreshold() const noexcept { return _batterySaverThreshold; }
+        void SetBatterySaverThreshold(unsigned batterySaverThreshold) noexcept { _batterySaverThreshold = batterySaverThreshold; }
+
+        /// The number of frames after boot at which an instant-boot snapshot is captured, or 0 if it's disabled.
+        [[nodiscard]] unsigned InstantBootFrames() const noexcept { return _instantBootFrames; }
+        void SetInstantBootFrames(unsigned instantBootFrames) noexcept { _instantBootFrames = instantBootFrames; }
+
+        /// If true, the emulated console only sees inputs that netplay synchronizes,
+        /// so that frames resimulated after a rollback play out exactly as before.
+        [[nodiscard]] bool RollbackMode() const noexcept { return _rollbackMode; }
+        void SetRollbackMode(bool enabled) noexcept { _rollbackMode = enabled; }
+
+        /// If true, the time taken to emulate each frame is recorded and logged when the game is unloaded.
+        [[nodiscard]] bool FrameProfile() const noexcept { return _frameProfile; }
+        void SetFrameProfile(bool enable) noexcept { _frameProfile = enable; }
+
+        /// If true, every system file is read and checked against its cached checksum once.
+        [[nodiscard]] bool VerifySystemFiles() const noexcept { return _verifySystemFiles; }
+        void SetVerifySystemFiles(bool enable) noexcept { _verifySystemFiles = enable; }
+
         // TODO: Allow these paths to be customized
         string_view Bios9Path() const noexcept { return "bios9.bin"; }
         string_view Bios7Path() const noexcept { return "bios7.bin"; }
@@ -338,6 +378,26 @@ namespace MelonDsDs {
         bool ThreadedSoftRenderer() const noexcept { return false; }
 #endif
 
+#ifdef HAVE_THREADS
+        [[nodiscard]] bool ThreadedComposition() const noexcept { return _threadedComposition; }
+        void SetThreadedComposition(bool threadedComposition) noexcept { _threadedComposition = threadedComposition; }
+#else
+        bool ThreadedComposition() const noexcept { return false; }
+#endif
+
+        [[nodiscard]] MelonDsDs::PixelFormat PixelFormat() const noexcept { return _pixelFormat; }
+        void SetPixelFormat(MelonDsDs::PixelFormat pixelFormat) noexcept { _pixelFormat = pixelFormat; }
+
+        [[nodiscard]] MelonDsDs::FrameskipMode FrameskipMode() const noexcept { return _frameskipMode; }
+        void SetFrameskipMode(MelonDsDs::FrameskipMode mode) noexcept { _frameskipMode = mode; }
+
+        /// The audio buffer occupancy (as a percentage) below which frames are skipped in Threshold mode.
+        [[nodiscard]] unsigned FrameskipThreshold() const noexcept { return _frameskipThreshold; }
+        void SetFrameskipThreshold(unsigned threshold) noexcept { _frameskipThreshold = threshold; }
+
+        [[nodiscard]] unsigned MaxConsecutiveFrameskips() const noexcept { return _maxConsecutiveFrameskips; }
+        void SetMaxConsecutiveFrameskips(unsigned max) noexcept { _maxConsecutiveFrameskips = max; }
+
         [[nodiscard]] MelonDsDs::ScreenFilter ScreenFilter() const noexcept { return _screenFilter; }
         void SetScreenFilter(MelonDsDs::ScreenFilter screenFilter) noexcept { _screenFilter = screenFilter; }
 
@@ -387,6 +447,9 @@ namespace MelonDsDs {
         [[nodiscard]] Slot2Device GetSlot2Device() const noexcept { return _slot2; }
         void SetSlot2Device(MelonDsDs::Slot2Device device) noexcept { _slot2 = device; }
 
+        [[nodiscard]] bool GbaSaveCompression() const noexcept { return _gbaSaveCompression; }
+        void SetGbaSaveCompression(bool compress) noexcept { _gbaSaveCompression = compress; }
+
         [[nodiscard]] bool UseRealLightSensor() const noexcept { return _useRealLightSensor; }
         void SetUseRealLightSensor(bool enabled) noexcept { _useRealLightSensor = enabled; }
     private:
@@ -407,6 +470,7 @@ namespace MelonDsDs {
         optional<melonDS::MacAddress> _macAddress;
         optional<melonDS::IpAddress> _dnsServer;
         MelonDsDs::Slot2Device _slot2 = *ParseSlot2Device(config::definitions::Slot2Device.default_value);
+        bool _gbaSaveCompression = false;
         bool _useRealLightSensor = *ParseBoolean(config::definitions::SolarSensorMode.default_value);
 #ifdef JIT_ENABLED
         bool _jitEnable;
@@ -416,8 +480,12 @@ namespace MelonDsDs {
 #   ifdef HAVE_JIT_FASTMEM
         bool _fastMemory;
 #   endif
+#endif
+#ifdef HAVE_HUGE_PAGES
+        bool _hugePages = false;
 #endif
 
+        bool _mpBatching = false;
 
 #ifdef HAVE_NETWORKING
         MelonDsDs::NetworkMode _networkMode;
@@ -437,6 +505,7 @@ namespace MelonDsDs {
         bool showCurrentLayout = true;
         bool showLidState = false;
         bool _showSensorReading = false;
+        bool _showFrameskipStats = false;
         bool showBrightnessState = false;
         bool _dldiEnable;
         bool _dldiFolderSync;
@@ -450,7 +519,8 @@ namespace MelonDsDs {
         bool _dsiSdReadOnly;
         string _dsiSdImagePath;
         uint64_t _dsiSdImageSize;
-        unsigned _flushDelay = 120; // TODO: Make configurable
+        MelonDsDs::DsiwareInstallMode _dsiwareInstallMode = MelonDsDs::DsiwareInstallMode::Temporary;
+        unsigned _flushDelay = config::DEFAULT_FLUSH_DELAY; // TODO: Make configurable
         unsigned _numberOfScreenLayouts = 1;
         std::array<ScreenLayout, config::screen::MAX_SCREEN_LAYOUTS> _screenLayouts;
         unsigned _screenGap = 0;
@@ -465,6 +535,11 @@ namespace MelonDsDs {
         MelonDsDs::SysfileMode _sysfileMode;
         unsigned _dsPowerOkayThreshold = 20;
         unsigned _powerUpdateInterval;
+        unsigned _batterySaverThreshold = 0;
+        unsigned _instantBootFrames = 0;
+        bool _rollbackMode = false;
+        bool _frameProfile = false;
+        bool _verifySystemFiles = false;
         string _firmwarePath;
         string _dsiFirmwarePath;
         string _dsiNandPath;
@@ -472,6 +547,11 @@ namespace MelonDsDs {
         bool _betterPolygonSplitting = false;
         RenderMode _configuredRenderer;
         bool _threadedSoftRenderer = false;
+        bool _threadedComposition = false;
+        MelonDsDs::PixelFormat _pixelFormat = MelonDsDs::PixelFormat::Xrgb8888;
+        MelonDsDs::FrameskipMode _frameskipMode = MelonDsDs::FrameskipMode::Disabled;
+        unsigned _frameskipThreshold = 33;
+        unsigned _maxConsecutiveFrameskips = 3;
         MelonDsDs::ScreenFilter _screenFilter;
         MelonDsDs::StartTimeMode _startTimeMode = *ParseStartTimeMode(config::definitions::StartTimeMode.default_value);
         years _relativeYearOffset {};
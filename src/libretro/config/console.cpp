@@ -26,6 +26,7 @@
 #include <NDS.h>
 #include <DSi.h>
 
+#include <encodings/crc32.h>
 #include <encodings/utf.h>
 #include <file/file_path.h>
 #include <retro_assert.h>
@@ -35,9 +36,13 @@
 #include <string/stdstring.h>
 
 #include "config.hpp"
+#include "core/core.hpp"
 #include "environment.hpp"
 #include "exceptions.hpp"
 #include "format.hpp"
+#ifdef HAVE_HUGE_PAGES
+#include "platform/hugepages.hpp"
+#endif
 #include "retro/file.hpp"
 #include "retro/http.hpp"
 #include "retro/info.hpp"
@@ -59,6 +64,7 @@ using melonDS::DSi_TMD::TitleMetadata;
 namespace MelonDsDs {
     const char *TMD_DIR_NAME = "tmd";
     const char* SENTINEL_NAME = "melon.dat";
+    const char* SENTINEL_TEMP_NAME = "melon.dat.tmp";
     constexpr uint32_t RSA256_SIGNATURE_TYPE = 16777472;
 
     static melonDS::NDSArgs GetNdsArgs(
@@ -71,8 +77,8 @@ namespace MelonDsDs {
     static melonDS::DSiArgs GetDSiArgs(const CoreConfig& config, const retro::GameInfo* ndsInfo);
     static void ApplyCommonArgs(const CoreConfig& config, melonDS::NDSArgs& args) noexcept;
     static unique_ptr<melonDS::NDSCart::CartCommon> LoadNdsCart(const CoreConfig& config, const retro::GameInfo& ndsInfo);
-    static unique_ptr<melonDS::GBACart::CartCommon> LoadGbaCart(const retro::GameInfo& gbaInfo, const retro::GameInfo* gbaSaveInfo);
-    static std::pair<unique_ptr<uint8_t[]>, size_t> LoadGbaSram(const retro::GameInfo& gbaSaveInfo);
+    static unique_ptr<melonDS::GBACart::CartCommon> LoadGbaCart(const retro::GameInfo& gbaInfo, const retro::GameInfo* gbaSaveInfo, CoreState& state);
+    static std::pair<unique_ptr<uint8_t[]>, size_t> LoadGbaSram(const retro::GameInfo& gbaSaveInfo, sram::SaveFileState& fileState);
     static void InstallDsiware(NANDMount& mount, const retro::GameInfo& nds_info);
     static void GetTmdPath(const retro::GameInfo &nds_info, std::span<char> buffer);
     static optional<TitleMetadata> GetCachedTmd(string_view tmdPath) noexcept;
@@ -141,14 +147,105 @@ std::unique_ptr<melonDS::NDS> MelonDsDs::CreateConsole(
                 "The DSi does not support GBA connectivity. Not loading the requested GBA ROM or SRAM."
             );
         }
-        return std::make_unique<melonDS::DSi>(GetDSiArgs(config, ndsInfo), &state);
+        std::unique_ptr<melonDS::NDS> nds = std::make_unique<melonDS::DSi>(GetDSiArgs(config, ndsInfo), &state);
+#ifdef HAVE_HUGE_PAGES
+        if (config.HugePages())
+            AdviseConsoleHugePages(*nds);
+#endif
+        return nds;
     }
     else {
         // If we're in DS mode...
-        return std::make_unique<melonDS::NDS>(GetNdsArgs(config, ndsInfo, gbaInfo, gbaSaveInfo, state), &state);
+        auto nds = std::make_unique<melonDS::NDS>(GetNdsArgs(config, ndsInfo, gbaInfo, gbaSaveInfo, state), &state);
+#ifdef HAVE_HUGE_PAGES
+        if (config.HugePages())
+            AdviseConsoleHugePages(*nds);
+#endif
+        return nds;
+    }
+}
+
+#ifdef HAVE_HUGE_PAGES
+void MelonDsDs::AdviseConsoleHugePages(const melonDS::NDS& nds) noexcept {
+    ZoneScopedN(TracyFunction);
+    switch (GetHugePageMode()) {
+        case HugePageMode::Unavailable:
+        case HugePageMode::Never:
+            retro::warn("Huge pages were requested, but this system doesn't provide transparent huge pages");
+            return;
+        case HugePageMode::Always:
+            retro::info("Transparent huge pages are always enabled on this system; advising anyway");
+            [[fallthrough]];
+        case HugePageMode::Madvise: {
+            // Only main RAM is advised; it's allocated separately from the console object,
+            // so advising it can't affect the heap memory around it
+            size_t advised = AdviseHugePages(nds.MainRAM, melonDS::MainRAMMaxSize);
+            if (advised > 0) {
+                retro::info("Requested huge pages for {} KiB of emulated memory", advised / 1024);
+            } else {
+                retro::warn("The kernel rejected the request for huge pages; using normal pages");
+            }
+            break;
+        }
     }
 }
 
+size_t MelonDsDs::GetConsoleHugePageBackedSize(const melonDS::NDS& nds) noexcept {
+    ZoneScopedN(TracyFunction);
+    return GetHugePageBackedSize(nds.MainRAM, melonDS::MainRAMMaxSize);
+}
+#endif
+
+bool MelonDsDs::ReuseConsole(
+    melonDS::NDS& nds,
+    CoreState& state,
+    const CoreConfig& config,
+    const retro::GameInfo* ndsInfo,
+    const retro::GameInfo* gbaInfo,
+    const retro::GameInfo* gbaSaveInfo
+) {
+    ZoneScopedN(TracyFunction);
+    const melonDS::NDSHeader* header = ndsInfo
+        ? reinterpret_cast<const melonDS::NDSHeader*>(ndsInfo->GetData().data())
+        : nullptr;
+
+    if (static_cast<ConsoleType>(nds.ConsoleType) != ConsoleType::DS || config.ConsoleType() != ConsoleType::DS || (header && header->IsDSiWare())) {
+        // If either the old or the new session involves a DSi...
+        // (whose NAND and SD card would need to be reopened anyway)
+        return false;
+    }
+
+    // Load and validate everything exactly as if we were creating a new console...
+    // (the BIOS and firmware are read from disk again rather than kept from the last session,
+    // since the player may have replaced them and the firmware's user settings are saved as the game runs)
+    melonDS::NDSArgs args = GetNdsArgs(config, ndsInfo, gbaInfo, gbaSaveInfo, state);
+
+    // ...then install it all into the existing one.
+    nds.SetARM9BIOS(*args.ARM9BIOS);
+    nds.SetARM7BIOS(*args.ARM7BIOS);
+    nds.SetFirmware(std::move(args.Firmware));
+
+    if (args.NDSROM) {
+        nds.SetNDSCart(std::move(args.NDSROM));
+    } else {
+        nds.EjectCart();
+    }
+
+    if (args.GBAROM) {
+        nds.SetGBACart(std::move(args.GBAROM));
+    } else {
+        nds.EjectGBACart();
+    }
+
+#ifdef JIT_ENABLED
+    nds.SetJITArgs(args.JIT);
+#endif
+    nds.SPU.SetInterpolation(args.Interpolation);
+    nds.SPU.SetDegrade10Bit(args.BitDepth);
+
+    return true;
+}
+
 void MelonDsDs::UpdateConsole(const CoreConfig& config, melonDS::NDS& nds) noexcept {
     ZoneScopedN(TracyFunction);
 
@@ -266,7 +363,7 @@ static melonDS::NDSArgs MelonDsDs::GetNdsArgs(
 
     if (gbaInfo) {
         // If loading a specific GBA ROM, then ignore the expansion paks
-        ndsargs.GBAROM = LoadGbaCart(*gbaInfo, gbaSaveInfo);
+        ndsargs.GBAROM = LoadGbaCart(*gbaInfo, gbaSaveInfo, state);
     } else {
         switch (config.GetSlot2Device()) {
             case Slot2Device::MemoryExpansionPak:
@@ -390,7 +487,7 @@ static melonDS::DSiArgs MelonDsDs::GetDSiArgs(const CoreConfig& config, const re
 
         if (ndsInfo && ndsRom != nullptr && ndsRom->GetHeader().IsDSiWare()) {
             // If we're trying to play a DSiWare game...
-            InstallDsiware(mount, *ndsInfo); // Temporarily install the game on the NAND
+            InstallDsiware(mount, *ndsInfo); // Install the game on the NAND (or reuse an earlier install)
             ndsRom = nullptr; // Don't want to insert the DSiWare into the cart slot
         }
     }
@@ -419,7 +516,14 @@ static void MelonDsDs::ApplyCommonArgs(const CoreConfig& config, melonDS::NDSArg
     args.Interpolation = config.Interpolation();
     args.BitDepth = config.BitDepth();
 #ifdef JIT_ENABLED
-    if (config.JitEnable()) {
+    if (config.JitEnable() && retro::is_jit_capable() == false) {
+        // If the frontend says we can't map executable memory (e.g. W^X is enforced)...
+        // ...then use the interpreter instead of crashing on the first compiled block.
+        // TODO: Offer a cached-decode interpreter here once melonDS's ARM core has one
+        retro::warn("Frontend reports that JIT isn't available in this process; falling back to the interpreter");
+        args.JIT = std::nullopt;
+    }
+    else if (config.JitEnable()) {
         args.JIT = {
             .MaxBlockSize = config.MaxBlockSize(),
             .LiteralOptimizations = config.LiteralOptimizations(),
@@ -484,16 +588,19 @@ static unique_ptr<melonDS::NDSCart::CartCommon> MelonDsDs::LoadNdsCart(const Cor
 
 static unique_ptr<melonDS::GBACart::CartCommon> MelonDsDs::LoadGbaCart(
     const retro::GameInfo& gbaInfo,
-    const retro::GameInfo* gbaSaveInfo
+    const retro::GameInfo* gbaSaveInfo,
+    CoreState& state
 ) {
     ZoneScopedN(TracyFunction);
 
     unique_ptr<uint8_t[]> sram;
     size_t sramSize = 0;
     if (gbaSaveInfo) {
-        auto result = LoadGbaSram(*gbaSaveInfo);
+        sram::SaveFileState fileState;
+        auto result = LoadGbaSram(*gbaSaveInfo, fileState);
         sram = std::move(result.first);
         sramSize = result.second;
+        state.SetGbaSaveFileState(fileState);
     }
     span<const std::byte> gbaRom = gbaInfo.GetData();
 
@@ -517,7 +624,7 @@ static unique_ptr<melonDS::GBACart::CartCommon> MelonDsDs::LoadGbaCart(
     return cart;
 }
 
-static std::pair<unique_ptr<uint8_t[]>, size_t> MelonDsDs::LoadGbaSram(const retro::GameInfo& gbaSaveInfo) {
+static std::pair<unique_ptr<uint8_t[]>, size_t> MelonDsDs::LoadGbaSram(const retro::GameInfo& gbaSaveInfo, sram::SaveFileState& fileState) {
     ZoneScopedN(TracyFunction);
     // We load the GBA SRAM file ourselves (rather than letting the frontend do it)
     // because we'll overwrite it later and don't want the frontend to hold open any file handles.
@@ -544,21 +651,10 @@ static std::pair<unique_ptr<uint8_t[]>, size_t> MelonDsDs::LoadGbaSram(const ret
         throw std::runtime_error("Failed to open GBA save file");
     }
 
-    if (rzipstream_is_compressed(gba_save_file)) {
-        // If this save data is compressed in libretro's rzip format...
-        // (not to be confused with a standard archive format like zip or 7z)
-
-        // We don't support rzip-compressed GBA save files right now;
-        // I can't be bothered.
-        retro::set_error_message(
-            "melonDS DS does not support compressed GBA save data right now. "
-            "Please disable save data compression in the frontend and try again. "
-            "Continuing without using the save data."
-        );
-
-        rzipstream_close(gba_save_file);
-        return { nullptr, 0 };
-    }
+    // If this save data is compressed in libretro's rzip format,
+    // (not to be confused with a standard archive format like zip or 7z)
+    // then rzipstream decompresses it as we read it.
+    bool compressed = rzipstream_is_compressed(gba_save_file);
 
     int64_t gba_save_file_size = rzipstream_get_size(gba_save_file);
     if (gba_save_file_size < 0) {
@@ -574,55 +670,115 @@ static std::pair<unique_ptr<uint8_t[]>, size_t> MelonDsDs::LoadGbaSram(const ret
         throw std::runtime_error("Failed to read GBA save file");
     }
 
-    retro::debug("Loaded {}-byte GBA SRAM from {}.", gba_save_file_size, gbaSaveInfo.GetPath());
+    // Remember what we loaded, so the first flush can skip writing it back unchanged
+    fileState = { encoding_crc32(0, gba_save_data.get(), gba_save_file_size), compressed };
+
+    retro::debug("Loaded {}-byte {}GBA SRAM from {}.", gba_save_file_size, compressed ? "compressed " : "", gbaSaveInfo.GetPath());
     return {std::move(gba_save_data), gba_save_file_size};
 }
 
 void MelonDsDs::InstallDsiware(NANDMount& mount, const retro::GameInfo& nds_info) {
     ZoneScopedN(TracyFunction);
     std::string_view path = nds_info.GetPath();
-    retro::info("Temporarily installing DSiWare title \"{}\" onto DSi NAND image", path);
+    retro::info("Installing DSiWare title \"{}\" onto DSi NAND image", path);
     auto data = nds_info.GetData();
     const NDSHeader &header = *reinterpret_cast<const NDSHeader*>(data.data());
     retro_assert(header.IsDSiWare());
 
+    string fingerprint = GetDsiwareFingerprint(nds_info);
     if (mount.TitleExists(header.DSiTitleIDHigh, header.DSiTitleIDLow)) {
-        retro::info("Title \"{}\" already exists on loaded NAND; skipping installation, and won't uninstall it later.", path);
+        optional<string> sentinel = ReadDsiwareSentinel(mount, header);
+        if (!sentinel) {
+            // If the title was put on the NAND by something other than this core...
+            retro::info("Title \"{}\" already exists on loaded NAND; skipping installation, and won't uninstall it later.", path);
+            return;
+        }
 
-    } else {
-        retro::info("Title \"{}\" is not on loaded NAND; will install it for the duration of this session.", path);
+        if (*sentinel == fingerprint) {
+            // If we installed this exact ROM in an earlier session and left it there...
+            retro::info("Title \"{}\" is already installed on loaded NAND; only importing its save data.", path);
+            ImportDsiwareSaveData(mount, nds_info, header, TitleData_PublicSav);
+            ImportDsiwareSaveData(mount, nds_info, header, TitleData_PrivateSav);
+            ImportDsiwareSaveData(mount, nds_info, header, TitleData_BannerSav);
+            return;
+        }
+
+        // The title was installed from a different ROM (or by an older version of this core)
+        retro::info("Title \"{}\" on loaded NAND doesn't match this ROM; reinstalling it.", path);
+        mount.DeleteTitle(header.DSiTitleIDHigh, header.DSiTitleIDLow);
+    }
+
+    retro::info("Title \"{}\" is not on loaded NAND; installing it.", path);
 
-        char tmd_path[PATH_MAX];
-        GetTmdPath(nds_info, tmd_path);
+    char tmd_path[PATH_MAX];
+    GetTmdPath(nds_info, tmd_path);
 
-        optional<TitleMetadata> tmd = GetCachedTmd(tmd_path);
+    optional<TitleMetadata> tmd = GetCachedTmd(tmd_path);
 
-        if (!tmd) {
-            // If the TMD isn't available locally...
+    if (!tmd) {
+        // If the TMD isn't available locally...
 
 #ifdef HAVE_NETWORKING
-            if (tmd = DownloadTmd(header, tmd_path); !tmd) {
-                // ...then download it and save it to disk. If that didn't work...
-                throw missing_metadata_exception("Cannot get title metadata for installation");
-            }
+        if (tmd = DownloadTmd(header, tmd_path); !tmd) {
+            // ...then download it and save it to disk. If that didn't work...
+            throw missing_metadata_exception("Cannot get title metadata for installation");
+        }
 #else
-            throw missing_metadata_exception("Cannot get title metadata for installation, and this build does not support downloading it");
+        throw missing_metadata_exception("Cannot get title metadata for installation, and this build does not support downloading it");
 #endif
-        }
+    }
 
-        if (!mount.ImportTitle(reinterpret_cast<const uint8_t*>(data.data()), data.size(), *tmd, false)) {
-            throw emulator_exception("Failed to import DSiWare title into NAND image");
-        }
+    if (!mount.ImportTitle(reinterpret_cast<const uint8_t*>(data.data()), data.size(), *tmd, false)) {
+        throw emulator_exception("Failed to import DSiWare title into NAND image");
+    }
+
+    ImportDsiwareSaveData(mount, nds_info, header, TitleData_PublicSav);
+    ImportDsiwareSaveData(mount, nds_info, header, TitleData_PrivateSav);
+    ImportDsiwareSaveData(mount, nds_info, header, TitleData_BannerSav);
+
+    auto sentinel = fmt::format("0:/title/{:08x}/{:08x}/data/{}", header.DSiTitleIDHigh, header.DSiTitleIDLow, SENTINEL_NAME);
+    mount.RemoveFile(sentinel.c_str());
+    mount.ImportFile(sentinel.c_str(), reinterpret_cast<const uint8_t*>(fingerprint.data()), fingerprint.size());
+}
+
+std::string MelonDsDs::GetDsiwareFingerprint(const retro::GameInfo& nds_info) noexcept {
+    ZoneScopedN(TracyFunction);
+    auto data = nds_info.GetData();
+    uint32_t crc = encoding_crc32(0, reinterpret_cast<const uint8_t*>(data.data()), data.size());
+
+    return fmt::format("{:08x}-{}", crc, data.size());
+}
+
+optional<std::string> MelonDsDs::ReadDsiwareSentinel(NANDMount& mount, const NDSHeader& header) noexcept {
+    ZoneScopedN(TracyFunction);
+    auto sentinel = fmt::format("0:/title/{:08x}/{:08x}/data/{}", header.DSiTitleIDHigh, header.DSiTitleIDLow, SENTINEL_NAME);
 
-        ImportDsiwareSaveData(mount, nds_info, header, TitleData_PublicSav);
-        ImportDsiwareSaveData(mount, nds_info, header, TitleData_PrivateSav);
-        ImportDsiwareSaveData(mount, nds_info, header, TitleData_BannerSav);
+    // NANDMount can only export files to the host, so the sentinel takes a short trip through a temporary file
+    optional<string> tempPath = retro::get_system_subdir_path(SENTINEL_TEMP_NAME);
+    if (!tempPath) {
+        retro::warn("Failed to get the system directory, can't check for {}", sentinel);
+        return nullopt;
+    }
+
+    optional<string> contents;
+    if (mount.ExportFile(sentinel.c_str(), *tempPath)) {
+        // If the sentinel is there...
+        void* buffer = nullptr;
+        int64_t length = 0;
+        if (filestream_read_file(tempPath->c_str(), &buffer, &length) && buffer) {
+            contents = string(static_cast<const char*>(buffer), length);
+        } else {
+            retro::warn("Failed to read {} after exporting it from the NAND image", sentinel);
+        }
+        free(buffer);
+    }
 
-        uint8_t zero = 0;
-        auto sentinel = fmt::format("0:/title/{:08x}/{:08x}/data/{}", header.DSiTitleIDHigh, header.DSiTitleIDLow, SENTINEL_NAME);
-        mount.RemoveFile(sentinel.c_str());
-        mount.ImportFile(sentinel.c_str(), &zero, sizeof(zero));
+    // ExportFile may have created the file even if it failed partway
+    if (path_is_valid(tempPath->c_str())) {
+        filestream_delete(tempPath->c_str());
     }
+
+    return contents;
 }
 
 static void MelonDsDs::GetTmdPath(const retro::GameInfo &nds_info, std::span<char> buffer) {
@@ -1210,6 +1366,7 @@ static void MelonDsDs::CustomizeNAND(const CoreConfig& config, NANDMount& mount,
     if (!mount.ReadUserData(settings)) {
         throw emulator_exception("Failed to read user data from NAND image");
     }
+    const DSiFirmwareSystemSettings originalSettings = settings;
 
     // Right now, I only modify the user data with the firmware overrides defined by core options
     // If there are any problems, I may want to completely synchronize the user data and firmware myself.
@@ -1306,6 +1463,13 @@ static void MelonDsDs::CustomizeNAND(const CoreConfig& config, NANDMount& mount,
 
     settings.UpdateHash();
 
+    if (memcmp(&settings, &originalSettings, sizeof(settings)) == 0) {
+        // If the NAND's user data already matches what we'd write (e.g. the options haven't changed since last boot)...
+        // ...then don't re-encrypt and rewrite both copies of it.
+        retro::debug("NAND user data is already up-to-date; not rewriting it");
+        return;
+    }
+
     if (!mount.ApplyUserData(settings)) {
         throw emulator_exception("Failed to write user data to NAND image");
     }
@@ -1321,4 +1485,4 @@ static optional<melonDS::FATStorage> MelonDsDs::LoadDSiSDCardImage(const CoreCon
         config.DsiSdReadOnly(),
         config.DsiSdFolderSync() ? make_optional(string(config.DsiSdFolderPath())) : nullopt
     );
-}
\ No newline at end of file
+}
@@ -18,10 +18,17 @@
 #define MELONDSDS_CONFIG_CONSOLE_HPP
 
 #include <memory>
+#include <optional>
+#include <string>
 #include "std/span.hpp"
 
 namespace melonDS {
     class NDS;
+    struct NDSHeader;
+
+    namespace DSi_NAND {
+        class NANDMount;
+    }
 }
 
 namespace retro {
@@ -41,6 +48,28 @@ namespace MelonDsDs {
         const retro::GameInfo* gbaSaveInfo
     );
 
+    /// Swaps the given content and system files into a console left over from an earlier session,
+    /// so that the console (and its JIT and renderer) doesn't have to be rebuilt.
+    /// Returns false (leaving the console untouched) if the console can't be reused,
+    /// e.g. because the new content needs a different console type.
+    /// Throws the same exceptions as CreateConsole.
+    bool ReuseConsole(
+        melonDS::NDS& nds,
+        CoreState& state,
+        const CoreConfig& config,
+        const retro::GameInfo* ndsInfo,
+        const retro::GameInfo* gbaInfo,
+        const retro::GameInfo* gbaSaveInfo
+    );
+
+#ifdef HAVE_HUGE_PAGES
+    /// Asks the host to back the console's main RAM with huge pages.
+    void AdviseConsoleHugePages(const melonDS::NDS& nds) noexcept;
+
+    /// Returns how much of the console's main RAM is actually backed by huge pages.
+    [[nodiscard]] size_t GetConsoleHugePageBackedSize(const melonDS::NDS& nds) noexcept;
+#endif
+
     /// Modify a console instance with core options that are safe to adjust at runtime.
     void UpdateConsole(const CoreConfig& config, melonDS::NDS& nds) noexcept;
 
@@ -48,6 +77,14 @@ namespace MelonDsDs {
     void ResetConsole(const CoreConfig& config, melonDS::NDS& nds);
 
     bool GetDsiwareSaveDataHostPath(std::span<char> buffer, const retro::GameInfo& nds_info, int type) noexcept;
+
+    /// Identifies the exact DSiWare ROM that the core installed onto the NAND,
+    /// so that an unchanged title can be reused instead of being imported again.
+    std::string GetDsiwareFingerprint(const retro::GameInfo& nds_info) noexcept;
+
+    /// Returns the contents of the sentinel file that the core leaves in the titles it installs,
+    /// or \c std::nullopt if the given title wasn't installed by the core.
+    std::optional<std::string> ReadDsiwareSentinel(melonDS::DSi_NAND::NANDMount& mount, const melonDS::NDSHeader& header) noexcept;
 }
 
 #endif // MELONDSDS_CONFIG_CONSOLE_HPP
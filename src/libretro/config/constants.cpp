@@ -37,7 +37,7 @@ using std::string;
 using namespace melonDS;
 
 // We verify the filesize of the NAND image and the presence of the no$gba footer (since melonDS needs it)
-bool MelonDsDs::config::IsDsiNandImage(const retro::dirent &file) noexcept {
+bool MelonDsDs::config::IsDsiNandImage(const retro::dirent &file, uint64_t* consoleId) noexcept {
     ZoneScopedN(TracyFunction);
     ZoneText(file.path, strnlen(file.path, sizeof(file.path)));
 
@@ -84,11 +84,15 @@ bool MelonDsDs::config::IsDsiNandImage(const retro::dirent &file) noexcept {
 
     if (memcmp(footer.data(), NOCASH_FOOTER_MAGIC, NOCASH_FOOTER_MAGIC_SIZE) == 0) {
         // If the no$gba footer is present at the end of the file and correctly starts with the magic bytes...
+        if (consoleId)
+            memcpy(consoleId, footer.data() + NOCASH_FOOTER_CONSOLE_ID_OFFSET, sizeof(*consoleId));
         return true;
     }
 
     if (memcmp(unusedArea.data(), NOCASH_FOOTER_MAGIC, NOCASH_FOOTER_MAGIC_SIZE) == 0) {
         // If the no$gba footer is present in a normally-unused section of the DSi NAND, and it starts with the magic bytes...
+        if (consoleId)
+            memcpy(consoleId, unusedArea.data() + NOCASH_FOOTER_CONSOLE_ID_OFFSET, sizeof(*consoleId));
         return true;
     }
 
@@ -20,6 +20,7 @@
 
 #include <array>
 #include <charconv>
+#include <cstdint>
 #include <cstring>
 #include <system_error>
 #include <SPI_Firmware.h>
@@ -39,6 +40,10 @@ namespace retro {
 namespace MelonDsDs::config {
     constexpr unsigned DS_NAME_LIMIT = 10;
 
+    // How many frames to wait after the last write before flushing GBA SRAM or firmware to disk
+    constexpr unsigned DEFAULT_FLUSH_DELAY = 120;
+    constexpr unsigned BATTERY_SAVER_FLUSH_DELAY = DEFAULT_FLUSH_DELAY * 4;
+
     namespace audio {
         static constexpr const char *const CATEGORY = "audio";
         static constexpr const char *const AUDIO_BITDEPTH = "melonds_audio_bitdepth";
@@ -49,6 +54,7 @@ namespace MelonDsDs::config {
 
     namespace cpu {
         static constexpr const char* const CATEGORY = "cpu";
+        static constexpr const char *const HUGE_PAGES = "melonds_huge_pages";
         static constexpr const char *const JIT_BLOCK_SIZE = "melonds_jit_block_size";
         static constexpr const char *const JIT_BRANCH_OPTIMISATIONS = "melonds_jit_branch_optimisations";
         static constexpr const char *const JIT_ENABLE = "melonds_jit_enable";
@@ -73,6 +79,7 @@ namespace MelonDsDs::config {
         static constexpr const char *const CATEGORY = "network";
         static constexpr const char *const NETWORK_MODE = "melonds_network_mode";
         static constexpr const char *const DIRECT_NETWORK_INTERFACE = "melonds_direct_network_interface";
+        static constexpr const char *const MP_BATCHING = "melonds_mp_batching";
     }
 
     namespace osd {
@@ -86,6 +93,7 @@ namespace MelonDsDs::config {
         static constexpr const char *const LID_STATE = "melonds_show_lid_state";
         static constexpr const char *const SENSOR_READING = "melonds_show_sensor_reading";
         static constexpr const char *const BRIGHTNESS_STATE = "melonds_show_brightness_state";
+        static constexpr const char *const FRAMESKIP_STATS = "melonds_show_frameskip_stats";
     }
 
     namespace screen {
@@ -123,17 +131,22 @@ namespace MelonDsDs::config {
     namespace system {
         static constexpr const char *const CATEGORY = "system";
         static constexpr const char *const BATTERY_UPDATE_INTERVAL = "melonds_battery_update_interval";
+        static constexpr const char *const BATTERY_SAVER_THRESHOLD = "melonds_battery_saver_threshold";
         static constexpr const char *const BOOT_MODE = "melonds_boot_mode";
         static constexpr const char *const CONSOLE_MODE = "melonds_console_mode";
         static constexpr const char *const DS_POWER_OK = "melonds_ds_battery_ok_threshold";
         static constexpr const char *const FIRMWARE_PATH = "melonds_firmware_nds_path";
         static constexpr const char *const FIRMWARE_DSI_PATH = "melonds_firmware_dsi_path";
+        static constexpr const char *const FRAME_PROFILE = "melonds_frame_profile";
+        static constexpr const char *const INSTANT_BOOT = "melonds_instant_boot";
         static constexpr const char *const OVERRIDE_FIRMWARE_SETTINGS = "melonds_override_fw_settings";
+        static constexpr const char *const ROLLBACK_MODE = "melonds_rollback_mode";
         static constexpr const char *const RUMBLE_INTENSITY = "melonds_rumble_intensity";
         static constexpr const char *const RUMBLE_TYPE = "melonds_rumble_type";
         static constexpr const char *const SLOT2_DEVICE = "melonds_slot2_device";
         static constexpr const char *const SOLAR_SENSOR_HOST_SENSOR = "melonds_solar_sensor_host_sensor";
         static constexpr const char *const SYSFILE_MODE = "melonds_sysfile_mode";
+        static constexpr const char *const VERIFY_SYSTEM_FILES = "melonds_verify_system_files";
     }
 
     namespace storage {
@@ -141,7 +154,9 @@ namespace MelonDsDs::config {
         static constexpr const char *const DSI_SD_SAVE_MODE = "melonds_dsi_sdcard";
         static constexpr const char *const DSI_SD_SYNC_TO_HOST = "melonds_dsi_sdcard_sync_sdcard_to_host";
         static constexpr const char *const DSI_NAND_PATH = "melonds_dsi_nand_path";
+        static constexpr const char *const DSIWARE_INSTALL_MODE = "melonds_dsiware_install_mode";
         static constexpr const char *const GBA_FLUSH_DELAY = "melonds_gba_flush_delay";
+        static constexpr const char *const GBA_SAVE_COMPRESSION = "melonds_gba_save_compression";
         static constexpr const char *const HOMEBREW_READ_ONLY = "melonds_homebrew_readonly";
         static constexpr const char *const HOMEBREW_SAVE_MODE = "melonds_homebrew_sdcard";
         static constexpr const char *const HOMEBREW_SYNC_TO_HOST = "melonds_homebrew_sync_sdcard_to_host";
@@ -166,10 +181,15 @@ namespace MelonDsDs::config {
         constexpr unsigned INITIAL_MAX_OPENGL_SCALE = 4;
         constexpr unsigned MAX_OPENGL_SCALE = 8;
         static constexpr const char *const CATEGORY = "video";
+        static constexpr const char *const FRAMESKIP = "melonds_frameskip";
+        static constexpr const char *const FRAMESKIP_MAX = "melonds_frameskip_max";
+        static constexpr const char *const FRAMESKIP_THRESHOLD = "melonds_frameskip_threshold";
         static constexpr const char *const OPENGL_BETTER_POLYGONS = "melonds_opengl_better_polygons";
         static constexpr const char *const OPENGL_FILTERING = "melonds_opengl_filtering";
         static constexpr const char *const OPENGL_RESOLUTION = "melonds_opengl_resolution";
+        static constexpr const char *const PIXEL_FORMAT = "melonds_pixel_format";
         static constexpr const char *const RENDER_MODE = "melonds_render_mode";
+        static constexpr const char *const THREADED_COMPOSITION = "melonds_threaded_composition";
         static constexpr const char *const THREADED_RENDERER = "melonds_threaded_renderer";
     }
 
@@ -235,8 +255,10 @@ namespace MelonDsDs::config {
         static constexpr const char *const NOT_FOUND = "/notfound";
         static constexpr const char *const ONE = "one";
         static constexpr const char *const OPENGL = "opengl";
+        static constexpr const char *const PERSISTENT = "persistent";
         static constexpr const char *const REAL = "real";
         static constexpr const char *const RELATIVE_TIME = "relative";
+        static constexpr const char *const RGB565 = "rgb565";
         static constexpr const char *const RIGHT_LEFT = "right-left";
         static constexpr const char *const ROTATE_LEFT = "rotate-left";
         static constexpr const char *const ROTATE_RIGHT = "rotate-right";
@@ -249,6 +271,8 @@ namespace MelonDsDs::config {
         static constexpr const char *const START = "start";
         static constexpr const char *const STRONG = "strong";
         static constexpr const char *const SYNC = "sync";
+        static constexpr const char *const TEMPORARY = "temporary";
+        static constexpr const char *const THRESHOLD = "threshold";
         static constexpr const char *const TIMEOUT = "timeout";
         static constexpr const char *const TOGGLE = "toggle";
         static constexpr const char *const TOP_BOTTOM = "top-bottom";
@@ -257,6 +281,7 @@ namespace MelonDsDs::config {
         static constexpr const char *const TOUCHING = "touching";
         static constexpr const char *const UPSIDE_DOWN = "rotate-180";
         static constexpr const char *const WEAK = "weak";
+        static constexpr const char *const XRGB8888 = "xrgb8888";
     }
 
     constexpr size_t NOCASH_FOOTER_SIZE = 0x40;
@@ -264,9 +289,12 @@ namespace MelonDsDs::config {
     constexpr std::array<size_t, 2> DSI_NAND_SIZES_NOFOOTER = { 0xF000000, 0xF580000 }; // Taken from GBATek
     constexpr const char *const NOCASH_FOOTER_MAGIC = "DSi eMMC CID/CPU";
     constexpr size_t NOCASH_FOOTER_MAGIC_SIZE = 16;
+    constexpr size_t NOCASH_FOOTER_CONSOLE_ID_OFFSET = 0x20; // after the magic bytes and the eMMC CID
     constexpr std::array<size_t, 3> FIRMWARE_SIZES = { 131072, 262144, 524288 };
 
-    bool IsDsiNandImage(const retro::dirent &file) noexcept;
+    /// If consoleId isn't null and the file is a DSi NAND image,
+    /// it's set to the console ID stored in the image's no$gba footer.
+    bool IsDsiNandImage(const retro::dirent &file, uint64_t* consoleId = nullptr) noexcept;
     bool IsFirmwareImage(const retro::dirent &file, melonDS::Firmware::FirmwareHeader& header) noexcept;
 
     // Source: https://github.com/DS-Homebrew/TWiLightMenu/blob/a836b7d30b3582d57af848dde2277ded9dfe3a50/romsel_r4theme/arm9/source/graphics/uvcoord_small_font.h#L451-L461
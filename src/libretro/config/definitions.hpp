@@ -18,9 +18,11 @@
 #define MELONDS_DS_DEFINITIONS_HPP
 
 #include <array>
+#include <string_view>
 
 #include <libretro.h>
 
+#include "config/definitions/categories.hpp"
 #include "config/definitions/audio.hpp"
 #include "config/definitions/cpu.hpp"
 #include "config/definitions/firmware.hpp"
@@ -49,6 +51,9 @@ namespace MelonDsDs::config::definitions {
         JitFastMemory,
 #   endif
 #endif
+#ifdef HAVE_HUGE_PAGES
+        HugePages,
+#endif
 
 #ifdef HAVE_NETWORKING
         NetworkMode,
@@ -56,6 +61,7 @@ namespace MelonDsDs::config::definitions {
         NetworkInterface,
 #   endif
 #endif
+        MpBatching,
 
         ShowCursor,
         CursorTimeout,
@@ -85,20 +91,27 @@ namespace MelonDsDs::config::definitions {
 
         ConsoleMode,
         Slot2Device,
+        GbaSaveCompression,
         SolarSensorMode,
         SysfileMode,
         FirmwarePath,
         DsiFirmwarePath,
         NandPath,
+        VerifySystemFiles,
         BootMode,
         DsiSdCardSaveMode,
         DsiSdCardReadOnly,
         DsiSdCardSyncToHost,
+        DsiwareInstallMode,
         HomebrewSdCard,
         HomebrewSdCardReadOnly,
         HomebrewSdCardSyncToHost,
         BatteryUpdateInterval,
         NdsPowerOkThreshold,
+        BatterySaverThreshold,
+        InstantBoot,
+        RollbackMode,
+        FrameProfile,
 
         StartTimeMode,
         RelativeYearOffset,
@@ -120,6 +133,13 @@ namespace MelonDsDs::config::definitions {
 #if defined(HAVE_THREADS) && defined(HAVE_THREADED_RENDERER)
         ThreadedSoftwareRenderer,
 #endif
+#ifdef HAVE_THREADS
+        ThreadedComposition,
+#endif
+        PixelFormat,
+        Frameskip,
+        FrameskipThreshold,
+        FrameskipMax,
 
         ShowUnsupportedFeatures,
         ShowBiosWarnings,
@@ -128,6 +148,7 @@ namespace MelonDsDs::config::definitions {
         ShowCameraState,
         ShowLidState,
         ShowSensorReading,
+        ShowFrameskipStats,
 #ifndef NDEBUG
         ShowPointerCoordinates,
 #endif
@@ -145,6 +166,67 @@ namespace MelonDsDs::config::definitions {
         return true;
     }
 
+    /// Returns the index of the option with the given key,
+    /// or \c CoreOptionDefinitions.size() if there isn't one.
+    /// Compares the strings themselves so that it works in a constant expression on every compiler.
+    constexpr size_t IndexOfOption(std::string_view key) noexcept {
+        for (size_t i = 0; i < CoreOptionDefinitions.size() - 1; ++i) {
+            if (std::string_view(CoreOptionDefinitions[i].key) == key) {
+                return i;
+            }
+        }
+        return CoreOptionDefinitions.size();
+    }
+
+    constexpr bool IsCategoryDefined(const char* category) noexcept {
+        if (category == nullptr) {
+            return true;
+        }
+
+        for (const retro_core_option_v2_category& c : OptionCategories) {
+            if (c.key && std::string_view(c.key) == category) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    constexpr bool AreOptionCategoriesDefined() noexcept {
+        for (size_t i = 0; i < CoreOptionDefinitions.size() - 1; ++i) {
+            if (!IsCategoryDefined(CoreOptionDefinitions[i].category_key)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Indexes of the options whose values are discovered at runtime.
+    // These are the only entries that RegisterCoreOptions modifies;
+    // the rest of the table is submitted to the frontend exactly as it's defined here.
+    constexpr size_t DsiNandPathIndex = IndexOfOption(storage::DSI_NAND_PATH);
+    constexpr size_t FirmwarePathIndex = IndexOfOption(system::FIRMWARE_PATH);
+    constexpr size_t DsiFirmwarePathIndex = IndexOfOption(system::FIRMWARE_DSI_PATH);
+#ifdef HAVE_NETWORKING_DIRECT_MODE
+    constexpr size_t NetworkInterfaceIndex = IndexOfOption(network::DIRECT_NETWORK_INTERFACE);
+#endif
+
+    constexpr std::array DynamicOptionIndexes {
+        DsiNandPathIndex,
+        FirmwarePathIndex,
+        DsiFirmwarePathIndex,
+#ifdef HAVE_NETWORKING_DIRECT_MODE
+        NetworkInterfaceIndex,
+#endif
+    };
+
+    static_assert(DsiNandPathIndex < CoreOptionDefinitions.size() - 1);
+    static_assert(FirmwarePathIndex < CoreOptionDefinitions.size() - 1);
+    static_assert(DsiFirmwarePathIndex < CoreOptionDefinitions.size() - 1);
+#ifdef HAVE_NETWORKING_DIRECT_MODE
+    static_assert(NetworkInterfaceIndex < CoreOptionDefinitions.size() - 1);
+#endif
+    static_assert(AreOptionCategoriesDefined(), "Every option's category must be declared in OptionCategories");
+
     static_assert(
         CoreOptionDefinitions[CoreOptionDefinitions.size() - 1].key == nullptr,
         "CoreOptionDefinitions must end with a null key"
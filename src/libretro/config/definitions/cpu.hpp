@@ -29,6 +29,7 @@ namespace MelonDsDs::config::definitions {
         nullptr,
         "Recompiles emulated machine code into native code as it runs, "
         "considerably improving performance over plain interpretation. "
+        "Ignored if the frontend reports that this device can't run recompiled code. "
         "Takes effect at next restart. "
         "If unsure, leave enabled.",
         nullptr,
@@ -147,6 +148,27 @@ namespace MelonDsDs::config::definitions {
 #   endif
 #endif
 
+#ifdef HAVE_HUGE_PAGES
+    constexpr retro_core_option_v2_definition HugePages {
+        config::cpu::HUGE_PAGES,
+        "Huge Pages",
+        nullptr,
+        "Asks the host OS to back emulated main RAM with huge pages, "
+        "which can reduce TLB misses on systems with transparent huge pages set to \"madvise\". "
+        "Uses slightly more host memory. "
+        "Takes effect at next restart. "
+        "If unsure, leave disabled.",
+        nullptr,
+        MelonDsDs::config::cpu::CATEGORY,
+        {
+            {MelonDsDs::config::values::DISABLED, nullptr},
+            {MelonDsDs::config::values::ENABLED, nullptr},
+            {nullptr, nullptr},
+        },
+        MelonDsDs::config::values::DISABLED
+    };
+#endif
+
     constexpr std::initializer_list<retro_core_option_v2_definition> CpuOptionDefinitions {
 #ifdef JIT_ENABLED
         JitEnabled,
@@ -156,6 +178,9 @@ namespace MelonDsDs::config::definitions {
 #   ifdef HAVE_JIT_FASTMEM
         JitFastMemory,
 #   endif
+#endif
+#ifdef HAVE_HUGE_PAGES
+        HugePages,
 #endif
     };
 }
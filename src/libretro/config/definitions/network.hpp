@@ -72,6 +72,25 @@ namespace MelonDsDs::config::definitions {
     };
 #endif
 
+    constexpr retro_core_option_v2_definition MpBatching {
+        config::network::MP_BATCHING,
+        "Batch Local Multiplayer Packets",
+        nullptr,
+        "Combines the local multiplayer packets sent during each emulated time slice into one message, "
+        "and only flushes them to the network when a reply is awaited. "
+        "Reduces per-packet overhead on busy or wireless connections. "
+        "All players must use this version of melonDS DS or newer; "
+        "older versions can't read batches and will crash when they receive one.",
+        nullptr,
+        config::network::CATEGORY,
+        {
+            {config::values::DISABLED, nullptr},
+            {config::values::ENABLED, nullptr},
+            {nullptr, nullptr},
+        },
+        config::values::DISABLED
+    };
+
     constexpr std::initializer_list<retro_core_option_v2_definition> NetworkOptionDefinitions {
 #ifdef HAVE_NETWORKING
         NetworkMode,
@@ -79,6 +98,7 @@ namespace MelonDsDs::config::definitions {
         NetworkInterface,
 #   endif
 #endif
+        MpBatching,
     };
 }
 
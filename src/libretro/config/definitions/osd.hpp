@@ -116,6 +116,22 @@ namespace MelonDsDs::config::definitions {
         MelonDsDs::config::values::ENABLED
     };
 
+    constexpr retro_core_option_v2_definition ShowFrameskipStats {
+        config::osd::FRAMESKIP_STATS,
+        "Show Skipped Frames",
+        nullptr,
+        "Enable to show how many of the last 60 frames were skipped to keep audio from crackling. "
+        "Only shown while Frameskip is enabled.",
+        nullptr,
+        config::osd::CATEGORY,
+        {
+            {MelonDsDs::config::values::DISABLED, nullptr},
+            {MelonDsDs::config::values::ENABLED, nullptr},
+            {nullptr, nullptr},
+        },
+        MelonDsDs::config::values::DISABLED
+    };
+
     constexpr retro_core_option_v2_definition ShowSensorReading {
         config::osd::SENSOR_READING,
         "Show Sensor Reading",
@@ -163,6 +179,7 @@ namespace MelonDsDs::config::definitions {
         ShowCameraState,
         ShowLidState,
         ShowSensorReading,
+        ShowFrameskipStats,
 #ifndef NDEBUG
         ShowPointerCoordinates,
 #endif
@@ -227,6 +227,26 @@ namespace MelonDsDs::config::definitions {
         MelonDsDs::config::values::DISABLED
     };
 
+    constexpr retro_core_option_v2_definition DsiwareInstallMode {
+        config::storage::DSIWARE_INSTALL_MODE,
+        "DSiWare Installation",
+        nullptr,
+        "Controls how DSiWare titles are installed onto the DSi NAND image. "
+        "Temporary installs the title at boot and removes it when the game is closed. "
+        "Keep Installed leaves the title on the NAND image, "
+        "so later sessions with the same ROM only need to copy over the save data. "
+        "Titles that were already on the NAND image are never touched. "
+        "Changes take effect at next restart.",
+        nullptr,
+        config::system::CATEGORY,
+        {
+            {MelonDsDs::config::values::TEMPORARY, "Temporary"},
+            {MelonDsDs::config::values::PERSISTENT, "Keep Installed"},
+            {nullptr, nullptr},
+        },
+        MelonDsDs::config::values::TEMPORARY
+    };
+
     constexpr retro_core_option_v2_definition HomebrewSdCard {
         config::storage::HOMEBREW_SAVE_MODE,
         "Virtual SD Card",
@@ -332,6 +352,138 @@ namespace MelonDsDs::config::definitions {
         "20"
     };
 
+    constexpr retro_core_option_v2_definition BatterySaverThreshold {
+        config::system::BATTERY_SAVER_THRESHOLD,
+        "Battery Saver Threshold",
+        nullptr,
+        "If the host is running on battery power "
+        "and its charge falls below this percentage, "
+        "melonDS DS will switch to cheaper settings to extend battery life. "
+        "This lowers the OpenGL internal resolution, "
+        "disables the threaded software renderer on devices with two or fewer CPU cores, "
+        "saves GBA SRAM and firmware less often, "
+        "and hides the on-screen display. "
+        "Your own settings are restored once the host starts charging. "
+        "\n"
+        "Ignored if the frontend can't query the power status.",
+        nullptr,
+        config::system::CATEGORY,
+        {
+            {"0", "Disabled"},
+            {"10", "10%"},
+            {"20", "20%"},
+            {"30", "30%"},
+            {"40", "40%"},
+            {"50", "50%"},
+            {nullptr, nullptr},
+        },
+        "0"
+    };
+
+    constexpr retro_core_option_v2_definition InstantBoot {
+        config::system::INSTANT_BOOT,
+        "Instant Boot",
+        nullptr,
+        "If enabled, melonDS DS saves a snapshot of the console "
+        "this many frames after a game boots (or when the player first presses a button, if sooner). "
+        "Later launches of the same game restore that snapshot instead of booting from scratch. "
+        "The snapshot is made again if the game, its save data, "
+        "the BIOS, the firmware, the boot mode, or the active cheats change. "
+        "Snapshots are stored in the system directory. "
+        "Ignored in DSi mode and for homebrew. "
+        "Changes take effect at next restart.",
+        nullptr,
+        config::system::CATEGORY,
+        {
+            {"0", "Disabled"},
+            {"30", "After 0.5 seconds"},
+            {"60", "After 1 second"},
+            {"120", "After 2 seconds"},
+            {"300", "After 5 seconds"},
+            {"600", "After 10 seconds"},
+            {"1200", "After 20 seconds"},
+            {nullptr, nullptr},
+        },
+        "0"
+    };
+
+    constexpr retro_core_option_v2_definition RollbackMode {
+        config::system::ROLLBACK_MODE,
+        "Rollback Netplay Mode",
+        nullptr,
+        "Keeps emulation deterministic so that netplay can roll back and replay frames without desyncing. "
+        "The emulated clock won't follow the host's, "
+        "the host's microphone is replaced with white noise, "
+        "and the host's light sensor is ignored. "
+        "Enable this on every player's device before starting netplay.",
+        nullptr,
+        config::system::CATEGORY,
+        {
+            {config::values::DISABLED, nullptr},
+            {config::values::ENABLED, nullptr},
+            {nullptr, nullptr},
+        },
+        config::values::DISABLED
+    };
+
+    constexpr retro_core_option_v2_definition VerifySystemFiles {
+        config::system::VERIFY_SYSTEM_FILES,
+        "Verify System Files",
+        nullptr,
+        "If enabled, every firmware and DSi NAND image in the system directory "
+        "is read again in full and checked against the checksum recorded when it was first found. "
+        "Files that no longer match are reported as possibly corrupted, "
+        "and the record of known system files is rebuilt. "
+        "Runs when the core starts or when this option is enabled, "
+        "and may take a while with many NAND images, "
+        "so disable it again once the check is done. "
+        "Newly-found files are listed in the other options at next restart.",
+        nullptr,
+        config::system::CATEGORY,
+        {
+            {config::values::DISABLED, nullptr},
+            {config::values::ENABLED, nullptr},
+            {nullptr, nullptr},
+        },
+        config::values::DISABLED
+    };
+
+    constexpr retro_core_option_v2_definition FrameProfile {
+        config::system::FRAME_PROFILE,
+        "Frame Profiling",
+        nullptr,
+        "Measures how long each frame takes to emulate, "
+        "and logs the slowest frames and any sudden spikes in frame time when the game is unloaded. "
+        "Useful for finding out where and how often a game slows down. "
+        "If unsure, leave disabled.",
+        nullptr,
+        config::system::CATEGORY,
+        {
+            {config::values::DISABLED, nullptr},
+            {config::values::ENABLED, nullptr},
+            {nullptr, nullptr},
+        },
+        config::values::DISABLED
+    };
+
+    constexpr retro_core_option_v2_definition GbaSaveCompression {
+        config::storage::GBA_SAVE_COMPRESSION,
+        "Compress GBA Save Data",
+        nullptr,
+        "If enabled, GBA save data will be written in libretro's compressed save format, "
+        "which takes less space and fewer writes on slow storage. "
+        "Compressed and uncompressed GBA save data can always be loaded. "
+        "Save data that hasn't changed since it was last written won't be written again.",
+        nullptr,
+        config::system::CATEGORY,
+        {
+            {MelonDsDs::config::values::DISABLED, nullptr},
+            {MelonDsDs::config::values::ENABLED, nullptr},
+            {nullptr, nullptr},
+        },
+        MelonDsDs::config::values::DISABLED
+    };
+
     constexpr retro_core_option_v2_definition Slot2Device {
         config::system::SLOT2_DEVICE,
         "Slot-2 Device",
@@ -390,16 +542,23 @@ namespace MelonDsDs::config::definitions {
         FirmwarePath,
         DsiFirmwarePath,
         NandPath,
+        VerifySystemFiles,
         BootMode,
         DsiSdCardSaveMode,
         DsiSdCardReadOnly,
         DsiSdCardSyncToHost,
+        DsiwareInstallMode,
         Slot2Device,
+        GbaSaveCompression,
         HomebrewSdCard,
         HomebrewSdCardReadOnly,
         HomebrewSdCardSyncToHost,
         BatteryUpdateInterval,
         NdsPowerOkThreshold,
+        BatterySaverThreshold,
+        InstantBoot,
+        RollbackMode,
+        FrameProfile,
     };
 }
 
@@ -110,6 +110,8 @@ namespace MelonDsDs::config::definitions {
         "Threaded Software Renderer",
         nullptr,
         "If enabled, the software renderer will run on a separate thread. "
+        "Auto enables it only if this device has more than two CPU cores, "
+        "since otherwise the render thread competes with the emulator for time. "
         "Changes take effect immediately. "
         "If unsure, leave this enabled.",
         nullptr,
@@ -117,11 +119,121 @@ namespace MelonDsDs::config::definitions {
         {
             {MelonDsDs::config::values::DISABLED, nullptr},
             {MelonDsDs::config::values::ENABLED, nullptr},
+            {MelonDsDs::config::values::AUTO, "Auto"},
             {nullptr, nullptr},
         },
         MelonDsDs::config::values::ENABLED
     };
 #endif
+#ifdef HAVE_THREADS
+    constexpr retro_core_option_v2_definition ThreadedComposition {
+        config::video::THREADED_COMPOSITION,
+        "Threaded Screen Composition",
+        nullptr,
+        "If enabled, the emulated screens are arranged into each frame on a separate thread "
+        "while the next frame is being emulated. "
+        "This leaves more time for the emulator on multi-core devices, "
+        "but delays the picture by one frame. "
+        "Software renderer only. "
+        "Changes take effect immediately.",
+        nullptr,
+        config::video::CATEGORY,
+        {
+            {MelonDsDs::config::values::DISABLED, nullptr},
+            {MelonDsDs::config::values::ENABLED, nullptr},
+            {nullptr, nullptr},
+        },
+        MelonDsDs::config::values::DISABLED
+    };
+#endif
+
+    constexpr retro_core_option_v2_definition PixelFormat {
+        config::video::PIXEL_FORMAT,
+        "Output Pixel Format",
+        nullptr,
+        "The pixel format of each frame sent to the frontend. "
+        "16-bit output halves the memory bandwidth used to compose and upload each frame, "
+        "which may help on low-end devices. "
+        "The emulated screens only use 18-bit color, so the difference is subtle. "
+        "If the frontend doesn't support 16-bit output, 32-bit is used as a fallback. "
+        "Software renderer only. "
+        "Changes take effect at next restart.",
+        nullptr,
+        config::video::CATEGORY,
+        {
+            {MelonDsDs::config::values::XRGB8888, "32-bit (XRGB8888)"},
+            {MelonDsDs::config::values::RGB565, "16-bit (RGB565)"},
+            {nullptr, nullptr},
+        },
+        MelonDsDs::config::values::XRGB8888
+    };
+
+    constexpr retro_core_option_v2_definition Frameskip {
+        config::video::FRAMESKIP,
+        "Frameskip",
+        nullptr,
+        "Skips presenting frames when the frontend's audio buffer is running low, "
+        "trading choppier video for uninterrupted audio on slow devices. "
+        "The emulation itself still runs every frame.\n"
+        "\n"
+        "Auto: Skip frames whenever the frontend reports that audio is likely to underrun.\n"
+        "Threshold: Skip frames whenever the audio buffer is less full than the Frameskip Threshold.\n"
+        "\n"
+        "Ignored if the frontend can't report its audio buffer status or repeat frames.",
+        nullptr,
+        config::video::CATEGORY,
+        {
+            {MelonDsDs::config::values::DISABLED, nullptr},
+            {MelonDsDs::config::values::AUTO, "Auto"},
+            {MelonDsDs::config::values::THRESHOLD, "Threshold"},
+            {nullptr, nullptr},
+        },
+        MelonDsDs::config::values::DISABLED
+    };
+
+    constexpr retro_core_option_v2_definition FrameskipThreshold {
+        config::video::FRAMESKIP_THRESHOLD,
+        "Frameskip Threshold",
+        nullptr,
+        "When Frameskip is set to Threshold, "
+        "frames are skipped while the audio buffer is less full than this percentage. "
+        "Higher values skip more often, but crackle less.",
+        nullptr,
+        config::video::CATEGORY,
+        {
+            {"15", "15%"},
+            {"20", "20%"},
+            {"25", "25%"},
+            {"33", "33%"},
+            {"40", "40%"},
+            {"50", "50%"},
+            {"60", "60%"},
+            {nullptr, nullptr},
+        },
+        "33"
+    };
+
+    constexpr retro_core_option_v2_definition FrameskipMax {
+        config::video::FRAMESKIP_MAX,
+        "Max Consecutive Skipped Frames",
+        nullptr,
+        "The most frames that can be skipped in a row before one is shown regardless of the audio buffer. "
+        "Ignored if Frameskip is disabled.",
+        nullptr,
+        config::video::CATEGORY,
+        {
+            {"1", nullptr},
+            {"2", nullptr},
+            {"3", nullptr},
+            {"4", nullptr},
+            {"5", nullptr},
+            {"6", nullptr},
+            {"8", nullptr},
+            {"10", nullptr},
+            {nullptr, nullptr},
+        },
+        "3"
+    };
 
     constexpr std::initializer_list<retro_core_option_v2_definition> VideoOptionDefinitions {
 #if defined(HAVE_OPENGL) || defined(HAVE_OPENGLES)
@@ -133,6 +245,13 @@ namespace MelonDsDs::config::definitions {
 #if defined(HAVE_THREADS) && defined(HAVE_THREADED_RENDERER)
         ThreadedSoftwareRenderer,
 #endif
+#ifdef HAVE_THREADS
+        ThreadedComposition,
+#endif
+        PixelFormat,
+        Frameskip,
+        FrameskipThreshold,
+        FrameskipMax,
     };
 }
 
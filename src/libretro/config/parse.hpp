@@ -78,6 +78,12 @@ namespace MelonDsDs {
         return std::nullopt;
     }
 
+    constexpr std::optional<MelonDsDs::DsiwareInstallMode> ParseDsiwareInstallMode(std::string_view value) noexcept {
+        if (value == config::values::TEMPORARY) return DsiwareInstallMode::Temporary;
+        if (value == config::values::PERSISTENT) return DsiwareInstallMode::Persistent;
+        return std::nullopt;
+    }
+
     constexpr std::optional<MelonDsDs::AlarmMode> ParseAlarmMode(std::string_view value) noexcept {
         if (value == config::values::DISABLED) return AlarmMode::Disabled;
         if (value == config::values::ENABLED) return AlarmMode::Enabled;
@@ -98,6 +104,19 @@ namespace MelonDsDs {
         return std::nullopt;
     }
 
+    constexpr std::optional<MelonDsDs::PixelFormat> ParsePixelFormat(std::string_view value) noexcept {
+        if (value == config::values::XRGB8888) return MelonDsDs::PixelFormat::Xrgb8888;
+        if (value == config::values::RGB565) return MelonDsDs::PixelFormat::Rgb565;
+        return std::nullopt;
+    }
+
+    constexpr std::optional<MelonDsDs::FrameskipMode> ParseFrameskipMode(std::string_view value) noexcept {
+        if (value == config::values::DISABLED) return MelonDsDs::FrameskipMode::Disabled;
+        if (value == config::values::AUTO) return MelonDsDs::FrameskipMode::Auto;
+        if (value == config::values::THRESHOLD) return MelonDsDs::FrameskipMode::Threshold;
+        return std::nullopt;
+    }
+
     constexpr std::optional<MelonDsDs::CursorMode> ParseCursorMode(std::string_view value) noexcept {
         if (value == config::values::DISABLED) return MelonDsDs::CursorMode::Never;
         if (value == config::values::TOUCHING) return MelonDsDs::CursorMode::Touching;
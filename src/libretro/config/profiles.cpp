@@ -0,0 +1,293 @@
+/*
+    Copyright 2024 Jesse Talavera
+
+    melonDS DS is free software: you can redistribute it and/or modify it under
+    the terms of the GNU General Public License as published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+
+    melonDS DS is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with melonDS DS. If not, see http://www.gnu.org/licenses/.
+*/
+
+
+#include "profiles.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cctype>
+#include <cstring>
+
+#include <NDS_Header.h>
+#include <file/file_path.h>
+#include <streams/file_stream.h>
+
+#include "config.hpp"
+#include "constants.hpp"
+#include "config/definitions.hpp"
+#include "environment.hpp"
+#include "parse.hpp"
+#include "tracy.hpp"
+#include "embedded/melondsds_default_title_profiles.h"
+
+using std::nullopt;
+using std::optional;
+using std::string;
+using std::string_view;
+using std::vector;
+
+namespace MelonDsDs {
+    constexpr const char* const TITLE_PROFILES_NAME = "profiles.cfg";
+    constexpr const char* const WHITESPACE = " \t\r";
+
+    static optional<TitleProfile> ParseTitleProfileLine(string_view line, unsigned lineNumber) noexcept;
+    static optional<TitleProfile> FindTitleProfile(const vector<TitleProfile>& profiles, const melonDS::NDSHeader& header) noexcept;
+    static bool IsOptionAtDefault(const string& key) noexcept;
+}
+
+std::string_view MelonDsDs::GetDefaultTitleProfiles() noexcept {
+    // Subtract 1 to exclude the null terminator
+    return { embedded_melondsds_default_title_profiles, sizeof(embedded_melondsds_default_title_profiles) - 1 };
+}
+
+vector<MelonDsDs::TitleProfile> MelonDsDs::ParseTitleProfiles(string_view text, unsigned* malformed) noexcept {
+    ZoneScopedN(TracyFunction);
+    vector<TitleProfile> profiles;
+    unsigned lineNumber = 0;
+    while (!text.empty()) {
+        size_t end = text.find('\n');
+        string_view line = text.substr(0, end);
+        text = (end == string_view::npos) ? string_view() : text.substr(end + 1);
+        lineNumber++;
+
+        if (size_t start = line.find_first_not_of(WHITESPACE); start == string_view::npos || line[start] == '#') {
+            // If this line is blank or a comment...
+            continue;
+        }
+
+        if (optional<TitleProfile> profile = ParseTitleProfileLine(line, lineNumber)) {
+            profiles.push_back(std::move(*profile));
+        } else if (malformed) {
+            (*malformed)++;
+        }
+    }
+
+    return profiles;
+}
+
+static optional<MelonDsDs::TitleProfile> MelonDsDs::ParseTitleProfileLine(string_view line, unsigned lineNumber) noexcept {
+    TitleProfile profile;
+    bool first = true;
+    bool none = false;
+    while (!line.empty()) {
+        size_t start = line.find_first_not_of(WHITESPACE);
+        if (start == string_view::npos)
+            break;
+
+        line.remove_prefix(start);
+        size_t end = line.find_first_of(WHITESPACE);
+        string_view token = line.substr(0, end);
+        line.remove_prefix(token.size());
+
+        if (first) {
+            // The first token identifies the game, e.g. "ASME" or "ASME:1A2B"
+            first = false;
+            string_view code = token.substr(0, token.find(':'));
+            if (code.size() != profile.GameCode.size() || !std::all_of(code.begin(), code.end(), [](char c) { return std::isalnum(static_cast<unsigned char>(c)); })) {
+                retro::warn("Title profile line {}: \"{}\" isn't a valid game code", lineNumber, code);
+                return nullopt;
+            }
+            std::copy(code.begin(), code.end(), profile.GameCode.begin());
+
+            if (code.size() < token.size()) {
+                // If this profile is for one specific revision...
+                string_view crcText = token.substr(code.size() + 1);
+                uint16_t crc = 0;
+                auto result = std::from_chars(crcText.data(), crcText.data() + crcText.size(), crc, 16);
+                if (result.ec != std::errc() || result.ptr != crcText.data() + crcText.size()) {
+                    retro::warn("Title profile line {}: \"{}\" isn't a valid header CRC", lineNumber, crcText);
+                    return nullopt;
+                }
+                profile.HeaderCrc = crc;
+            }
+            continue;
+        }
+
+        if (none) {
+            retro::warn("Title profile line {}: \"none\" can't be combined with overrides", lineNumber);
+            return nullopt;
+        }
+
+        if (token == "none" && profile.Overrides.empty()) {
+            // If the player is turning off the built-in profile for this game...
+            none = true;
+            continue;
+        }
+
+        size_t equals = token.find('=');
+        if (equals == string_view::npos) {
+            retro::warn("Title profile line {}: expected option=value, got \"{}\"", lineNumber, token);
+            continue;
+        }
+
+        profile.Overrides.push_back({ string(token.substr(0, equals)), string(token.substr(equals + 1)) });
+    }
+
+    if (!none && profile.Overrides.empty()) {
+        retro::warn("Title profile line {} doesn't override anything", lineNumber);
+        return nullopt;
+    }
+
+    return profile;
+}
+
+static optional<MelonDsDs::TitleProfile> MelonDsDs::FindTitleProfile(const vector<TitleProfile>& profiles, const melonDS::NDSHeader& header) noexcept {
+    const TitleProfile* match = nullptr;
+    for (const TitleProfile& profile : profiles) {
+        if (memcmp(profile.GameCode.data(), header.GameCode, profile.GameCode.size()) != 0)
+            continue;
+
+        if (profile.HeaderCrc == header.HeaderCRC16) {
+            // A profile for this exact revision beats one for the game in general
+            return profile;
+        }
+
+        if (!profile.HeaderCrc && !match) {
+            match = &profile;
+        }
+    }
+
+    return match ? std::make_optional(*match) : nullopt;
+}
+
+vector<MelonDsDs::TitleProfile> MelonDsDs::LoadTitleProfiles(unsigned* malformed) noexcept {
+    ZoneScopedN(TracyFunction);
+
+    optional<string> path = retro::get_system_subdir_path(TITLE_PROFILES_NAME);
+    if (!path || !path_is_valid(path->c_str())) {
+        // If the player doesn't have a profile database...
+        return {};
+    }
+
+    void* buffer = nullptr;
+    int64_t length = 0;
+    if (!filestream_read_file(path->c_str(), &buffer, &length) || !buffer) {
+        retro::warn("Failed to read title profiles from {}", *path);
+        return {};
+    }
+
+    vector<TitleProfile> profiles = ParseTitleProfiles(string_view(static_cast<const char*>(buffer), length), malformed);
+    free(buffer);
+    retro::debug("Read {} title profile(s) from {}", profiles.size(), *path);
+    return profiles;
+}
+
+optional<MelonDsDs::TitleProfile> MelonDsDs::FindTitleProfile(const melonDS::NDSHeader& header) noexcept {
+    ZoneScopedN(TracyFunction);
+    if (optional<TitleProfile> profile = FindTitleProfile(LoadTitleProfiles(), header)) {
+        // If the player has a profile for this game, it replaces the built-in one
+        return profile;
+    }
+
+    // The built-in database never changes, so it only needs to be parsed once
+    static const vector<TitleProfile> builtInProfiles = [] {
+        vector<TitleProfile> profiles = ParseTitleProfiles(GetDefaultTitleProfiles());
+        for (TitleProfile& profile : profiles) {
+            profile.BuiltIn = true;
+        }
+        return profiles;
+    }();
+
+    return FindTitleProfile(builtInProfiles, header);
+}
+
+bool MelonDsDs::ApplyProfileOverride(CoreConfig& config, string_view key, string_view value) noexcept {
+    using namespace MelonDsDs::config;
+
+    if (key == audio::AUDIO_INTERPOLATION) {
+        if (optional<melonDS::AudioInterpolation> interpolation = ParseInterpolation(value)) {
+            config.SetInterpolation(*interpolation);
+            return true;
+        }
+    }
+    else if (key == screen::TOUCH_MODE) {
+        if (optional<TouchMode> touchMode = ParseTouchMode(value)) {
+            config.SetTouchMode(*touchMode);
+            return true;
+        }
+    }
+#ifdef HAVE_JIT
+    else if (key == cpu::JIT_ENABLE) {
+        if (optional<bool> enable = ParseBoolean(value)) {
+            config.SetJitEnable(*enable);
+            return true;
+        }
+    }
+    else if (key == cpu::JIT_BLOCK_SIZE) {
+        if (optional<unsigned> blockSize = ParseIntegerInRange(value, 1u, 32u)) {
+            config.SetMaxBlockSize(*blockSize);
+            return true;
+        }
+    }
+#endif
+#if defined(HAVE_OPENGL) || defined(HAVE_OPENGLES)
+    else if (key == video::OPENGL_RESOLUTION) {
+        if (optional<unsigned> scale = ParseIntegerInRange<unsigned>(value, 1, video::MAX_OPENGL_SCALE)) {
+            config.SetScaleFactor(*scale);
+            return true;
+        }
+    }
+#endif
+#if defined(HAVE_THREADS) && defined(HAVE_THREADED_RENDERER)
+    else if (key == video::THREADED_RENDERER) {
+        if (optional<bool> threaded = ParseBoolean(value)) {
+            config.SetThreadedSoftRenderer(*threaded);
+            return true;
+        }
+    }
+#endif
+
+    return false;
+}
+
+static bool MelonDsDs::IsOptionAtDefault(const string& key) noexcept {
+    using config::definitions::CoreOptionDefinitions;
+    auto definition = std::find_if(CoreOptionDefinitions.begin(), CoreOptionDefinitions.end(), [&key](const retro_core_option_v2_definition& d) {
+        return key == d.key;
+    });
+
+    if (definition == CoreOptionDefinitions.end() || !definition->default_value)
+        return true; // ApplyProfileOverride will reject it anyway
+
+    // An unset option is parsed as its default
+    string_view value = retro::get_variable(key);
+    return value.empty() || value == definition->default_value;
+}
+
+unsigned MelonDsDs::ApplyTitleProfile(CoreConfig& config, const TitleProfile& profile) noexcept {
+    ZoneScopedN(TracyFunction);
+    string_view code(profile.GameCode.data(), profile.GameCode.size());
+    unsigned applied = 0;
+    if (profile.Overrides.empty()) {
+        retro::debug("Title profiles are turned off for {}", code);
+    }
+
+    for (const ProfileOverride& entry : profile.Overrides) {
+        if (profile.BuiltIn && !IsOptionAtDefault(entry.Key)) {
+            // If the player chose a value for this option themselves...
+            retro::debug("Title profile for {} would set {}={}, but the player changed it; leaving it alone", code, entry.Key, entry.Value);
+        }
+        else if (ApplyProfileOverride(config, entry.Key, entry.Value)) {
+            retro::info("Title profile for {} sets {}={}", code, entry.Key, entry.Value);
+            applied++;
+        } else {
+            retro::warn("Title profile for {} can't set {}={}; ignoring", code, entry.Key, entry.Value);
+        }
+    }
+
+    return applied;
+}
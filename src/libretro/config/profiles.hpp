@@ -0,0 +1,96 @@
+/*
+    Copyright 2024 Jesse Talavera
+
+    melonDS DS is free software: you can redistribute it and/or modify it under
+    the terms of the GNU General Public License as published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+
+    melonDS DS is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with melonDS DS. If not, see http://www.gnu.org/licenses/.
+*/
+
+
+#ifndef MELONDSDS_CONFIG_PROFILES_HPP
+#define MELONDSDS_CONFIG_PROFILES_HPP
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace melonDS {
+    struct NDSHeader;
+}
+
+namespace MelonDsDs {
+    class CoreConfig;
+
+    /// A core option that a title profile sets to a fixed value.
+    struct ProfileOverride {
+        std::string Key;
+        std::string Value;
+    };
+
+    /// Settings that a particular game needs to run at full speed,
+    /// applied on top of the player's own core options.
+    struct TitleProfile {
+        std::array<char, 4> GameCode {};
+
+        /// If set, the profile only applies to the revision with this header CRC.
+        std::optional<uint16_t> HeaderCrc;
+
+        /// Empty if the player's database turns off the built-in profile for this game.
+        std::vector<ProfileOverride> Overrides;
+
+        /// If true, this profile came with the core rather than from the player,
+        /// so it only changes options that the player left at their defaults.
+        bool BuiltIn = false;
+    };
+
+    /// Parses a profile database.
+    /// Each line that isn't blank or a comment (starting with \c #) defines one profile:
+    /// \code
+    /// GAME[:CRC] option=value option=value ...
+    /// \endcode
+    /// where \c GAME is the four-character game code from the ROM header (e.g. \c ASME)
+    /// and \c CRC is the header's CRC16 in hexadecimal (e.g. \c ASME:1A2B),
+    /// for telling apart revisions of the same game.
+    /// A line of just \c GAME[:CRC] \c none defines a profile with no overrides,
+    /// which the player can use to turn off a built-in profile.
+    /// Malformed lines are logged and skipped, and counted in \c malformed if given.
+    std::vector<TitleProfile> ParseTitleProfiles(std::string_view text, unsigned* malformed = nullptr) noexcept;
+
+    /// Returns the text of the profile database that ships with the core.
+    std::string_view GetDefaultTitleProfiles() noexcept;
+
+    /// Reads the profile database from profiles.cfg in the core's system directory.
+    /// Returns an empty database if the player doesn't have one.
+    std::vector<TitleProfile> LoadTitleProfiles(unsigned* malformed = nullptr) noexcept;
+
+    /// Finds the profile for the given game,
+    /// looking in the player's profile database before the built-in one.
+    /// A profile for the game's exact revision takes precedence over one for the game in general.
+    /// Reads the player's database from disk, so call this once per loaded game and keep the result.
+    std::optional<TitleProfile> FindTitleProfile(const melonDS::NDSHeader& header) noexcept;
+
+    /// Applies a single override to the config.
+    /// Returns false (leaving the config unchanged) if the option can't be overridden
+    /// or the value isn't valid for it.
+    bool ApplyProfileOverride(CoreConfig& config, std::string_view key, std::string_view value) noexcept;
+
+    /// Applies each of the profile's overrides to the config and logs them.
+    /// A built-in profile skips options that the player has changed from their defaults;
+    /// the player's own profiles always apply.
+    /// Call this after ParseConfig, since that resets the config to the player's core options.
+    /// Returns the number of overrides that were applied.
+    unsigned ApplyTitleProfile(CoreConfig& config, const TitleProfile& profile) noexcept;
+}
+
+#endif // MELONDSDS_CONFIG_PROFILES_HPP
@@ -0,0 +1,374 @@
+/*
+    Copyright 2024 Jesse Talavera
+
+    melonDS DS is free software: you can redistribute it and/or modify it under
+    the terms of the GNU General Public License as published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+
+    melonDS DS is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with melonDS DS. If not, see http://www.gnu.org/licenses/.
+*/
+
+#include "sysfiles.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <sys/stat.h>
+
+#include <encodings/crc32.h>
+#include <fmt/format.h>
+#include <streams/file_stream.h>
+
+#include "constants.hpp"
+#include "environment.hpp"
+#include "retro/dirent.hpp"
+#include "retro/file.hpp"
+#include "tracy.hpp"
+
+using std::optional;
+using std::string;
+using std::string_view;
+
+constexpr string_view SYSFILE_CACHE_NAME = "sysfile_cache.txt";
+constexpr string_view SYSFILE_CACHE_HEADER = "melonDS DS system file cache v3\n";
+
+namespace MelonDsDs::config {
+    static optional<SystemFileInfo> ParseCacheLine(string_view line, string& path) noexcept;
+    static void FormatCacheLine(fmt::memory_buffer& out, const string& path, const SystemFileInfo& info) noexcept;
+    static bool StatFile(const char* path, SystemFileInfo& info) noexcept;
+    static optional<uint32_t> GetFileCrc32(const char* path) noexcept;
+}
+
+template<typename T>
+static bool ParseNumber(string_view text, T& value, int base = 10) noexcept {
+    std::from_chars_result result = std::from_chars(text.data(), text.data() + text.size(), value, base);
+    return result.ec == std::errc() && result.ptr == text.data() + text.size();
+}
+
+// Files of any other size are rejected without being opened, so there's no point in caching them
+static bool IsCandidateSize(int64_t size) noexcept {
+    using namespace MelonDsDs::config;
+    for (size_t nandSize : DSI_NAND_SIZES_NOFOOTER) {
+        if (size == static_cast<int64_t>(nandSize) || size == static_cast<int64_t>(nandSize + NOCASH_FOOTER_SIZE))
+            return true;
+    }
+
+    return std::find(FIRMWARE_SIZES.begin(), FIRMWARE_SIZES.end(), static_cast<size_t>(size)) != FIRMWARE_SIZES.end();
+}
+
+static bool IsUnchanged(const MelonDsDs::config::SystemFileInfo& cached, const MelonDsDs::config::SystemFileInfo& current) noexcept {
+    return cached.Size == current.Size && cached.ModifiedTime == current.ModifiedTime && cached.Inode == current.Inode;
+}
+
+static char TypeToChar(MelonDsDs::config::SystemFileType type) noexcept {
+    using MelonDsDs::config::SystemFileType;
+    switch (type) {
+        case SystemFileType::DsiNand: return 'N';
+        case SystemFileType::Firmware: return 'F';
+        default: return '-';
+    }
+}
+
+MelonDsDs::config::SystemFileCache MelonDsDs::config::SystemFileCache::Load() noexcept {
+    ZoneScopedN(TracyFunction);
+    SystemFileCache cache;
+
+    optional<string> cachePath = retro::get_system_subdir_path(SYSFILE_CACHE_NAME);
+    if (!cachePath)
+        return cache;
+
+    void* buffer = nullptr;
+    int64_t length = 0;
+    if (!filestream_exists(cachePath->c_str()) || !filestream_read_file(cachePath->c_str(), &buffer, &length)) {
+        retro::debug("No system file cache found at {}", *cachePath);
+        return cache;
+    }
+
+    std::unique_ptr<char, decltype(&free)> contents(static_cast<char*>(buffer), &free);
+    string_view text(contents.get(), length);
+    if (text.substr(0, SYSFILE_CACHE_HEADER.size()) != SYSFILE_CACHE_HEADER) {
+        retro::warn("System file cache at {} is from a different version, ignoring it", *cachePath);
+        return cache;
+    }
+
+    text.remove_prefix(SYSFILE_CACHE_HEADER.size());
+    while (!text.empty()) {
+        size_t end = text.find('\n');
+        string_view line = text.substr(0, end);
+        text.remove_prefix(end == string_view::npos ? text.size() : end + 1);
+
+        string path;
+        if (optional<SystemFileInfo> info = ParseCacheLine(line, path)) {
+            cache._entries.emplace(std::move(path), *info);
+        }
+        else if (!line.empty()) {
+            retro::debug("Ignoring malformed system file cache entry \"{}\"", line);
+        }
+    }
+
+    retro::debug("Loaded {} entries from the system file cache at {}", cache._entries.size(), *cachePath);
+    return cache;
+}
+
+MelonDsDs::config::SystemFileType MelonDsDs::config::SystemFileCache::Classify(
+    const retro::dirent& file,
+    melonDS::Firmware::FirmwareHeader& header
+) noexcept {
+    ZoneScopedN(TracyFunction);
+    if (!file.is_regular_file() || !IsCandidateSize(file.size))
+        return SystemFileType::None;
+
+    SystemFileInfo current;
+    if (!StatFile(file.path, current))
+        return SystemFileType::None;
+
+    if (auto it = _entries.find(file.path); it != _entries.end()) {
+        // If we've seen this file before...
+        SystemFileInfo& cached = it->second;
+        if (IsUnchanged(cached, current)) {
+            // ...and it hasn't changed since then...
+            cached.Seen = true;
+            _hits++;
+            if (cached.Type == SystemFileType::Firmware) {
+                memcpy(&header, cached.Header.data(), sizeof(header));
+            }
+
+            return cached.Type;
+        }
+    }
+
+    _misses++;
+    _dirty = true;
+    current.Seen = true;
+    if (IsDsiNandImage(file, &current.ConsoleId)) {
+        current.Type = SystemFileType::DsiNand;
+    }
+    else if (IsFirmwareImage(file, header)) {
+        current.Type = SystemFileType::Firmware;
+        memcpy(current.Header.data(), &header, sizeof(header));
+    }
+
+    if (current.Type != SystemFileType::None) {
+        if (optional<uint32_t> crc = GetFileCrc32(file.path)) {
+            current.Crc32 = *crc;
+        } else {
+            retro::warn("Failed to read all of {}, ignoring it", file.path);
+            current.Type = SystemFileType::None;
+        }
+    }
+
+    if (current.Type == SystemFileType::DsiNand) {
+        retro::debug("{} is a DSi NAND image (console ID {:016X}, CRC32 {:08X})", file.path, current.ConsoleId, current.Crc32);
+    }
+    else if (current.Type == SystemFileType::Firmware) {
+        retro::debug(
+            "{} is a firmware image for console type {} (CRC32 {:08X})",
+            file.path,
+            static_cast<unsigned>(header.ConsoleType),
+            current.Crc32
+        );
+    }
+
+    _entries.insert_or_assign(file.path, current);
+    return current.Type;
+}
+
+bool MelonDsDs::config::SystemFileCache::Save() noexcept {
+    ZoneScopedN(TracyFunction);
+    for (auto it = _entries.begin(); it != _entries.end();) {
+        // Forget about files that were deleted or moved
+        if (it->second.Seen) {
+            ++it;
+        } else {
+            it = _entries.erase(it);
+            _dirty = true;
+        }
+    }
+
+    if (!_dirty)
+        return true;
+
+    optional<string> cachePath = retro::get_system_subdir_path(SYSFILE_CACHE_NAME);
+    if (!cachePath)
+        return false;
+
+    fmt::memory_buffer out;
+    out.append(SYSFILE_CACHE_HEADER.data(), SYSFILE_CACHE_HEADER.data() + SYSFILE_CACHE_HEADER.size());
+    for (const auto& [path, info] : _entries) {
+        FormatCacheLine(out, path, info);
+    }
+
+    if (!filestream_write_file(cachePath->c_str(), out.data(), out.size())) {
+        retro::warn("Failed to write the system file cache to {}", *cachePath);
+        return false;
+    }
+
+    retro::debug("Wrote {} entries to the system file cache at {} ({} hits, {} misses)", _entries.size(), *cachePath, _hits, _misses);
+    _dirty = false;
+    return true;
+}
+
+MelonDsDs::config::SystemFileReport MelonDsDs::config::VerifySystemFiles() noexcept {
+    ZoneScopedN(TracyFunction);
+    SystemFileReport report;
+    optional<string_view> sysdir = retro::get_system_directory();
+    optional<string_view> subdir = retro::get_system_subdirectory();
+    if (!sysdir || !subdir) {
+        retro::error("Failed to get system directory, can't verify system files");
+        return report;
+    }
+
+    // Start from an empty cache so that every file is read again,
+    // but keep the old one to catch files that were damaged without their metadata changing
+    SystemFileCache previous = SystemFileCache::Load();
+    SystemFileCache cache;
+    uint8_t headerBytes[sizeof(melonDS::Firmware::FirmwareHeader)] {};
+    auto& header = *reinterpret_cast<melonDS::Firmware::FirmwareHeader*>(headerBytes);
+    for (string_view path : {*sysdir, *subdir}) {
+        for (const retro::dirent& d : retro::readdir(string(path), true)) {
+            SystemFileType type = cache.Classify(d, header);
+            if (type != SystemFileType::None) {
+                report.Found++;
+            }
+
+            auto current = cache._entries.find(d.path);
+            auto cached = previous._entries.find(d.path);
+            if (current == cache._entries.end() || cached == previous._entries.end())
+                continue;
+
+            const SystemFileInfo& before = cached->second;
+            const SystemFileInfo& after = current->second;
+            if (before.Type != SystemFileType::None && IsUnchanged(before, after) && (before.Type != after.Type || before.Crc32 != after.Crc32)) {
+                retro::warn(
+                    "{} no longer matches its checksum (CRC32 was {:08X}, now {:08X}) but its size and timestamp haven't changed; it may be corrupted",
+                    d.path,
+                    before.Crc32,
+                    after.Crc32
+                );
+                report.Corrupted++;
+            }
+        }
+    }
+
+    cache._dirty = true;
+    cache.Save();
+    retro::info(
+        "Verified system files; found {} firmware and DSi NAND images, {} of which may be corrupted",
+        report.Found,
+        report.Corrupted
+    );
+    return report;
+}
+
+static optional<MelonDsDs::config::SystemFileInfo> MelonDsDs::config::ParseCacheLine(string_view line, string& path) noexcept {
+    // Format: type, size, mtime, inode, CRC32, console ID, header, path (tab-separated)
+    std::array<string_view, 8> fields;
+    for (size_t i = 0; i < fields.size() - 1; ++i) {
+        size_t tab = line.find('\t');
+        if (tab == string_view::npos)
+            return std::nullopt;
+
+        fields[i] = line.substr(0, tab);
+        line.remove_prefix(tab + 1);
+    }
+    fields.back() = line;
+
+    SystemFileInfo info;
+    if (fields[0] == "N")
+        info.Type = SystemFileType::DsiNand;
+    else if (fields[0] == "F")
+        info.Type = SystemFileType::Firmware;
+    else if (fields[0] == "-")
+        info.Type = SystemFileType::None;
+    else
+        return std::nullopt;
+
+    if (!ParseNumber(fields[1], info.Size) ||
+        !ParseNumber(fields[2], info.ModifiedTime) ||
+        !ParseNumber(fields[3], info.Inode) ||
+        !ParseNumber(fields[4], info.Crc32, 16) ||
+        !ParseNumber(fields[5], info.ConsoleId, 16)) {
+        return std::nullopt;
+    }
+
+    if (info.Type == SystemFileType::Firmware) {
+        if (fields[6].size() != info.Header.size() * 2)
+            return std::nullopt;
+
+        for (size_t i = 0; i < info.Header.size(); ++i) {
+            if (!ParseNumber(fields[6].substr(i * 2, 2), info.Header[i], 16))
+                return std::nullopt;
+        }
+    }
+
+    if (fields[7].empty())
+        return std::nullopt;
+
+    path = fields[7];
+    return info;
+}
+
+static void MelonDsDs::config::FormatCacheLine(fmt::memory_buffer& out, const string& path, const SystemFileInfo& info) noexcept {
+    fmt::format_to(
+        std::back_inserter(out),
+        "{}\t{}\t{}\t{}\t{:08x}\t{:016x}\t",
+        TypeToChar(info.Type),
+        info.Size,
+        info.ModifiedTime,
+        info.Inode,
+        info.Crc32,
+        info.ConsoleId
+    );
+
+    if (info.Type == SystemFileType::Firmware) {
+        for (uint8_t byte : info.Header) {
+            fmt::format_to(std::back_inserter(out), "{:02x}", byte);
+        }
+    } else {
+        out.push_back('-');
+    }
+
+    fmt::format_to(std::back_inserter(out), "\t{}\n", path);
+}
+
+static bool MelonDsDs::config::StatFile(const char* path, SystemFileInfo& info) noexcept {
+    struct stat statbuf {};
+    if (stat(path, &statbuf) != 0)
+        return false;
+
+    info.Size = statbuf.st_size;
+    info.ModifiedTime = statbuf.st_mtime;
+    info.Inode = statbuf.st_ino;
+    return true;
+}
+
+// Reads the file in chunks, since DSi NAND images are hundreds of megabytes
+static optional<uint32_t> MelonDsDs::config::GetFileCrc32(const char* path) noexcept {
+    ZoneScopedN(TracyFunction);
+    retro::rfile_ptr file = retro::make_rfile(path, RETRO_VFS_FILE_ACCESS_READ);
+    if (!file)
+        return std::nullopt;
+
+    uint32_t crc = 0;
+    uint8_t chunk[16384];
+    int64_t bytesRead = 0;
+    while ((bytesRead = filestream_read(file.get(), chunk, sizeof(chunk))) > 0) {
+        crc = encoding_crc32(crc, chunk, bytesRead);
+    }
+
+    if (bytesRead < 0)
+        return std::nullopt;
+
+    return crc;
+}
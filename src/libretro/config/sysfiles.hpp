@@ -0,0 +1,102 @@
+/*
+    Copyright 2024 Jesse Talavera
+
+    melonDS DS is free software: you can redistribute it and/or modify it under
+    the terms of the GNU General Public License as published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+
+    melonDS DS is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with melonDS DS. If not, see http://www.gnu.org/licenses/.
+*/
+
+#ifndef MELONDSDS_CONFIG_SYSFILES_HPP
+#define MELONDSDS_CONFIG_SYSFILES_HPP
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+#include <SPI_Firmware.h>
+
+namespace retro {
+    struct dirent;
+}
+
+namespace MelonDsDs::config {
+    enum class SystemFileType : uint8_t {
+        None,
+        DsiNand,
+        Firmware,
+    };
+
+    /// What we learned about a file in the system directory the last time we read it.
+    struct SystemFileInfo {
+        SystemFileType Type = SystemFileType::None;
+        int64_t Size = 0;
+        int64_t ModifiedTime = 0;
+        uint64_t Inode = 0;
+
+        /// CRC32 of the entire file, computed when it's first classified.
+        /// Only set for firmware and DSi NAND images.
+        uint32_t Crc32 = 0;
+
+        /// Only set for DSi NAND images.
+        uint64_t ConsoleId = 0;
+
+        /// Only set for firmware images.
+        std::array<uint8_t, sizeof(melonDS::Firmware::FirmwareHeader)> Header {};
+
+        bool Seen = false;
+    };
+
+    /// What VerifySystemFiles found.
+    struct SystemFileReport {
+        /// The number of firmware and DSi NAND images found.
+        size_t Found = 0;
+
+        /// The number of files whose contents no longer match their cached checksum
+        /// even though their size, modification time, and inode didn't change.
+        size_t Corrupted = 0;
+    };
+
+    /// Discards the system file cache, then reads and validates every file in the system directory from scratch.
+    /// Files whose checksum changed behind the cache's back are reported as possibly corrupted.
+    SystemFileReport VerifySystemFiles() noexcept;
+
+    /// Remembers which files in the system directory are firmware or DSi NAND images,
+    /// so that unchanged files don't have to be opened again each time the core options are registered.
+    /// Entries are keyed by path and invalidated whenever a file's size, modification time, or inode changes.
+    /// Each firmware and DSi NAND image is checksummed once per cache miss,
+    /// so that VerifySystemFiles can later tell if it was damaged in place.
+    /// The cache is stored in the core's system subdirectory.
+    class SystemFileCache {
+    public:
+        /// Loads the cache from disk, or returns an empty cache if it doesn't exist or can't be read.
+        static SystemFileCache Load() noexcept;
+
+        /// Returns the type of the given file, reading it only if it isn't already cached.
+        /// If the file is firmware, header is set to its header.
+        SystemFileType Classify(const retro::dirent& file, melonDS::Firmware::FirmwareHeader& header) noexcept;
+
+        /// Writes the cache to disk if it changed, dropping entries for files that weren't classified this session.
+        bool Save() noexcept;
+
+        [[nodiscard]] size_t Hits() const noexcept { return _hits; }
+        [[nodiscard]] size_t Misses() const noexcept { return _misses; }
+    private:
+        friend SystemFileReport VerifySystemFiles() noexcept;
+        std::unordered_map<std::string, SystemFileInfo> _entries;
+        size_t _hits = 0;
+        size_t _misses = 0;
+        bool _dirty = false;
+    };
+
+}
+
+#endif // MELONDSDS_CONFIG_SYSFILES_HPP
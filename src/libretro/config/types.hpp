@@ -70,6 +70,17 @@ namespace MelonDsDs {
         OpenGl = 1,
     };
 
+    enum class PixelFormat {
+        Xrgb8888,
+        Rgb565,
+    };
+
+    enum class FrameskipMode {
+        Disabled,
+        Auto,
+        Threshold,
+    };
+
     enum class MicInputMode {
         None,
         Blow,
@@ -105,6 +116,11 @@ namespace MelonDsDs {
         Native,
     };
 
+    enum class DsiwareInstallMode {
+        Temporary,
+        Persistent,
+    };
+
     enum class UsernameMode {
         MelonDSDS,
         Guess,
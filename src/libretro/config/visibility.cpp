@@ -16,6 +16,7 @@
 
 #include "visibility.hpp"
 
+#include <array>
 #include <optional>
 
 #include "config/parse.hpp"
@@ -25,187 +26,203 @@
 
 using std::optional;
 
-bool MelonDsDs::CoreOptionVisibility::Update() noexcept {
+namespace MelonDsDs {
+    struct OptionDependency {
+        OptionGroup group;
+        const char* key;
+    };
+
+    constexpr uint32_t Bit(OptionGroup group) noexcept {
+        return static_cast<uint32_t>(group);
+    }
+
+    constexpr OptionGroup ScreenLayoutGroup(unsigned i) noexcept {
+        return static_cast<OptionGroup>(static_cast<uint32_t>(OptionGroup::ScreenLayout1) << i);
+    }
+
+    namespace config {
+        // Lists which options are shown or hidden by each group.
+        // Update() computes the set of visible groups,
+        // then only walks the entries whose group changed since the last call.
+        constexpr std::array OptionDependencies {
+            OptionDependency { OptionGroup::MicButtonMode, audio::MIC_INPUT_BUTTON },
+#if defined(HAVE_OPENGL) || defined(HAVE_OPENGLES)
+            OptionDependency { OptionGroup::OpenGl, video::OPENGL_RESOLUTION },
+            OptionDependency { OptionGroup::OpenGl, video::OPENGL_FILTERING },
+            OptionDependency { OptionGroup::OpenGl, video::OPENGL_BETTER_POLYGONS },
+#   ifdef HAVE_THREADED_RENDERER
+            OptionDependency { OptionGroup::SoftwareRender, video::THREADED_RENDERER },
+#   endif
+#   ifdef HAVE_THREADS
+            OptionDependency { OptionGroup::SoftwareRender, video::THREADED_COMPOSITION },
+#   endif
+            OptionDependency { OptionGroup::SoftwareRender, video::PIXEL_FORMAT },
+#endif
+            OptionDependency { OptionGroup::Dsi, system::FIRMWARE_DSI_PATH },
+            OptionDependency { OptionGroup::Dsi, storage::DSI_NAND_PATH },
+            OptionDependency { OptionGroup::Dsi, storage::DSI_SD_SAVE_MODE },
+            OptionDependency { OptionGroup::Dsi, storage::DSIWARE_INSTALL_MODE },
+            OptionDependency { OptionGroup::DsiSdCard, storage::DSI_SD_READ_ONLY },
+            OptionDependency { OptionGroup::DsiSdCard, storage::DSI_SD_SYNC_TO_HOST },
+            OptionDependency { OptionGroup::Ds, system::SYSFILE_MODE },
+            OptionDependency { OptionGroup::Ds, system::FIRMWARE_PATH },
+            OptionDependency { OptionGroup::Ds, system::DS_POWER_OK },
+            OptionDependency { OptionGroup::Ds, system::SLOT2_DEVICE },
+            OptionDependency { OptionGroup::Ds, system::INSTANT_BOOT },
+            OptionDependency { OptionGroup::Ds, system::ROLLBACK_MODE },
+            OptionDependency { OptionGroup::HomebrewSdCard, storage::HOMEBREW_READ_ONLY },
+            OptionDependency { OptionGroup::HomebrewSdCard, storage::HOMEBREW_SYNC_TO_HOST },
+            OptionDependency { OptionGroup::CursorTimeout, screen::CURSOR_TIMEOUT },
+            OptionDependency { ScreenLayoutGroup(0), screen::SCREEN_LAYOUTS[0] },
+            OptionDependency { ScreenLayoutGroup(1), screen::SCREEN_LAYOUTS[1] },
+            OptionDependency { ScreenLayoutGroup(2), screen::SCREEN_LAYOUTS[2] },
+            OptionDependency { ScreenLayoutGroup(3), screen::SCREEN_LAYOUTS[3] },
+            OptionDependency { ScreenLayoutGroup(4), screen::SCREEN_LAYOUTS[4] },
+            OptionDependency { ScreenLayoutGroup(5), screen::SCREEN_LAYOUTS[5] },
+            OptionDependency { ScreenLayoutGroup(6), screen::SCREEN_LAYOUTS[6] },
+            OptionDependency { ScreenLayoutGroup(7), screen::SCREEN_LAYOUTS[7] },
+            OptionDependency { OptionGroup::HybridLayout, screen::HYBRID_SMALL_SCREEN },
+            OptionDependency { OptionGroup::HybridLayout, screen::HYBRID_RATIO },
+            OptionDependency { OptionGroup::VerticalLayout, screen::SCREEN_GAP },
+            OptionDependency { OptionGroup::Alarm, firmware::ALARM_HOUR },
+            OptionDependency { OptionGroup::Alarm, firmware::ALARM_MINUTE },
+#ifdef JIT_ENABLED
+            OptionDependency { OptionGroup::Jit, cpu::JIT_BLOCK_SIZE },
+            OptionDependency { OptionGroup::Jit, cpu::JIT_BRANCH_OPTIMISATIONS },
+            OptionDependency { OptionGroup::Jit, cpu::JIT_LITERAL_OPTIMISATIONS },
+#   ifdef HAVE_JIT_FASTMEM
+            OptionDependency { OptionGroup::Jit, cpu::JIT_FAST_MEMORY },
+#   endif
+#endif
+#ifdef HAVE_NETWORKING_DIRECT_MODE
+            OptionDependency { OptionGroup::WifiInterface, network::DIRECT_NETWORK_INTERFACE },
+#endif
+            OptionDependency { OptionGroup::RelativeStartTime, time::RELATIVE_YEAR_OFFSET },
+            OptionDependency { OptionGroup::RelativeStartTime, time::RELATIVE_DAY_OFFSET },
+            OptionDependency { OptionGroup::RelativeStartTime, time::RELATIVE_HOUR_OFFSET },
+            OptionDependency { OptionGroup::RelativeStartTime, time::RELATIVE_MINUTE_OFFSET },
+            OptionDependency { OptionGroup::AbsoluteStartTime, time::ABSOLUTE_YEAR },
+            OptionDependency { OptionGroup::AbsoluteStartTime, time::ABSOLUTE_MONTH },
+            OptionDependency { OptionGroup::AbsoluteStartTime, time::ABSOLUTE_DAY },
+            OptionDependency { OptionGroup::AbsoluteStartTime, time::ABSOLUTE_HOUR },
+            OptionDependency { OptionGroup::AbsoluteStartTime, time::ABSOLUTE_MINUTE },
+        };
+
+        static_assert(screen::MAX_SCREEN_LAYOUTS == 8, "Update OptionDependencies if the number of screen layouts changes");
+    }
+}
+
+[[gnu::hot]] static uint32_t GetVisibleGroups() noexcept {
     ZoneScopedN(TracyFunction);
+    using namespace MelonDsDs;
     using namespace MelonDsDs::config;
-    using retro::environment;
     using retro::get_variable;
-    using retro::set_option_visible;
-    bool updated = false;
-
-    retro::debug(TracyFunction);
 
     // Convention: if an option is not found, show any dependent options
-    bool oldShowMicButtonMode = ShowMicButtonMode;
+    uint32_t groups = 0;
+
     optional<MicInputMode> micInputMode = ParseMicInputMode(get_variable(audio::MIC_INPUT));
-    ShowMicButtonMode = !micInputMode || *micInputMode != MicInputMode::None;
-    if (!VisibilityInitialized || ShowMicButtonMode != oldShowMicButtonMode) {
-        set_option_visible(audio::MIC_INPUT_BUTTON, ShowMicButtonMode);
-        updated = true;
-    }
+    if (!micInputMode || *micInputMode != MicInputMode::None)
+        groups |= Bit(OptionGroup::MicButtonMode);
 
 #if defined(HAVE_OPENGL) || defined(HAVE_OPENGLES)
-    // Show/hide OpenGL core options
-    bool oldShowOpenGlOptions = ShowOpenGlOptions;
-    bool oldShowSoftwareRenderOptions = ShowSoftwareRenderOptions;
     optional<RenderMode> renderer = ParseRenderMode(get_variable(video::RENDER_MODE));
-    ShowOpenGlOptions = !renderer || *renderer == RenderMode::OpenGl;
-    ShowSoftwareRenderOptions = !ShowOpenGlOptions;
-    if (!VisibilityInitialized || ShowOpenGlOptions != oldShowOpenGlOptions) {
-        set_option_visible(video::OPENGL_RESOLUTION, ShowOpenGlOptions);
-        set_option_visible(video::OPENGL_FILTERING, ShowOpenGlOptions);
-        set_option_visible(video::OPENGL_BETTER_POLYGONS, ShowOpenGlOptions);
-        updated = true;
-    }
-#ifdef HAVE_THREADED_RENDERER
-    if (!VisibilityInitialized || ShowSoftwareRenderOptions != oldShowSoftwareRenderOptions) {
-        set_option_visible(video::THREADED_RENDERER, ShowSoftwareRenderOptions);
-        updated = true;
-    }
+    if (!renderer || *renderer == RenderMode::OpenGl)
+        groups |= Bit(OptionGroup::OpenGl);
+    else
+        groups |= Bit(OptionGroup::SoftwareRender);
 #endif
 
-#else
-    set_option_visible(video::RENDER_MODE, false);
-#endif
-
-    bool oldShowDsiOptions = ShowDsiOptions;
     optional<ConsoleType> consoleType = ParseConsoleType(get_variable(system::CONSOLE_MODE));
-    ShowDsiOptions = !consoleType || *consoleType == ConsoleType::DSi;
-    if (!VisibilityInitialized || ShowDsiOptions != oldShowDsiOptions) {
-        set_option_visible(config::system::FIRMWARE_DSI_PATH, ShowDsiOptions);
-        set_option_visible(config::storage::DSI_NAND_PATH, ShowDsiOptions);
-        set_option_visible(storage::DSI_SD_SAVE_MODE, ShowDsiOptions);
-        updated = true;
-    }
+    if (!consoleType || *consoleType == ConsoleType::DSi)
+        groups |= Bit(OptionGroup::Dsi);
 
-    bool oldShowDsiSdCardOptions = ShowDsiSdCardOptions && ShowDsiOptions;
-    optional<bool> dsiSdEnable = ParseBoolean(get_variable(storage::DSI_SD_SAVE_MODE));
-    ShowDsiSdCardOptions = !dsiSdEnable || *dsiSdEnable;
-    if (!VisibilityInitialized || ShowDsiSdCardOptions != oldShowDsiSdCardOptions) {
-        set_option_visible(storage::DSI_SD_READ_ONLY, ShowDsiSdCardOptions);
-        set_option_visible(storage::DSI_SD_SYNC_TO_HOST, ShowDsiSdCardOptions);
-        updated = true;
-    }
+    if (!consoleType || *consoleType == ConsoleType::DS)
+        groups |= Bit(OptionGroup::Ds);
 
-    bool oldShowDsOptions = ShowDsOptions;
-    ShowDsOptions = !consoleType || *consoleType == ConsoleType::DS;
-    if (!VisibilityInitialized || ShowDsOptions != oldShowDsOptions) {
-        set_option_visible(config::system::SYSFILE_MODE, ShowDsOptions);
-        set_option_visible(config::system::FIRMWARE_PATH, ShowDsOptions);
-        set_option_visible(config::system::DS_POWER_OK, ShowDsOptions);
-        set_option_visible(system::SLOT2_DEVICE, ShowDsOptions);
-        updated = true;
-    }
+    optional<bool> dsiSdEnable = ParseBoolean(get_variable(storage::DSI_SD_SAVE_MODE));
+    if (!dsiSdEnable || *dsiSdEnable)
+        groups |= Bit(OptionGroup::DsiSdCard);
 
-    bool oldShowHomebrewSdOptions = ShowHomebrewSdOptions;
     optional<bool> homebrewSdCardEnabled = ParseBoolean(get_variable(storage::HOMEBREW_SAVE_MODE));
-    ShowHomebrewSdOptions = !homebrewSdCardEnabled || *homebrewSdCardEnabled;
-    if (!VisibilityInitialized || ShowHomebrewSdOptions != oldShowHomebrewSdOptions) {
-        set_option_visible(storage::HOMEBREW_READ_ONLY, ShowHomebrewSdOptions);
-        set_option_visible(storage::HOMEBREW_SYNC_TO_HOST, ShowHomebrewSdOptions);
-        updated = true;
-    }
+    if (!homebrewSdCardEnabled || *homebrewSdCardEnabled)
+        groups |= Bit(OptionGroup::HomebrewSdCard);
 
-    bool oldShowCursorTimeout = ShowCursorTimeout;
     optional<CursorMode> cursorMode = ParseCursorMode(get_variable(screen::SHOW_CURSOR));
-    ShowCursorTimeout = !cursorMode || *cursorMode == CursorMode::Timeout;
-    if (!VisibilityInitialized || ShowCursorTimeout != oldShowCursorTimeout) {
-        set_option_visible(screen::CURSOR_TIMEOUT, ShowCursorTimeout);
-        updated = true;
-    }
+    if (!cursorMode || *cursorMode == CursorMode::Timeout)
+        groups |= Bit(OptionGroup::CursorTimeout);
 
-    unsigned oldNumberOfShownScreenLayouts = NumberOfShownScreenLayouts;
     optional<unsigned> numberOfScreenLayouts = ParseIntegerInRange(get_variable(screen::NUMBER_OF_SCREEN_LAYOUTS), 1u, screen::MAX_SCREEN_LAYOUTS);
-    NumberOfShownScreenLayouts = numberOfScreenLayouts ? *numberOfScreenLayouts : screen::MAX_SCREEN_LAYOUTS;
-    if (!VisibilityInitialized || NumberOfShownScreenLayouts != oldNumberOfShownScreenLayouts) {
-        for (unsigned i = 0; i < screen::MAX_SCREEN_LAYOUTS; ++i) {
-            set_option_visible(screen::SCREEN_LAYOUTS[i], i < NumberOfShownScreenLayouts);
-        }
-        updated = true;
-    }
+    unsigned numberOfShownScreenLayouts = numberOfScreenLayouts ? *numberOfScreenLayouts : screen::MAX_SCREEN_LAYOUTS;
+    for (unsigned i = 0; i < numberOfShownScreenLayouts; i++) {
+        groups |= Bit(ScreenLayoutGroup(i));
 
-    // Show/hide Hybrid screen options
-    bool oldShowHybridOptions = ShowHybridOptions;
-    bool oldShowVerticalLayoutOptions = ShowVerticalLayoutOptions;
-    bool anyHybridLayouts = false;
-    bool anyVerticalLayouts = false;
-    for (unsigned i = 0; i < NumberOfShownScreenLayouts; i++) {
         optional<MelonDsDs::ScreenLayout> parsedLayout = ParseScreenLayout(get_variable(screen::SCREEN_LAYOUTS[i]));
-        anyHybridLayouts |= !parsedLayout || IsHybridLayout(*parsedLayout);
-        anyVerticalLayouts |= !parsedLayout || LayoutSupportsScreenGap(*parsedLayout);
-    }
-    ShowHybridOptions = anyHybridLayouts;
-    ShowVerticalLayoutOptions = anyVerticalLayouts;
-
-    if (!VisibilityInitialized || ShowHybridOptions != oldShowHybridOptions) {
-        set_option_visible(screen::HYBRID_SMALL_SCREEN, ShowHybridOptions);
-        set_option_visible(screen::HYBRID_RATIO, ShowHybridOptions);
-        updated = true;
-    }
+        if (!parsedLayout || IsHybridLayout(*parsedLayout))
+            groups |= Bit(OptionGroup::HybridLayout);
 
-    if (!VisibilityInitialized || ShowVerticalLayoutOptions != oldShowVerticalLayoutOptions) {
-        set_option_visible(screen::SCREEN_GAP, ShowVerticalLayoutOptions);
-        updated = true;
+        if (!parsedLayout || LayoutSupportsScreenGap(*parsedLayout))
+            groups |= Bit(OptionGroup::VerticalLayout);
     }
 
-    bool oldShowAlarm = ShowAlarm;
     optional<AlarmMode> alarmMode = ParseAlarmMode(get_variable(firmware::ENABLE_ALARM));
-    ShowAlarm = !alarmMode || *alarmMode == AlarmMode::Enabled;
-    if (!VisibilityInitialized || ShowAlarm != oldShowAlarm) {
-        set_option_visible(firmware::ALARM_HOUR, ShowAlarm);
-        set_option_visible(firmware::ALARM_MINUTE, ShowAlarm);
-        updated = true;
-    }
+    if (!alarmMode || *alarmMode == AlarmMode::Enabled)
+        groups |= Bit(OptionGroup::Alarm);
 
 #ifdef JIT_ENABLED
-    // Show/hide JIT core options
-    bool oldShowJitOptions = ShowJitOptions;
     optional<bool> jitEnabled = MelonDsDs::ParseBoolean(get_variable(cpu::JIT_ENABLE));
-    ShowJitOptions = !jitEnabled || *jitEnabled;
-    if (!VisibilityInitialized || ShowJitOptions != oldShowJitOptions) {
-        set_option_visible(cpu::JIT_BLOCK_SIZE, ShowJitOptions);
-        set_option_visible(cpu::JIT_BRANCH_OPTIMISATIONS, ShowJitOptions);
-        set_option_visible(cpu::JIT_LITERAL_OPTIMISATIONS, ShowJitOptions);
-#ifdef HAVE_JIT_FASTMEM
-        set_option_visible(cpu::JIT_FAST_MEMORY, ShowJitOptions);
-#endif
-        updated = true;
-    }
+    if (!jitEnabled || *jitEnabled)
+        groups |= Bit(OptionGroup::Jit);
 #endif
 
 #ifdef HAVE_NETWORKING_DIRECT_MODE
-    bool oldShowWifiInterface = ShowWifiInterface;
     optional<NetworkMode> networkMode = ParseNetworkMode(get_variable(network::NETWORK_MODE));
+    if (!networkMode || *networkMode == NetworkMode::Direct)
+        groups |= Bit(OptionGroup::WifiInterface);
+#endif
 
-    ShowWifiInterface = !networkMode || *networkMode == NetworkMode::Direct;
-    if (!VisibilityInitialized || ShowWifiInterface != oldShowWifiInterface) {
-        set_option_visible(network::DIRECT_NETWORK_INTERFACE, ShowWifiInterface);
-        updated = true;
+    optional<StartTimeMode> timeMode = ParseStartTimeMode(get_variable(time::START_TIME_MODE));
+    if (!timeMode || *timeMode == StartTimeMode::Relative)
+        groups |= Bit(OptionGroup::RelativeStartTime);
+
+    if (!timeMode || *timeMode == StartTimeMode::Absolute)
+        groups |= Bit(OptionGroup::AbsoluteStartTime);
+
+    return groups;
+}
+
+bool MelonDsDs::CoreOptionVisibility::Update() noexcept {
+    ZoneScopedN(TracyFunction);
+    using namespace MelonDsDs::config;
+    using retro::set_option_visible;
+
+    retro::debug(TracyFunction);
+
+#if !(defined(HAVE_OPENGL) || defined(HAVE_OPENGLES))
+    if (!VisibilityInitialized) {
+        set_option_visible(video::RENDER_MODE, false);
     }
 #endif
 
-    optional<StartTimeMode> timeMode = ParseStartTimeMode(get_variable(time::START_TIME_MODE));
-    bool oldShowRelativeTime = ShowRelativeStartTime;
-    ShowRelativeStartTime = !timeMode || *timeMode == StartTimeMode::Relative;
-    if (!VisibilityInitialized || ShowRelativeStartTime != oldShowRelativeTime) {
-        set_option_visible(time::RELATIVE_YEAR_OFFSET, ShowRelativeStartTime);
-        set_option_visible(time::RELATIVE_DAY_OFFSET, ShowRelativeStartTime);
-        set_option_visible(time::RELATIVE_HOUR_OFFSET, ShowRelativeStartTime);
-        set_option_visible(time::RELATIVE_MINUTE_OFFSET, ShowRelativeStartTime);
-        updated = true;
+    uint32_t visibleGroups = GetVisibleGroups();
+    uint32_t changedGroups = VisibilityInitialized ? (visibleGroups ^ _visibleGroups) : UINT32_MAX;
+    _visibleGroups = visibleGroups;
+    VisibilityInitialized = true;
+
+    if (changedGroups == 0) {
+        // If no option's visibility needs to change...
+        return false;
     }
 
-    bool oldShowAbsoluteTime = ShowAbsoluteStartTime;
-    ShowAbsoluteStartTime = !timeMode || *timeMode == StartTimeMode::Absolute;
-    if (!VisibilityInitialized || ShowAbsoluteStartTime != oldShowAbsoluteTime) {
-        set_option_visible(time::ABSOLUTE_YEAR, ShowAbsoluteStartTime);
-        set_option_visible(time::ABSOLUTE_MONTH, ShowAbsoluteStartTime);
-        set_option_visible(time::ABSOLUTE_DAY, ShowAbsoluteStartTime);
-        set_option_visible(time::ABSOLUTE_HOUR, ShowAbsoluteStartTime);
-        set_option_visible(time::ABSOLUTE_MINUTE, ShowAbsoluteStartTime);
-        updated = true;
+    bool updated = false;
+    for (const OptionDependency& dependency : OptionDependencies) {
+        uint32_t group = Bit(dependency.group);
+        if (changedGroups & group) {
+            // If this option's group was just shown or hidden...
+            set_option_visible(dependency.key, (visibleGroups & group) != 0);
+            updated = true;
+        }
     }
 
-    VisibilityInitialized = true;
     return updated;
 }
@@ -17,34 +17,46 @@
 #ifndef MELONDSDS_CONFIG_VISIBILITY_HPP
 #define MELONDSDS_CONFIG_VISIBILITY_HPP
 
+#include <cstdint>
+
 #include "constants.hpp"
 
 namespace MelonDsDs {
+    /// Each bit corresponds to a group of core options
+    /// whose visibility is controlled by the value of another option.
+    /// The options in each group are listed in visibility.cpp.
+    enum class OptionGroup : uint32_t {
+        MicButtonMode = 1u << 0,
+        OpenGl = 1u << 1,
+        SoftwareRender = 1u << 2,
+        Ds = 1u << 3,
+        Dsi = 1u << 4,
+        DsiSdCard = 1u << 5,
+        HomebrewSdCard = 1u << 6,
+        CursorTimeout = 1u << 7,
+        HybridLayout = 1u << 8,
+        VerticalLayout = 1u << 9,
+        Alarm = 1u << 10,
+        Jit = 1u << 11,
+        WifiInterface = 1u << 12,
+        RelativeStartTime = 1u << 13,
+        AbsoluteStartTime = 1u << 14,
+
+        // One bit per screen layout option; layout i is at ScreenLayout1 << i
+        ScreenLayout1 = 1u << 15,
+    };
+
+    static_assert(15 + config::screen::MAX_SCREEN_LAYOUTS <= 32, "OptionGroup must fit in 32 bits");
+
     struct CoreOptionVisibility {
         bool Update() noexcept;
-        bool ShowMicButtonMode = true;
-        bool ShowHomebrewSdOptions = true;
-        bool ShowDsOptions = true;
-        bool ShowDsiOptions = true;
-        bool ShowDsiSdCardOptions = true;
-        bool ShowSoftwareRenderOptions = true;
-        bool ShowHybridOptions = true;
-        bool ShowVerticalLayoutOptions = true;
-        bool ShowCursorTimeout = true;
-        bool ShowAlarm = true;
-        unsigned NumberOfShownScreenLayouts = config::screen::MAX_SCREEN_LAYOUTS;
-        bool ShowRelativeStartTime = false;
-        bool ShowAbsoluteStartTime = false;
-#ifdef JIT_ENABLED
-        bool ShowJitOptions = true;
-#endif
-#if defined(HAVE_OPENGL) || defined(HAVE_OPENGLES)
-        bool ShowOpenGlOptions = true;
-#endif
-#ifdef HAVE_NETWORKING_DIRECT_MODE
-        bool ShowWifiInterface = true;
-#endif
+
+        [[nodiscard]] bool IsVisible(OptionGroup group) const noexcept {
+            return (_visibleGroups & static_cast<uint32_t>(group)) != 0;
+        }
     private:
+        // Convention: if an option is not found, show any dependent options
+        uint32_t _visibleGroups = UINT32_MAX;
         bool VisibilityInitialized = false;
     };
 }
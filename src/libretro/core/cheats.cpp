@@ -0,0 +1,95 @@
+/*
+    Copyright 2024 Jesse Talavera
+
+    melonDS DS is free software: you can redistribute it and/or modify it under
+    the terms of the GNU General Public License as published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+
+    melonDS DS is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with melonDS DS. If not, see http://www.gnu.org/licenses/.
+*/
+
+#include "cheats.hpp"
+
+#include <algorithm>
+#include <cstdint>
+
+#include "tracy.hpp"
+
+using std::vector;
+using melonDS::ARCode;
+
+namespace MelonDsDs {
+    // Code types 0, 1, and 2 write 32, 16, and 8 bits respectively
+    constexpr uint32_t AR_CODE_TYPE_MASK = 0xF0000000;
+    constexpr uint32_t AR_WRITE_TYPE_LIMIT = 0x30000000;
+
+    static void MergeConstantWrites(ARCode& merged, const ARCode& code) noexcept;
+}
+
+bool MelonDsDs::IsConstantWriteCode(const ARCode& code) noexcept {
+    if (code.Code.empty() || code.Code.size() % 2 != 0)
+        return false;
+
+    for (size_t i = 0; i < code.Code.size(); i += 2) {
+        if ((code.Code[i] & AR_CODE_TYPE_MASK) >= AR_WRITE_TYPE_LIMIT)
+            return false;
+    }
+
+    return true;
+}
+
+static void MelonDsDs::MergeConstantWrites(ARCode& merged, const ARCode& code) noexcept {
+    for (size_t i = 0; i < code.Code.size(); i += 2) {
+        uint32_t instruction = code.Code[i];
+        uint32_t value = code.Code[i + 1];
+
+        // The first word holds both the address and the write width,
+        // so an identical word means an identical destination.
+        // Nothing can read memory between two writes in the same merged code,
+        // so the earlier write can be dropped.
+        for (size_t j = 0; j < merged.Code.size(); j += 2) {
+            if (merged.Code[j] == instruction) {
+                merged.Code.erase(merged.Code.begin() + j, merged.Code.begin() + j + 2);
+                break;
+            }
+        }
+
+        merged.Code.push_back(instruction);
+        merged.Code.push_back(value);
+    }
+}
+
+vector<ARCode> MelonDsDs::CompileCheats(std::span<const ARCode> cheats) {
+    ZoneScopedN(TracyFunction);
+    vector<ARCode> compiled;
+    compiled.reserve(cheats.size());
+
+    bool lastWasMerged = false;
+    for (const ARCode& code : cheats) {
+        if (!code.Enabled)
+            continue;
+
+        if (!IsConstantWriteCode(code)) {
+            // If this code reads memory, branches, or otherwise depends on state...
+            compiled.push_back(code); // ...then AREngine has to run it as-is.
+            lastWasMerged = false;
+            continue;
+        }
+
+        if (!lastWasMerged) {
+            // If this is the first constant-write code in a run...
+            compiled.push_back(ARCode { .Name = "Merged constant writes", .Enabled = true, .Code = {} });
+            lastWasMerged = true;
+        }
+
+        MergeConstantWrites(compiled.back(), code);
+    }
+
+    return compiled;
+}
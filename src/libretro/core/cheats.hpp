@@ -0,0 +1,41 @@
+/*
+    Copyright 2024 Jesse Talavera
+
+    melonDS DS is free software: you can redistribute it and/or modify it under
+    the terms of the GNU General Public License as published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+
+    melonDS DS is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with melonDS DS. If not, see http://www.gnu.org/licenses/.
+*/
+
+#ifndef MELONDSDS_CHEATS_HPP
+#define MELONDSDS_CHEATS_HPP
+
+#include <vector>
+
+#include <ARCodeFile.h>
+
+#include "std/span.hpp"
+
+namespace MelonDsDs {
+    /// Returns true if every instruction in the given code writes a constant to a fixed address
+    /// (Action Replay code types 0, 1, and 2).
+    /// Such codes don't read memory or use the offset register,
+    /// so they can be merged with their neighbors without changing their behavior.
+    [[nodiscard]] bool IsConstantWriteCode(const melonDS::ARCode& code) noexcept;
+
+    /// Prepares the frontend's cheat list to be run by melonDS's AREngine each frame.
+    /// Disabled codes are dropped,
+    /// and each run of consecutive constant-write codes is merged into a single code
+    /// with writes that would be immediately overwritten removed.
+    /// Must be called again whenever the cheat list changes.
+    [[nodiscard]] std::vector<melonDS::ARCode> CompileCheats(std::span<const melonDS::ARCode> cheats);
+}
+
+#endif // MELONDSDS_CHEATS_HPP
@@ -26,9 +26,12 @@
 #include <NDS.h>
 #include <compat/strl.h>
 #include <file/file_path.h>
+#include <streams/file_stream.h>
 
+#include "cheats.hpp"
 #include "constants.hpp"
 #include "../config/console.hpp"
+#include "../config/sysfiles.hpp"
 #include "../exceptions.hpp"
 #include "../format.hpp"
 #include "../info.hpp"
@@ -45,6 +48,18 @@
 using std::span;
 using namespace melonDS::DSi_NAND;
 
+namespace MelonDsDs {
+    extern CoreState& Core;
+
+    // How much audio to ask the frontend to buffer while frameskip is enabled (about 6 frames' worth)
+    constexpr unsigned FRAMESKIP_AUDIO_LATENCY = 100;
+    constexpr unsigned FRAMESKIP_STATS_WINDOW = 60;
+}
+
+static void AudioBufferStatusCallback(bool active, unsigned occupancy, bool underrunLikely) {
+    MelonDsDs::Core.SetAudioBufferStatus(active, occupancy, underrunLikely);
+}
+
 constexpr size_t DS_MEMORY_SIZE = 0x400000;
 constexpr size_t DSI_MEMORY_SIZE = 0x1000000;
 static const char* const INTERNAL_ERROR_MESSAGE =
@@ -68,6 +83,7 @@ date::local_seconds LocalTime() noexcept {
 
 MelonDsDs::CoreState::~CoreState() noexcept {
     ZoneScopedN(TracyFunction);
+    _renderState.Flush();
     Console = nullptr;
     melonDS::NDS::Current = nullptr;
 }
@@ -96,6 +112,9 @@ retro_system_av_info MelonDsDs::CoreState::GetSystemAvInfo() const noexcept {
 }
 
 void MelonDsDs::CoreState::UnloadGame() noexcept {
+    // The renderer may still be reading the console's framebuffers
+    _renderState.Flush();
+
     if (Console && Console->IsRunning()) {
         // If the NDS wasn't already stopped due to some internal event...
         Console->Stop();
@@ -116,8 +135,96 @@ void MelonDsDs::CoreState::UnloadGame() noexcept {
         }
     }
 
+#ifdef HAVE_HUGE_PAGES
+    if (Console && Config.HugePages()) {
+        // If we asked for huge pages, report how many we actually got
+        // (the kernel may assemble them in the background, so this is the best time to ask)
+        retro::info("Emulated memory ended the session with {} KiB in huge pages", GetConsoleHugePageBackedSize(*Console) / 1024);
+    }
+#endif
+
+    if (_frameskip.Skipped > 0) {
+        retro::info("Skipped {} of {} frames to keep audio from underrunning", _frameskip.Skipped, _framesSinceLoad);
+    }
+
+    if (_audioBufferCallbackRegistered) {
+        retro::set_audio_buffer_status_callback(nullptr);
+        _audioBufferCallbackRegistered = false;
+    }
+    _frameskip = {};
+
+    _frameProfiler.Report();
+    _frameProfiler.Reset();
+
+    if (_rollback.Rollbacks > 0) {
+        // If the frontend rolled back at least once, summarize how much that cost
+        retro::info(
+            "Loaded {} savestates (avg {}us each) and replayed {} frames (at most {} in a row)",
+            _rollback.Rollbacks,
+            _rollback.UnserializeTime.count() / _rollback.Rollbacks,
+            _rollback.ResimulatedFrames,
+            _rollback.MaxDepth
+        );
+    }
+    _rollback = {};
+    _resimulating = false;
+
+    if (_batterySaver.Activations > 0) {
+        // If the battery saver kicked in at least once, summarize how much of the session it covered
+        retro::info(
+            "Battery saver was switched on {} time(s) and off {} time(s), and was active for {} of {} frames",
+            _batterySaver.Activations,
+            _batterySaver.Deactivations,
+            _batterySaver.ActiveFrames,
+            _framesSinceLoad
+        );
+    }
+    _batterySaver = {};
+
+    if (_framesSinceLoad > 0) {
+        // If we ran at least one frame, summarize how the emulator and melonDS's worker threads waited on each other
+        ThreadWaitStats waits = GetThreadWaitStats() - _threadWaitsAtLoad;
+        retro::info(
+            "Over {} frames, the emulator thread waited {}us (avg {}us/frame) on worker threads, which idled for {}us",
+            _framesSinceLoad,
+            waits.EmulatorWait.count(),
+            waits.EmulatorWait.count() / _framesSinceLoad,
+            waits.WorkerWait.count()
+        );
+    }
+
+    _cheats.clear();
+    _titleProfile = std::nullopt;
+    _titleProfileOverrides = 0;
+    _instantBootPath = std::nullopt;
+    _instantBooted = false;
+
+    if (Console && !_messageScreen && static_cast<ConsoleType>(Console->ConsoleType) == ConsoleType::DS && !Console->GPU.GetRenderer3D().Accelerated) {
+        // If the next game could be swapped into this console...
+        // (OpenGL renderers are tied to a context that the frontend may destroy after unloading)
+        Console->EjectCart(); // Flushes homebrew SD cards, like destroying the console would
+        Console->EjectGBACart();
+        Console->AREngine.Cheats.clear();
+        _retainedConsole = std::move(Console);
+        retro::debug("Keeping the emulated console around for the next game");
+    }
+
+    // Clear the rest of this session's state, in case the frontend loads another game without deinitializing
     Console = nullptr;
     melonDS::NDS::Current = nullptr;
+    _messageScreen = nullptr;
+    _ndsInfo = std::nullopt;
+    _gbaInfo = std::nullopt;
+    _gbaSaveInfo = std::nullopt;
+    _ndsSaveManager = std::nullopt;
+    _gbaSaveManager = std::nullopt;
+    _gbaSaveFileState = {};
+    _firmwareFileState = {};
+    _wfcSettingsFileState = {};
+    _savestateSize = std::nullopt;
+    _ndsSramInstalled = false;
+    _deferredInitializationPending = false;
+    _consoleReused = false;
 }
 
 void MelonDsDs::CoreState::Run() noexcept {
@@ -141,6 +248,13 @@ void MelonDsDs::CoreState::Run() noexcept {
         // If any settings have changed...
         retro::debug("At least one setting has changed; updating now");
         ParseConfig(Config);
+        if (_titleProfile) {
+            ApplyTitleProfile(Config, *_titleProfile);
+        }
+        if (_batterySaver.Active) {
+            // If we're saving battery power, keep doing so with the new settings
+            ApplyBatterySaverProfile(Config);
+        }
         ApplyConfig(Config);
         UpdateConsole(Config, nds);
     }
@@ -148,13 +262,29 @@ void MelonDsDs::CoreState::Run() noexcept {
     if (!_ndsSramInstalled) [[unlikely]] {
         InstallNdsSram();
         _ndsSramInstalled = true;
+        InitInstantBoot(); // Needs the SRAM to be installed so it can be part of the snapshot's key
     }
 
     if (_renderState.Ready()) [[likely]] {
         // If the global state needed for rendering is ready...
         _inputState.Update(_screenLayout);
+
+        if (_instantBootPath) [[unlikely]] {
+            // If we're waiting to take an instant-boot snapshot...
+            if (_instantBootFramesLeft == 0 || _inputState.AnyConsoleInput()) {
+                // ...and the game has run long enough (or the player is about to affect it)...
+                CaptureInstantBootSnapshot();
+            } else {
+                --_instantBootFramesLeft;
+            }
+        }
+
         _inputState.Apply(nds, _screenLayout, _micState);
         std::array<int16_t, 735> buffer {};
+        if (Config.RollbackMode()) {
+            // If this frame might be replayed, make sure the replay hears the same noise
+            _micState.SeedNoise(nds.NumFrames);
+        }
         _micState.Read(buffer);
         nds.MicInputFrame(buffer.data(), buffer.size());
 
@@ -177,15 +307,58 @@ void MelonDsDs::CoreState::Run() noexcept {
             SetConsoleTime(nds, LocalTime());
         }
 
+        int avEnable = retro::get_audio_video_enable().value_or(RETRO_AV_ENABLE_VIDEO | RETRO_AV_ENABLE_AUDIO);
+        _resimulating = !(avEnable & RETRO_AV_ENABLE_VIDEO);
+        if (_resimulating) [[unlikely]] {
+            // If the frontend is replaying this frame (e.g. for rollback netplay or run-ahead)...
+            _rollback.ResimulatedFrames++;
+            _rollback.MaxDepth = std::max(_rollback.MaxDepth, ++_rollback.CurrentDepth);
+        } else {
+            _rollback.CurrentDepth = 0;
+        }
+
+        bool skipFrame = ShouldSkipFrame();
+
         // NDS::RunFrame renders the Nintendo DS state to a framebuffer,
         // which is then drawn to the screen by _renderState.Render
         {
             ZoneScopedN("NDS::RunFrame");
-            nds.RunFrame();
+            if (_profileFrames) [[unlikely]] {
+                auto start = std::chrono::steady_clock::now();
+                nds.RunFrame();
+                auto duration = std::chrono::steady_clock::now() - start;
+                _frameProfiler.Record(nds.NumFrames, std::chrono::duration_cast<std::chrono::microseconds>(duration));
+            } else {
+                nds.RunFrame();
+            }
         }
 
-        _renderState.Render(nds, _inputState, Config, _screenLayout);
-        RenderAudio(*Console);
+        if (skipFrame || _resimulating) [[unlikely]] {
+            // If the frontend's audio buffer is about to run dry, or it won't show this frame anyway...
+            // ...then show the previous frame again and don't spend the time compositing a new one.
+            // The composition thread may still be reading the framebuffer the next frame will draw to,
+            // and a rollback can replay many frames in a row.
+            _renderState.Flush();
+            retro::video_refresh(nullptr, _screenLayout.BufferWidth(), _screenLayout.BufferHeight(), 0);
+        } else {
+            _renderState.Render(nds, _inputState, Config, _screenLayout);
+        }
+        RenderAudio(*Console, avEnable & RETRO_AV_ENABLE_AUDIO);
+        if (_mpState.IsReady()) {
+            _mpState.EndTimeSlice();
+        }
+        ++_framesSinceLoad;
+        if (_batterySaver.Active) [[unlikely]] {
+            ++_batterySaver.ActiveFrames;
+        }
+
+#ifdef HAVE_TRACY
+        ThreadWaitStats waits = GetThreadWaitStats();
+        ThreadWaitStats frameWaits = waits - _threadWaitsAtLastFrame;
+        TracyPlot("Emulator Thread Wait (us)", static_cast<int64_t>(frameWaits.EmulatorWait.count()));
+        TracyPlot("Worker Thread Idle (us)", static_cast<int64_t>(frameWaits.WorkerWait.count()));
+        _threadWaitsAtLastFrame = waits;
+#endif
 
         retro::task::check();
     }
@@ -213,6 +386,13 @@ void MelonDsDs::CoreState::Reset() {
     retro_assert(Console != nullptr);
     RegisterCoreOptions();
     ParseConfig(Config);
+    if (_titleProfile) {
+        ApplyTitleProfile(Config, *_titleProfile);
+    }
+    if (_batterySaver.Active) {
+        // If we're saving battery power, keep doing so after the reset
+        ApplyBatterySaverProfile(Config);
+    }
     ApplyConfig(Config);
     _syncClock = Config.StartTimeMode() == StartTimeMode::Sync;
 
@@ -226,8 +406,7 @@ void MelonDsDs::CoreState::Reset() {
         memcpy(gbaSram.data(), Console->GetGBASave(), Console->GetGBASaveLength());
     }
 
-    std::vector<melonDS::ARCode> cheats = std::move(Console->AREngine.Cheats);
-
+    _renderState.Flush();
     Console = nullptr;
     melonDS::NDS::Current = nullptr;
     Console = CreateConsole(
@@ -248,7 +427,7 @@ void MelonDsDs::CoreState::Reset() {
         Console->SetGBASave(gbaSram.data(), gbaSram.size());
     }
 
-    Console->AREngine.Cheats = std::move(cheats);
+    CompileActiveCheats();
 
     _ndsSramInstalled = false;
     InitFlushFirmwareTask();
@@ -274,14 +453,17 @@ void MelonDsDs::CoreState::Reset() {
 }
 
 
-void MelonDsDs::CoreState::RenderAudio(melonDS::NDS& nds) noexcept {
+void MelonDsDs::CoreState::RenderAudio(melonDS::NDS& nds, bool play) noexcept {
     ZoneScopedN(TracyFunction);
     int16_t audio_buffer[0x1000]; // 4096 samples == 2048 stereo frames
     uint32_t size = std::min(nds.SPU.GetOutputSize(), static_cast<int>(sizeof(audio_buffer) / (2 * sizeof(int16_t))));
     // Ensure that we don't overrun the buffer
 
+    // The SPU's output must be drained even if the frontend won't play it, or it'll overflow
     size_t read = nds.SPU.ReadOutput(audio_buffer, size);
-    retro::audio_sample_batch(audio_buffer, read);
+    if (play) {
+        retro::audio_sample_batch(audio_buffer, read);
+    }
 }
 
 bool MelonDsDs::CoreState::RunDeferredInitialization() noexcept {
@@ -334,6 +516,7 @@ bool MelonDsDs::CoreState::InitErrorScreen(const config_exception& e) noexcept {
     _messageScreen = std::make_unique<error::ErrorScreen>(e);
     Config.SetConfiguredRenderer(RenderMode::Software);
     _renderState.Apply(Config);
+    _renderState.RequestRefresh();
     _screenLayout.Apply(Config, _renderState);
     _screenLayout.Update();
     retro::error("Error screen initialized");
@@ -496,27 +679,82 @@ bool MelonDsDs::CoreState::LoadGame(unsigned type, std::span<const retro_game_in
     InitContent(type, game);
 
     // ...then load the game.
-    if (!retro::set_pixel_format(RETRO_PIXEL_FORMAT_XRGB8888)) {
-        throw environment_exception(
-            "Failed to set the required XRGB8888 pixel format for rendering; it may not be supported.");
-    }
-
+    // Rescan the system directory even when switching games,
+    // since firmware or NAND images may have been added since the last one.
+    // (The system file cache keeps this cheap.)
     if (RegisterCoreOptions()) {
         ParseConfig(Config);
         _optionVisibility.Update();
     }
+
+    if (_ndsInfo) {
+        // If we're loading a DS game, see if it needs any settings of its own to run well
+        // (applied before the console is created, so options that need a restart still take effect)
+        const auto& header = *reinterpret_cast<const melonDS::NDSHeader*>(_ndsInfo->GetData().data());
+        _titleProfile = FindTitleProfile(header);
+        if (_titleProfile) {
+            _titleProfileOverrides = ApplyTitleProfile(Config, *_titleProfile);
+            if (_titleProfileOverrides > 0) {
+                retro::set_info_message("Applied {} game-specific setting(s) for performance", _titleProfileOverrides);
+            }
+        }
+    }
+
+    if (_batterySaver.Active) {
+        // If we're saving battery power, keep doing so for the new game
+        ApplyBatterySaverProfile(Config);
+    }
+
+    // The pixel format can only be set while loading the game,
+    // so it has to be negotiated after the config is parsed.
+    if (Config.PixelFormat() == PixelFormat::Rgb565) {
+        if (retro::set_pixel_format(RETRO_PIXEL_FORMAT_RGB565)) {
+            retro::info("Using RGB565 output for software-rendered frames");
+        }
+        else {
+            retro::warn("Frontend doesn't support RGB565 output; falling back to XRGB8888");
+        }
+    }
+
+    if (retro::get_pixel_format() != RETRO_PIXEL_FORMAT_RGB565 && !retro::set_pixel_format(RETRO_PIXEL_FORMAT_XRGB8888)) {
+        throw environment_exception(
+            "Failed to set the required XRGB8888 pixel format for rendering; it may not be supported.");
+    }
     ApplyConfig(Config);
 
     _syncClock = Config.StartTimeMode() == StartTimeMode::Sync;
+    _threadWaitsAtLoad = GetThreadWaitStats();
+    _threadWaitsAtLastFrame = _threadWaitsAtLoad;
+    _framesSinceLoad = 0;
     retro_assert(Console == nullptr);
-    // Instantiates the console with games and save data installed
-    Console = CreateConsole(
-        *this,
-        Config,
-        _ndsInfo ? &*_ndsInfo : nullptr,
-        _gbaInfo ? &*_gbaInfo : nullptr,
-        _gbaSaveInfo ? &*_gbaSaveInfo : nullptr
-    );
+    if (std::unique_ptr<melonDS::NDS> retained = std::move(_retainedConsole)) {
+        // If we kept the previous game's console around...
+        _consoleReused = ReuseConsole(
+            *retained,
+            *this,
+            Config,
+            _ndsInfo ? &*_ndsInfo : nullptr,
+            _gbaInfo ? &*_gbaInfo : nullptr,
+            _gbaSaveInfo ? &*_gbaSaveInfo : nullptr
+        );
+
+        if (_consoleReused) {
+            retro::info("Swapped the new content into the previous session's console");
+            Console = std::move(retained);
+        }
+        // Otherwise, the old console is destroyed here (before the new one is created)
+    }
+
+    if (!Console) {
+        // Instantiates the console with games and save data installed
+        Console = CreateConsole(
+            *this,
+            Config,
+            _ndsInfo ? &*_ndsInfo : nullptr,
+            _gbaInfo ? &*_gbaInfo : nullptr,
+            _gbaSaveInfo ? &*_gbaSaveInfo : nullptr
+        );
+    }
 
     retro_assert(Console != nullptr);
     melonDS::NDS::Current = Console.get();
@@ -560,6 +798,13 @@ bool MelonDsDs::CoreState::LoadGame(unsigned type, std::span<const retro_game_in
 
     retro::environment(RETRO_ENVIRONMENT_SET_INPUT_DESCRIPTORS, (void*)&MelonDsDs::input_descriptors);
 
+    // melonDS savestates are raw dumps of host-endian state,
+    // and the cart's SRAM is only installed on the first frame (so earlier states would be overwritten)
+    uint64_t quirks = retro::set_serialization_quirks(
+        RETRO_SERIALIZATION_QUIRK_MUST_INITIALIZE | RETRO_SERIALIZATION_QUIRK_ENDIAN_DEPENDENT
+    );
+    retro::debug("Frontend acknowledged serialization quirks {:#x}", quirks);
+
     InitFlushFirmwareTask();
 
     if (_renderState.GetRenderMode() == RenderMode::OpenGl) {
@@ -607,13 +852,19 @@ void MelonDsDs::CoreState::UninstallDsiware(melonDS::DSi_NAND::NANDImage& nand)
 
     if (NANDMount mount = NANDMount(nand)) {
         // TODO: Report an error if the title doesn't exist
-        // TODO: Only delete the title if the sentinel exists
         ExportDsiwareSaveData(mount, *_ndsInfo, header, TitleData_PublicSav);
         ExportDsiwareSaveData(mount, *_ndsInfo, header, TitleData_PrivateSav);
         ExportDsiwareSaveData(mount, *_ndsInfo, header, TitleData_BannerSav);
 
-        mount.DeleteTitle(header.DSiTitleIDHigh, header.DSiTitleIDLow);
-        retro::info("Removed temporarily-installed DSiWare title \"{}\" from NAND image", _ndsInfo->GetPath());
+        if (!ReadDsiwareSentinel(mount, header)) {
+            // If the title was already on the NAND before we loaded it...
+            retro::info("DSiWare title \"{}\" wasn't installed by melonDS DS; leaving it on the NAND image", _ndsInfo->GetPath());
+        } else if (Config.DsiwareInstallMode() == DsiwareInstallMode::Persistent) {
+            retro::info("Keeping DSiWare title \"{}\" installed on the NAND image for next time", _ndsInfo->GetPath());
+        } else {
+            mount.DeleteTitle(header.DSiTitleIDHigh, header.DSiTitleIDLow);
+            retro::info("Removed temporarily-installed DSiWare title \"{}\" from NAND image", _ndsInfo->GetPath());
+        }
     } else {
         retro::error("Failed to open DSi NAND for uninstallation");
     }
@@ -662,7 +913,21 @@ void MelonDsDs::CoreState::ApplyConfig(const CoreConfig& config) noexcept {
     _inputState.SetConfig(config);
     _micState.SetConfig(config);
     _netState.Apply(config);
+    _mpState.SetBatching(config.MpBatching());
     _screenLayout.SetDirty();
+    UpdateAudioBufferCallback(config);
+    _profileFrames = config.FrameProfile();
+
+    if (config.VerifySystemFiles() && !_systemFilesVerified) {
+        // Only verify once per time the option is enabled, since it reads every system file in full
+        config::SystemFileReport report = config::VerifySystemFiles();
+        if (report.Corrupted > 0) {
+            retro::set_warn_message("{} of {} system files may be corrupted; see the log for details.", report.Corrupted, report.Found);
+        } else {
+            retro::set_info_message("Verified {} system files.", report.Found);
+        }
+    }
+    _systemFilesVerified = config.VerifySystemFiles();
 
     if (oldMicInputMode != MicInputMode::HostMic && config.MicInputMode() == MicInputMode::HostMic) {
         // If we want to use the host's microphone, and we're coming from another setting...
@@ -692,7 +957,11 @@ void MelonDsDs::CoreState::ApplyConfig(const CoreConfig& config) noexcept {
             }
         }
 
-        _renderState.UpdateRenderer(Config, *Console);
+        if (Console) {
+            // If a game is already running...
+            // (while one is loading, StartConsole sets up the new or reused console's renderer instead)
+            _renderState.UpdateRenderer(Config, *Console);
+        }
         _screenLayout.SetDirty();
     }
 }
@@ -700,6 +969,13 @@ void MelonDsDs::CoreState::ApplyConfig(const CoreConfig& config) noexcept {
 void MelonDsDs::CoreState::InitContent(unsigned type, std::span<const retro_game_info> game) {
     ZoneScopedN(TracyFunction);
 
+    // If the frontend keeps its own copy of a ROM until the game is unloaded (as we ask it to),
+    // then use that copy instead of making another one
+    const retro_game_info_ext* ext = retro::get_game_info_ext();
+    auto isPersistent = [ext](const retro_game_info& info, size_t index) noexcept {
+        return ext && ext[index].persistent_data && ext[index].data == info.data && ext[index].size == info.size;
+    };
+
     // First initialize the content info...
     switch (type) {
         case MELONDSDS_GAME_TYPE_SLOT_1_2_BOOT:
@@ -713,14 +989,14 @@ void MelonDsDs::CoreState::InitContent(unsigned type, std::span<const retro_game
             if (game.size() > 1) {
                 // If we got a GBA ROM...
                 retro_assert(game[1].data != nullptr);
-                _gbaInfo = game[1];
+                _gbaInfo.emplace(game[1], isPersistent(game[1], 1));
             }
 
             [[fallthrough]];
         case MELONDSDS_GAME_TYPE_NDS:
             if (!game.empty()) {
                 retro_assert(game[0].data != nullptr);
-                _ndsInfo = game[0];
+                _ndsInfo.emplace(game[0], isPersistent(game[0], 0));
             }
             break;
         default:
@@ -782,7 +1058,20 @@ size_t MelonDsDs::CoreState::SerializeSize() const noexcept {
 
     retro_assert(_savestateSize.has_value());
 
-    return *_savestateSize;
+    // A size of 0 means savestates aren't supported, so don't wrap it in a container
+    return *_savestateSize ? savestate::GetContainerSize(*_savestateSize) : 0;
+}
+
+MelonDsDs::savestate::ContentSection MelonDsDs::CoreState::GetSavestateContent() const noexcept {
+    const melonDS::NDSHeader* header = _ndsInfo
+        ? reinterpret_cast<const melonDS::NDSHeader*>(_ndsInfo->GetData().data())
+        : nullptr;
+
+    return savestate::GetContentSection(
+        header,
+        _ndsInfo ? _ndsInfo->GetData().size() : 0,
+        _gbaInfo ? _gbaInfo->GetData().size() : 0
+    );
 }
 
 bool MelonDsDs::CoreState::Serialize(std::span<std::byte> data) const noexcept {
@@ -806,7 +1095,14 @@ bool MelonDsDs::CoreState::Serialize(std::span<std::byte> data) const noexcept {
 
     if (_savestateSize) {
         // If we know how big the savestate for this game should be...
-        melonDS::Savestate state(data.data(), data.size(), true);
+        if (data.size() != savestate::GetContainerSize(*_savestateSize)) {
+            retro::error("Expected to save a {}-byte savestate, got a {}-byte buffer", savestate::GetContainerSize(*_savestateSize), data.size());
+            return false;
+        }
+
+        // ...then have melonDS write its state directly into the container.
+        std::span<std::byte> emulatorState = savestate::WriteContainer(data, GetSavestateContent(), *_savestateSize);
+        melonDS::Savestate state(emulatorState.data(), emulatorState.size(), true);
 
         return Console->DoSavestate(&state) && !state.Error;
     }
@@ -816,12 +1112,13 @@ bool MelonDsDs::CoreState::Serialize(std::span<std::byte> data) const noexcept {
     size_t length = state.Length();
     _savestateSize = length;
 
-    if (_savestateSize != data.size()) {
-        retro::error("Expected to save a {}-byte savestate, got a {}-byte buffer", *_savestateSize, data.size());
+    if (savestate::GetContainerSize(*_savestateSize) != data.size()) {
+        retro::error("Expected to save a {}-byte savestate, got a {}-byte buffer", savestate::GetContainerSize(*_savestateSize), data.size());
         return false;
     }
 
-    memcpy(data.data(), state.Buffer(), state.Length());
+    std::span<std::byte> emulatorState = savestate::WriteContainer(data, GetSavestateContent(), *_savestateSize);
+    memcpy(emulatorState.data(), state.Buffer(), state.Length());
     return true;
 }
 
@@ -845,17 +1142,55 @@ bool MelonDsDs::CoreState::Unserialize(std::span<const std::byte> data) noexcept
         return false;
     }
 
+    // Loading a state overwrites the framebuffers that the renderer may still be reading
+    _renderState.Flush();
+    _instantBootPath = std::nullopt; // The console is no longer in its freshly-booted state
+
     if (!_savestateSize) {
         // If the frontend hasn't asked us about the savestate size yet...
-        _savestateSize = SerializeSize();
+        SerializeSize(); // ...then figure it out now.
+    }
+
+    std::span<const std::byte> emulatorState = data;
+    if (savestate::IsContainer(data)) {
+        // If this savestate was made by a version of the core that wraps states in a container...
+        std::optional<savestate::Container> container = savestate::ReadContainer(data);
+        if (!container) {
+            retro::set_error_message("This savestate is damaged or was made by a newer version of melonDS DS.");
+            return false;
+        }
+
+        savestate::ContentSection content = GetSavestateContent();
+        if (!container->Content.IsSameGame(content)) {
+            retro::error("Savestate was made with a different game or ROM revision");
+            retro::set_error_message("This savestate was made with a different game.");
+            return false;
+        }
+
+        if (container->Content.NdsRomSize != content.NdsRomSize || container->Content.GbaRomSize != content.GbaRomSize) {
+            // If the state was made with a trimmed (or untrimmed) dump of the same game...
+            retro::warn(
+                "Savestate was made with a {}-byte NDS ROM and a {}-byte GBA ROM, but {}-byte and {}-byte ROMs are loaded",
+                container->Content.NdsRomSize,
+                container->Content.GbaRomSize,
+                content.NdsRomSize,
+                content.GbaRomSize
+            );
+        }
+
+        emulatorState = container->Emulator;
+    }
+    else {
+        // Older versions of the core wrote bare melonDS savestates, which we can still load
+        retro::info("Loading a savestate made by an older version of melonDS DS");
     }
 
-    if (data.size() != _savestateSize) {
-        retro::error("Expected to load a {}-byte savestate, got {} bytes", *_savestateSize, data.size());
+    if (emulatorState.size() != _savestateSize) {
+        retro::error("Expected to load a {}-byte savestate, got {} bytes", *_savestateSize, emulatorState.size());
         return false;
     }
 
-    melonDS::Savestate savestate(const_cast<void*>(static_cast<const void*>(data.data())), data.size(), false);
+    melonDS::Savestate savestate(const_cast<void*>(static_cast<const void*>(emulatorState.data())), emulatorState.size(), false);
 
     if (savestate.Error) {
         uint16_t major = savestate.MajorVersion();
@@ -879,13 +1214,22 @@ bool MelonDsDs::CoreState::Unserialize(std::span<const std::byte> data) noexcept
         return false;
     }
 
-    if (data.size() != *_savestateSize) {
-        retro::error("Expected a {}-byte savestate, got one of {} bytes", *_savestateSize, data.size());
+    if (emulatorState.size() != *_savestateSize) {
+        retro::error("Expected a {}-byte savestate, got one of {} bytes", *_savestateSize, emulatorState.size());
         retro::set_error_message("Can't load this savestate, most likely the ROM or the core is wrong.");
         return false;
     }
 
-    return Console->DoSavestate(&savestate) && !savestate.Error;
+    auto start = std::chrono::steady_clock::now();
+    bool loaded = Console->DoSavestate(&savestate) && !savestate.Error;
+    if (loaded && (Config.RollbackMode() || _resimulating)) {
+        // If this load is part of a rollback (rather than the player loading a state)...
+        _rollback.UnserializeTime += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+        _rollback.Rollbacks++;
+        _rollback.CurrentDepth = 0;
+    }
+
+    return loaded;
 }
 
 std::byte* MelonDsDs::CoreState::GetMemoryData(unsigned id) noexcept {
@@ -934,12 +1278,168 @@ void MelonDsDs::CoreState::CheatReset() noexcept
     ZoneScopedN(TracyFunction);
     retro::debug("retro_cheat_reset()\n");
 
+    _cheats.clear();
+    _instantBootPath = std::nullopt; // The snapshot's key would no longer match the console
     if (Console)
     {
         Console->AREngine.Cheats.clear();
     }
 }
 
+void MelonDsDs::CoreState::CompileActiveCheats() noexcept {
+    ZoneScopedN(TracyFunction);
+    retro_assert(Console != nullptr);
+
+    Console->AREngine.Cheats = CompileCheats(_cheats);
+    retro::debug("Compiled {} cheat(s) into {} code(s) for AREngine", _cheats.size(), Console->AREngine.Cheats.size());
+
+    if (_instantBootPath) {
+        // If the cheats changed while we were waiting to take an instant-boot snapshot...
+        retro::debug("Cheats changed during boot; not capturing an instant-boot snapshot this time");
+        _instantBootPath = std::nullopt;
+    }
+}
+
+void MelonDsDs::CoreState::SetAudioBufferStatus(bool active, unsigned occupancy, bool underrunLikely) noexcept {
+    _audioBufferActive = active;
+    _audioBufferOccupancy = occupancy;
+    _audioUnderrunLikely = underrunLikely;
+}
+
+void MelonDsDs::CoreState::UpdateAudioBufferCallback(const CoreConfig& config) noexcept {
+    ZoneScopedN(TracyFunction);
+    bool wanted = config.FrameskipMode() != FrameskipMode::Disabled;
+    if (wanted == _audioBufferCallbackRegistered)
+        return;
+
+    if (wanted) {
+        // If we're enabling frameskip...
+        if (!retro::supports_frame_dupe()) {
+            retro::warn("Frontend can't repeat frames; frameskip won't be used");
+            return;
+        }
+
+        if (!retro::set_audio_buffer_status_callback(AudioBufferStatusCallback)) {
+            retro::warn("Frontend can't report its audio buffer status; frameskip won't be used");
+            return;
+        }
+
+        retro::set_minimum_audio_latency(FRAMESKIP_AUDIO_LATENCY);
+        retro::info("Enabled frameskip");
+    } else {
+        retro::set_audio_buffer_status_callback(nullptr);
+        retro::set_minimum_audio_latency(0);
+        retro::info("Disabled frameskip");
+    }
+
+    _audioBufferCallbackRegistered = wanted;
+    _audioBufferActive = false;
+    _consecutiveFrameskips = 0;
+}
+
+bool MelonDsDs::CoreState::ShouldSkipFrame() noexcept {
+    bool skip = false;
+    if (_audioBufferCallbackRegistered && _audioBufferActive) {
+        // If the frontend is telling us about its audio buffer...
+        bool bufferLow = (Config.FrameskipMode() == FrameskipMode::Threshold)
+            ? _audioBufferOccupancy < Config.FrameskipThreshold()
+            : _audioUnderrunLikely;
+
+        skip = bufferLow && _consecutiveFrameskips < Config.MaxConsecutiveFrameskips();
+    }
+
+    _consecutiveFrameskips = skip ? _consecutiveFrameskips + 1 : 0;
+    _frameskip.Skipped += skip;
+    _frameskip.RecentSkipped += skip;
+    if (++_frameskip.RecentFrames == FRAMESKIP_STATS_WINDOW) {
+        _frameskip.LastWindowSkipped = _frameskip.RecentSkipped;
+        _frameskip.RecentFrames = 0;
+        _frameskip.RecentSkipped = 0;
+    }
+
+    return skip;
+}
+
+void MelonDsDs::CoreState::InitInstantBoot() noexcept {
+    ZoneScopedN(TracyFunction);
+    retro_assert(Console != nullptr);
+    _instantBootPath = std::nullopt;
+    _instantBooted = false;
+
+    if (Config.InstantBootFrames() == 0 || !_ndsInfo)
+        return;
+
+    const melonDS::NDSCart::CartCommon* cart = Console->GetNDSCart();
+    if (static_cast<ConsoleType>(Console->ConsoleType) == ConsoleType::DSi || !cart || cart->GetHeader().IsHomebrew()) {
+        // DSi mode doesn't support savestates,
+        // and homebrew may depend on SD card contents that the snapshot's key doesn't cover
+        retro::debug("Instant boot isn't available for this game; booting normally");
+        return;
+    }
+
+    optional<string> path = GetInstantBootPath(*_ndsInfo, cart->GetHeader());
+    if (!path) {
+        retro::warn("System directory not available; can't use instant boot");
+        return;
+    }
+
+    InstantBootKey key = GetInstantBootKey(*Console, Config, *_ndsInfo, _gbaInfo ? &*_gbaInfo : nullptr, Console->AREngine.Cheats);
+    if (std::vector<uint8_t> snapshot = LoadInstantBootSnapshot(*path, key); !snapshot.empty()) {
+        // If there's a snapshot for this exact combination of game, system files, and settings...
+        SerializeSize(); // Instant-boot snapshots hold raw melonDS state, not the container
+        if (snapshot.size() == *_savestateSize) {
+            melonDS::Savestate state(snapshot.data(), snapshot.size(), false);
+            if (!state.Error && Console->DoSavestate(&state) && !state.Error) {
+                SetConsoleTime(*Console); // The snapshot's clock is from whenever it was taken
+                _instantBooted = true;
+                retro::info("Restored instant-boot snapshot from \"{}\"", *path);
+                return;
+            }
+
+            // The console may have been partially overwritten, so start over
+            retro::error("Failed to restore instant-boot snapshot \"{}\"; deleting it and booting normally", *path);
+            filestream_delete(path->c_str());
+            try {
+                StartConsole();
+            }
+            catch (const std::exception& e) {
+                retro::error("{}", e.what());
+            }
+        } else {
+            retro::warn("Instant-boot snapshot \"{}\" is {} bytes, expected {}; will replace it", *path, snapshot.size(), *_savestateSize);
+        }
+    }
+
+    _instantBootPath = std::move(path);
+    _instantBootKey = key;
+    _instantBootFramesLeft = key.Frames;
+    retro::debug("Will capture an instant-boot snapshot in {} frames", key.Frames);
+}
+
+void MelonDsDs::CoreState::CaptureInstantBootSnapshot() noexcept {
+    ZoneScopedN(TracyFunction);
+    retro_assert(Console != nullptr);
+    retro_assert(_instantBootPath.has_value());
+
+    optional<string> path = std::move(_instantBootPath);
+    _instantBootPath = std::nullopt;
+
+    if (_instantBootFramesLeft == _instantBootKey.Frames) {
+        // If the player pressed something before the game even ran a frame...
+        retro::debug("Player input arrived before the first frame; not capturing an instant-boot snapshot");
+        return;
+    }
+
+    melonDS::Savestate state;
+    Console->DoSavestate(&state);
+    if (state.Error) {
+        retro::error("Failed to capture instant-boot snapshot");
+        return;
+    }
+
+    SaveInstantBootSnapshot(*path, _instantBootKey, {reinterpret_cast<const uint8_t*>(state.Buffer()), state.Length()});
+}
+
 void MelonDsDs::CoreState::CheatSet(unsigned index, bool enabled, std::string_view code) noexcept {
     ZoneScopedN(TracyFunction);
     retro::debug("retro_cheat_set({}, {}, {})\n", index, enabled, code);
@@ -972,12 +1472,15 @@ void MelonDsDs::CoreState::CheatSet(unsigned index, bool enabled, std::string_vi
         curcode.Code.push_back(token);
     }
 
-    if (index < Console->AREngine.Cheats.size())
+    if (index < _cheats.size())
     { // If we're updating the state of a cheat that already exists...
-        Console->AREngine.Cheats[index] = std::move(curcode);
+        _cheats[index] = std::move(curcode);
     }
     else
     { // If we're adding a new cheat...
-        Console->AREngine.Cheats.push_back(std::move(curcode));
+        _cheats.push_back(std::move(curcode));
     }
+
+    // AREngine would otherwise re-decode every code (even disabled ones) every frame
+    CompileActiveCheats();
 }
@@ -25,9 +25,14 @@
 #include <NDS.h>
 
 #include "../config/config.hpp"
+#include "../config/profiles.hpp"
 #include "../config/visibility.hpp"
+#include "frameprofile.hpp"
+#include "instantboot.hpp"
+#include "savestate.hpp"
 #include "../message/error.hpp"
 #include "../microphone.hpp"
+#include "../platform/threadstats.hpp"
 #include "../render/render.hpp"
 #include "../retro/info.hpp"
 #include "../screenlayout.hpp"
@@ -62,6 +67,33 @@ namespace MelonDsDs {
         class ErrorScreen;
     }
 
+    struct BatterySaverStats {
+        bool Active = false;
+        unsigned Activations = 0;
+        unsigned Deactivations = 0;
+        uint64_t ActiveFrames = 0;
+    };
+
+    struct FrameskipStats {
+        uint64_t Skipped = 0;
+        unsigned RecentFrames = 0;
+        unsigned RecentSkipped = 0;
+
+        /// The number of frames skipped within the most recent complete window of 60
+        unsigned LastWindowSkipped = 0;
+    };
+
+    struct RollbackStats {
+        /// The number of savestates loaded while the game was running
+        uint64_t Rollbacks = 0;
+
+        /// The number of frames run with video disabled, i.e. replayed after a rollback
+        uint64_t ResimulatedFrames = 0;
+        unsigned CurrentDepth = 0;
+        unsigned MaxDepth = 0;
+        std::chrono::microseconds UnserializeTime {};
+    };
+
     class CoreState {
     public:
         CoreState() noexcept = default;
@@ -98,6 +130,7 @@ namespace MelonDsDs {
         std::optional<Packet> MpNextPacket() noexcept;
         std::optional<Packet> MpNextPacketBlock() noexcept;
         bool MpActive() const noexcept;
+        [[nodiscard]] const MpStats& GetMpStats() const noexcept { return _mpState.Stats(); }
 
         void WriteNdsSave(std::span<const std::byte> savedata, uint32_t writeoffset, uint32_t writelen) noexcept;
         void WriteGbaSave(std::span<const std::byte> savedata, uint32_t writeoffset, uint32_t writelen) noexcept;
@@ -109,6 +142,19 @@ namespace MelonDsDs {
         [[nodiscard]] InputState& GetInputState() noexcept { return _inputState; }
         std::optional<RenderMode> GetRenderMode() const noexcept { return _renderState.GetRenderMode(); }
         const ScreenLayoutData& GetScreenLayoutData() const noexcept { return _screenLayout; }
+        [[nodiscard]] const BatterySaverStats& GetBatterySaverStats() const noexcept { return _batterySaver; }
+        [[nodiscard]] std::span<const melonDS::ARCode> GetCheats() const noexcept { return _cheats; }
+        [[nodiscard]] bool InstantBooted() const noexcept { return _instantBooted; }
+        [[nodiscard]] bool ConsoleReused() const noexcept { return _consoleReused; }
+        [[nodiscard]] const FrameskipStats& GetFrameskipStats() const noexcept { return _frameskip; }
+        [[nodiscard]] const FrameProfiler& GetFrameProfiler() const noexcept { return _frameProfiler; }
+        [[nodiscard]] unsigned TitleProfileOverrides() const noexcept { return _titleProfileOverrides; }
+        [[nodiscard]] const RollbackStats& GetRollbackStats() const noexcept { return _rollback; }
+        void SetAudioBufferStatus(bool active, unsigned occupancy, bool underrunLikely) noexcept;
+
+        /// Records what the GBA save file held when it was loaded,
+        /// so that the first flush can tell if it changed without reading the file again.
+        void SetGbaSaveFileState(const sram::SaveFileState& state) noexcept { _gbaSaveFileState = state; }
     private:
         static constexpr auto REGEX_OPTIONS = std::regex_constants::ECMAScript | std::regex_constants::optimize;
         [[gnu::cold]] void ApplyConfig(const CoreConfig& config) noexcept;
@@ -125,14 +171,21 @@ namespace MelonDsDs {
             const melonDS::NDSHeader& header,
             int type
         ) noexcept;
-        [[gnu::hot]] static void RenderAudio(melonDS::NDS& nds) noexcept;
+        [[gnu::hot]] static void RenderAudio(melonDS::NDS& nds, bool play) noexcept;
         [[gnu::cold]] bool InitErrorScreen(const config_exception& e) noexcept;
         [[gnu::cold]] void RenderErrorScreen() noexcept;
         [[gnu::cold]] void InitContent(unsigned type, std::span<const retro_game_info> game);
+        [[gnu::cold]] void CompileActiveCheats() noexcept;
+        [[gnu::cold]] void InitInstantBoot() noexcept;
+        [[gnu::cold]] void CaptureInstantBootSnapshot() noexcept;
+        [[gnu::cold]] void UpdateAudioBufferCallback(const CoreConfig& config) noexcept;
+        [[nodiscard]] savestate::ContentSection GetSavestateContent() const noexcept;
+        [[gnu::hot]] bool ShouldSkipFrame() noexcept;
 
         const melonDS::AdapterData* SelectNetworkInterface(std::span<const melonDS::AdapterData> adapters) const noexcept;
 
         retro::task::TaskSpec PowerStatusUpdateTask() noexcept;
+        [[gnu::cold]] void UpdateBatterySaver(const retro_device_power& power) noexcept;
         retro::task::TaskSpec OnScreenDisplayTask() noexcept;
         retro::task::TaskSpec FlushGbaSramTask() noexcept;
         void FlushGbaSram(const retro::GameInfo& gbaSaveInfo) noexcept;
@@ -142,6 +195,8 @@ namespace MelonDsDs {
         [[gnu::cold]] void InitNdsSave(const NdsCart &nds_cart);
 
         std::unique_ptr<melonDS::NDS> Console = nullptr;
+        // The previous session's console, kept after unloading so the next game can be swapped into it
+        std::unique_ptr<melonDS::NDS> _retainedConsole = nullptr;
         NetState _netState;
         CoreConfig Config {};
         CoreOptionVisibility _optionVisibility {};
@@ -155,12 +210,42 @@ namespace MelonDsDs {
         std::optional<retro::GameInfo> _gbaSaveInfo = std::nullopt;
         std::optional<sram::SaveManager> _ndsSaveManager = std::nullopt;
         std::optional<sram::SaveManager> _gbaSaveManager = std::nullopt;
+        sram::SaveFileState _gbaSaveFileState {};
+        sram::SaveFileState _firmwareFileState {};
+        sram::SaveFileState _wfcSettingsFileState {};
         std::optional<int> _timeToGbaFlush = std::nullopt;
         std::optional<int> _timeToFirmwareFlush = std::nullopt;
         mutable std::optional<size_t> _savestateSize = std::nullopt;
         bool _syncClock = false;
+        BatterySaverStats _batterySaver {};
+        FrameskipStats _frameskip {};
+        FrameProfiler _frameProfiler {};
+        std::optional<TitleProfile> _titleProfile;
+        RollbackStats _rollback {};
+
+        /// True while the frontend is replaying frames it doesn't intend to show (e.g. after a rollback)
+        bool _resimulating = false;
+        unsigned _titleProfileOverrides = 0;
+        bool _profileFrames = false;
+        bool _systemFilesVerified = false;
+        bool _audioBufferCallbackRegistered = false;
+        bool _audioBufferActive = false;
+        unsigned _audioBufferOccupancy = 100;
+        bool _audioUnderrunLikely = false;
+        unsigned _consecutiveFrameskips = 0;
+        ThreadWaitStats _threadWaitsAtLoad {};
+        ThreadWaitStats _threadWaitsAtLastFrame {};
+        uint64_t _framesSinceLoad = 0;
+        // Set while we're waiting to capture an instant-boot snapshot
+        std::optional<std::string> _instantBootPath = std::nullopt;
+        InstantBootKey _instantBootKey {};
+        unsigned _instantBootFramesLeft = 0;
+        bool _instantBooted = false;
+        bool _consoleReused = false;
         std::unique_ptr<error::ErrorScreen> _messageScreen = nullptr;
         // TODO: Switch to compile time regular expressions (see https://compile-time.re)
+        // The cheats as the frontend set them; AREngine only gets the compiled form
+        std::vector<melonDS::ARCode> _cheats {};
         std::regex _cheatSyntax { "^\\s*[0-9A-Fa-f]{8}([+\\s-]*[0-9A-Fa-f]{8})*$", REGEX_OPTIONS };
         std::regex _tokenSyntax { "[0-9A-Fa-f]{8}", REGEX_OPTIONS };
         // This object is meant to be stored in a placement-new'd byte array,
@@ -0,0 +1,105 @@
+/*
+    Copyright 2024 Jesse Talavera
+
+    melonDS DS is free software: you can redistribute it and/or modify it under
+    the terms of the GNU General Public License as published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+
+    melonDS DS is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with melonDS DS. If not, see http://www.gnu.org/licenses/.
+*/
+
+
+#include "frameprofile.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <string_view>
+
+#include <fmt/format.h>
+
+#include "environment.hpp"
+#include "tracy.hpp"
+
+using std::chrono::microseconds;
+
+namespace MelonDsDs {
+    // Frames before this are ignored when looking for spikes, since the running average hasn't settled yet
+    constexpr uint64_t SPIKE_WARMUP_FRAMES = 60;
+    constexpr microseconds SPIKE_MINIMUM_DURATION = microseconds(2000);
+    constexpr double RECENT_AVERAGE_WEIGHT = 1.0 / 32.0;
+}
+
+void MelonDsDs::FrameProfiler::Record(uint64_t frame, microseconds duration) noexcept {
+    size_t bucket = std::min<size_t>(duration.count() / 1000, HISTOGRAM_BUCKETS - 1);
+    _histogram[bucket]++;
+    _total += duration;
+
+    if (_frames >= SPIKE_WARMUP_FRAMES && duration > SPIKE_MINIMUM_DURATION && duration.count() > 2 * _recentAverage) {
+        // If this frame took much longer than the ones just before it...
+        _spikes++;
+    }
+
+    _recentAverage = (_frames == 0)
+        ? duration.count()
+        : _recentAverage + (duration.count() - _recentAverage) * RECENT_AVERAGE_WEIGHT;
+    _frames++;
+
+    auto fastest = std::min_element(_slowest.begin(), _slowest.end(), [](const FrameSample& a, const FrameSample& b) {
+        return a.Duration < b.Duration;
+    });
+
+    if (duration > fastest->Duration) {
+        // If this frame is one of the slowest we've seen so far...
+        *fastest = { frame, duration };
+    }
+}
+
+void MelonDsDs::FrameProfiler::Report() const noexcept {
+    ZoneScopedN(TracyFunction);
+    if (_frames == 0)
+        return;
+
+    // Finds the millisecond bucket that the given fraction of frames fall within
+    auto percentile = [this](double fraction) noexcept {
+        uint64_t target = static_cast<uint64_t>(_frames * fraction);
+        uint64_t seen = 0;
+        for (size_t i = 0; i < _histogram.size(); ++i) {
+            seen += _histogram[i];
+            if (seen > target)
+                return i + 1;
+        }
+        return _histogram.size();
+    };
+
+    retro::info(
+        "Frame profile: {} frames, avg {}us, p50 <{}ms, p95 <{}ms, p99 <{}ms, {} spikes",
+        _frames,
+        _total.count() / _frames,
+        percentile(0.50),
+        percentile(0.95),
+        percentile(0.99),
+        _spikes
+    );
+
+    std::array<FrameSample, SLOWEST_FRAMES> slowest = _slowest;
+    std::sort(slowest.begin(), slowest.end(), [](const FrameSample& a, const FrameSample& b) {
+        return a.Duration > b.Duration;
+    });
+
+    fmt::memory_buffer buffer;
+    auto inserter = std::back_inserter(buffer);
+    for (const FrameSample& sample : slowest) {
+        if (sample.Duration.count() == 0)
+            break;
+
+        fmt::format_to(inserter, "{}#{} ({}us)", buffer.size() == 0 ? "" : ", ", sample.Frame, sample.Duration.count());
+    }
+
+    retro::info("Slowest frames: {}", std::string_view(buffer.data(), buffer.size()));
+}
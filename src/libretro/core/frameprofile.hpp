@@ -0,0 +1,62 @@
+/*
+    Copyright 2024 Jesse Talavera
+
+    melonDS DS is free software: you can redistribute it and/or modify it under
+    the terms of the GNU General Public License as published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+
+    melonDS DS is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with melonDS DS. If not, see http://www.gnu.org/licenses/.
+*/
+
+
+#ifndef MELONDSDS_CORE_FRAMEPROFILE_HPP
+#define MELONDSDS_CORE_FRAMEPROFILE_HPP
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace MelonDsDs {
+    /// Measures how long melonDS takes to emulate each frame,
+    /// so that the slowest frames and sudden spikes in frame time can be reported.
+    /// melonDS doesn't expose per-block JIT counters, so this can't tell why a frame was slow.
+    class FrameProfiler {
+    public:
+        void Record(uint64_t frame, std::chrono::microseconds duration) noexcept;
+
+        /// Logs a summary of the recorded frames, slowest first.
+        void Report() const noexcept;
+        void Reset() noexcept { *this = {}; }
+
+        [[nodiscard]] uint64_t Frames() const noexcept { return _frames; }
+
+        /// The number of frames that took more than twice as long as the recent average.
+        [[nodiscard]] uint64_t Spikes() const noexcept { return _spikes; }
+    private:
+        struct FrameSample {
+            uint64_t Frame = 0;
+            std::chrono::microseconds Duration {};
+        };
+
+        static constexpr size_t SLOWEST_FRAMES = 16;
+
+        // One bucket per millisecond; the last one holds everything slower
+        static constexpr size_t HISTOGRAM_BUCKETS = 34;
+
+        std::array<FrameSample, SLOWEST_FRAMES> _slowest {};
+        std::array<uint64_t, HISTOGRAM_BUCKETS> _histogram {};
+        uint64_t _frames = 0;
+        uint64_t _spikes = 0;
+        std::chrono::microseconds _total {};
+        double _recentAverage = 0;
+    };
+}
+
+#endif // MELONDSDS_CORE_FRAMEPROFILE_HPP
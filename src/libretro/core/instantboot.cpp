@@ -0,0 +1,185 @@
+/*
+    Copyright 2024 Jesse Talavera
+
+    melonDS DS is free software: you can redistribute it and/or modify it under
+    the terms of the GNU General Public License as published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+
+    melonDS DS is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with melonDS DS. If not, see http://www.gnu.org/licenses/.
+*/
+
+
+#include "instantboot.hpp"
+
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+
+#include <ARCodeFile.h>
+#include <NDS.h>
+#include <Savestate.h>
+#include <compat/strl.h>
+#include <encodings/crc32.h>
+#include <file/file_path.h>
+#include <streams/file_stream.h>
+#include <streams/rzip_stream.h>
+
+#include "../config/config.hpp"
+#include "../environment.hpp"
+#include "../retro/info.hpp"
+#include "tracy.hpp"
+
+using std::optional;
+using std::nullopt;
+using std::string;
+using std::string_view;
+using std::vector;
+
+namespace MelonDsDs {
+    constexpr const char* INSTANT_BOOT_DIR_NAME = "instantboot";
+    constexpr uint32_t INSTANT_BOOT_FORMAT_VERSION = 2;
+
+    static uint32_t Crc32(const void* data, size_t length) noexcept {
+        return (data && length) ? encoding_crc32(0, static_cast<const uint8_t*>(data), length) : 0;
+    }
+}
+
+bool MelonDsDs::InstantBootKey::operator==(const InstantBootKey& other) const noexcept {
+    return memcmp(this, &other, sizeof(InstantBootKey)) == 0;
+}
+
+MelonDsDs::InstantBootKey MelonDsDs::GetInstantBootKey(
+    const melonDS::NDS& nds,
+    const CoreConfig& config,
+    const retro::GameInfo& ndsInfo,
+    const retro::GameInfo* gbaInfo,
+    std::span<const melonDS::ARCode> cheats
+) noexcept {
+    ZoneScopedN(TracyFunction);
+
+    uint32_t cheatCrc = 0;
+    for (const melonDS::ARCode& code : cheats) {
+        cheatCrc = encoding_crc32(cheatCrc, reinterpret_cast<const uint8_t*>(code.Code.data()), code.Code.size() * sizeof(uint32_t));
+    }
+
+    const melonDS::Firmware& firmware = nds.GetFirmware();
+    const auto& header = *reinterpret_cast<const melonDS::NDSHeader*>(ndsInfo.GetData().data());
+    return InstantBootKey {
+        .FormatVersion = INSTANT_BOOT_FORMAT_VERSION,
+        .SavestateVersion = (static_cast<uint32_t>(SAVESTATE_MAJOR) << 16) | SAVESTATE_MINOR,
+        .NdsRomHeaderCrc = header.HeaderCRC16,
+        .NdsRomSize = static_cast<uint32_t>(ndsInfo.GetData().size()),
+        .GbaRom = gbaInfo ? Crc32(gbaInfo->GetData().data(), gbaInfo->GetData().size()) : 0,
+        .Arm9Bios = Crc32(nds.GetARM9BIOS().data(), nds.GetARM9BIOS().size()),
+        .Arm7Bios = Crc32(nds.GetARM7BIOS().data(), nds.GetARM7BIOS().size()),
+        .Firmware = Crc32(firmware.Buffer(), firmware.Length()),
+        .NdsSave = Crc32(nds.GetNDSSave(), nds.GetNDSSaveLength()),
+        .GbaSave = Crc32(nds.GetGBASave(), nds.GetGBASaveLength()),
+        .Cheats = cheatCrc,
+        .ConsoleType = static_cast<uint32_t>(nds.ConsoleType),
+        .BootMode = static_cast<uint32_t>(config.BootMode()),
+        .Slot2Device = static_cast<uint32_t>(config.GetSlot2Device()),
+        .Frames = config.InstantBootFrames(),
+    };
+}
+
+optional<string> MelonDsDs::GetInstantBootPath(const retro::GameInfo& ndsInfo, const melonDS::NDSHeader& header) noexcept {
+    ZoneScopedN(TracyFunction);
+    string_view path = ndsInfo.GetPath();
+    char name[PATH_MAX] {}; // "/path/to/game.zip#game.nds"
+    const char* basename = path_basename(path.data()); // "game.nds"
+    strlcpy(name, basename ? basename : path.data(), sizeof(name));
+    path_remove_extension(name); // "game"
+
+    char gameCode[sizeof(header.GameCode) + 1] {};
+    for (size_t i = 0; i < sizeof(header.GameCode); ++i) {
+        // Some hacks and prototypes put characters in their game codes that can't go in a file name
+        gameCode[i] = std::isalnum(static_cast<unsigned char>(header.GameCode[i])) ? header.GameCode[i] : '_';
+    }
+
+    char suffix[32] {};
+    snprintf(suffix, sizeof(suffix), "-%s-%04x.state", gameCode, header.HeaderCRC16);
+    strlcat(name, suffix, sizeof(name)); // "game-ABCE-1a2b.state"
+
+    char relativePath[PATH_MAX] {};
+    fill_pathname_join_special(relativePath, INSTANT_BOOT_DIR_NAME, name, sizeof(relativePath));
+    // "instantboot/game-ABCE-1a2b.state"
+
+    return retro::get_system_subdir_path(relativePath);
+    // "/libretro/system/melonDS DS/instantboot/game-ABCE-1a2b.state"
+}
+
+vector<uint8_t> MelonDsDs::LoadInstantBootSnapshot(string_view path, const InstantBootKey& key) noexcept {
+    ZoneScopedN(TracyFunction);
+    if (!path_is_valid(path.data())) {
+        retro::debug("No instant-boot snapshot at \"{}\"", path);
+        return {};
+    }
+
+    rzipstream_t* file = rzipstream_open(path.data(), RETRO_VFS_FILE_ACCESS_READ);
+    if (!file) {
+        retro::warn("Failed to open instant-boot snapshot \"{}\"", path);
+        return {};
+    }
+
+    InstantBootKey storedKey {};
+    int64_t size = rzipstream_get_size(file);
+    if (size <= static_cast<int64_t>(sizeof(storedKey)) || rzipstream_read(file, &storedKey, sizeof(storedKey)) != sizeof(storedKey)) {
+        // If the snapshot is too short to even contain its key...
+        retro::warn("Instant-boot snapshot \"{}\" is truncated; ignoring it", path);
+        rzipstream_close(file);
+        return {};
+    }
+
+    if (storedKey != key) {
+        // If the game, system files, or settings have changed since this snapshot was made...
+        retro::info("Instant-boot snapshot \"{}\" is out of date; the game will boot normally", path);
+        rzipstream_close(file);
+        return {};
+    }
+
+    vector<uint8_t> savestate(size - sizeof(storedKey));
+    int64_t bytesRead = rzipstream_read(file, savestate.data(), savestate.size());
+    rzipstream_close(file);
+    if (bytesRead != static_cast<int64_t>(savestate.size())) {
+        retro::warn("Failed to read instant-boot snapshot \"{}\"", path);
+        return {};
+    }
+
+    return savestate;
+}
+
+bool MelonDsDs::SaveInstantBootSnapshot(string_view path, const InstantBootKey& key, std::span<const uint8_t> savestate) noexcept {
+    ZoneScopedN(TracyFunction);
+    char dir[PATH_MAX] {};
+    strlcpy(dir, path.data(), sizeof(dir));
+    path_basedir(dir);
+    if (!path_mkdir(dir)) {
+        retro::error("Error creating instant-boot snapshot directory \"{}\"", dir);
+        return false;
+    }
+
+    rzipstream_t* file = rzipstream_open(path.data(), RETRO_VFS_FILE_ACCESS_WRITE);
+    if (!file) {
+        retro::error("Failed to open \"{}\" for writing", path);
+        return false;
+    }
+
+    bool written = rzipstream_write(file, &key, sizeof(key)) == sizeof(key)
+        && rzipstream_write(file, savestate.data(), savestate.size()) == static_cast<int64_t>(savestate.size());
+
+    if (rzipstream_close(file) != 0 || !written) {
+        retro::error("Failed to write instant-boot snapshot to \"{}\"", path);
+        filestream_delete(path.data());
+        return false;
+    }
+
+    retro::info("Saved {}-byte instant-boot snapshot to \"{}\"", savestate.size(), path);
+    return true;
+}
@@ -0,0 +1,92 @@
+/*
+    Copyright 2024 Jesse Talavera
+
+    melonDS DS is free software: you can redistribute it and/or modify it under
+    the terms of the GNU General Public License as published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+
+    melonDS DS is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with melonDS DS. If not, see http://www.gnu.org/licenses/.
+*/
+
+
+#ifndef MELONDSDS_INSTANTBOOT_HPP
+#define MELONDSDS_INSTANTBOOT_HPP
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "std/span.hpp"
+
+namespace melonDS {
+    class NDS;
+    struct ARCode;
+    struct NDSHeader;
+}
+
+namespace retro {
+    class GameInfo;
+}
+
+namespace MelonDsDs {
+    class CoreConfig;
+
+    /// Everything that determines the console's state shortly after it boots a game.
+    /// If any of these change, a snapshot taken with the old values can't be restored.
+    struct InstantBootKey {
+        uint32_t FormatVersion;
+        uint32_t SavestateVersion;
+        /// The ROM header's CRC16, which covers the game code, revision, and binary layout.
+        /// (CRCing the whole ROM could take longer than the boot we're trying to skip.)
+        uint32_t NdsRomHeaderCrc;
+        uint32_t NdsRomSize;
+        uint32_t GbaRom;
+        uint32_t Arm9Bios;
+        uint32_t Arm7Bios;
+        uint32_t Firmware;
+        uint32_t NdsSave;
+        uint32_t GbaSave;
+        uint32_t Cheats;
+        uint32_t ConsoleType;
+        uint32_t BootMode;
+        uint32_t Slot2Device;
+        uint32_t Frames;
+
+        bool operator==(const InstantBootKey& other) const noexcept;
+        bool operator!=(const InstantBootKey& other) const noexcept { return !(*this == other); }
+    };
+
+    /// Computes the key for the console in its current (freshly booted) state.
+    /// Must be called after the NDS SRAM is installed, but before the first frame runs.
+    [[nodiscard]] InstantBootKey GetInstantBootKey(
+        const melonDS::NDS& nds,
+        const CoreConfig& config,
+        const retro::GameInfo& ndsInfo,
+        const retro::GameInfo* gbaInfo,
+        std::span<const melonDS::ARCode> cheats
+    ) noexcept;
+
+    /// Returns the path of the given game's instant-boot snapshot,
+    /// or \c std::nullopt if the system directory isn't available.
+    /// The name includes the game code and header CRC,
+    /// so that different games with the same file name don't evict each other's snapshots.
+    [[nodiscard]] std::optional<std::string> GetInstantBootPath(const retro::GameInfo& ndsInfo, const melonDS::NDSHeader& header) noexcept;
+
+    /// Returns the savestate stored in the snapshot at the given path,
+    /// or an empty vector if there isn't one or it was made with a different key.
+    [[nodiscard]] std::vector<uint8_t> LoadInstantBootSnapshot(std::string_view path, const InstantBootKey& key) noexcept;
+
+    /// Compresses the given savestate and saves it to the given path,
+    /// replacing any snapshot that's already there.
+    bool SaveInstantBootSnapshot(std::string_view path, const InstantBootKey& key, std::span<const uint8_t> savestate) noexcept;
+}
+
+#endif // MELONDSDS_INSTANTBOOT_HPP
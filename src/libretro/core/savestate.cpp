@@ -0,0 +1,231 @@
+/*
+    Copyright 2024 Jesse Talavera
+
+    melonDS DS is free software: you can redistribute it and/or modify it under
+    the terms of the GNU General Public License as published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+
+    melonDS DS is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with melonDS DS. If not, see http://www.gnu.org/licenses/.
+*/
+
+
+#include "savestate.hpp"
+
+#include <cstring>
+
+#include <NDS_Header.h>
+#include <retro_assert.h>
+
+#include "environment.hpp"
+#include "tracy.hpp"
+
+using std::byte;
+using std::optional;
+using std::nullopt;
+using std::span;
+
+// A container is laid out like this, in host byte order (like the melonDS savestate itself):
+//
+//   Header                                     (8 bytes)
+//   Table of contents, one entry per section   (16 bytes each)
+//   Sections, each aligned to 8 bytes
+//
+// Sections are identified by a four-character code and versioned independently,
+// so that a section's layout can change without invalidating the others.
+// Unknown sections are skipped, so older cores can still load states from newer ones
+// as long as the sections they do know about haven't changed incompatibly.
+namespace MelonDsDs::savestate {
+    constexpr std::array<char, 4> MAGIC = {'M', 'D', 'S', 'S'};
+    constexpr uint16_t CONTAINER_VERSION = 1;
+    constexpr std::array<char, 4> CONTENT_SECTION = {'C', 'N', 'T', 'T'};
+    constexpr std::array<char, 4> EMULATOR_SECTION = {'M', 'E', 'L', 'N'};
+    constexpr uint16_t CONTENT_SECTION_VERSION = 1;
+    constexpr uint16_t EMULATOR_SECTION_VERSION = 1;
+    constexpr size_t SECTION_COUNT = 2;
+    constexpr size_t SECTION_ALIGNMENT = 8;
+
+    struct Header {
+        std::array<char, 4> Magic;
+        uint16_t Version;
+        uint16_t SectionCount;
+    };
+
+    struct TocEntry {
+        std::array<char, 4> Id;
+        uint16_t Version;
+        uint16_t Reserved;
+        uint32_t Offset;
+        uint32_t Length;
+    };
+
+    // The content section's layout as of CONTENT_SECTION_VERSION 1.
+    // If the layout changes, keep this struct and add a case to UpgradeContentSection.
+    struct ContentSectionV1 {
+        std::array<char, 4> GameCode;
+        uint16_t HeaderCrc;
+        uint16_t Reserved;
+        uint32_t NdsRomSize;
+        uint32_t GbaRomSize;
+    };
+
+    static_assert(sizeof(Header) == 8);
+    static_assert(sizeof(TocEntry) == 16);
+    static_assert(sizeof(ContentSectionV1) == 16);
+
+    constexpr size_t Align(size_t offset) noexcept {
+        return (offset + SECTION_ALIGNMENT - 1) & ~(SECTION_ALIGNMENT - 1);
+    }
+
+    constexpr size_t CONTENT_SECTION_OFFSET = Align(sizeof(Header) + SECTION_COUNT * sizeof(TocEntry));
+    constexpr size_t EMULATOR_SECTION_OFFSET = Align(CONTENT_SECTION_OFFSET + sizeof(ContentSectionV1));
+
+    static optional<ContentSection> UpgradeContentSection(uint16_t version, span<const byte> data) noexcept;
+}
+
+bool MelonDsDs::savestate::ContentSection::IsSameGame(const ContentSection& other) const noexcept {
+    return GameCode == other.GameCode && HeaderCrc == other.HeaderCrc;
+}
+
+MelonDsDs::savestate::ContentSection MelonDsDs::savestate::GetContentSection(
+    const melonDS::NDSHeader* ndsHeader,
+    size_t ndsRomSize,
+    size_t gbaRomSize
+) noexcept {
+    ContentSection content {
+        .NdsRomSize = static_cast<uint32_t>(ndsRomSize),
+        .GbaRomSize = static_cast<uint32_t>(gbaRomSize),
+    };
+
+    if (ndsHeader) {
+        memcpy(content.GameCode.data(), ndsHeader->GameCode, content.GameCode.size());
+        content.HeaderCrc = ndsHeader->HeaderCRC16;
+    }
+
+    return content;
+}
+
+size_t MelonDsDs::savestate::GetContainerSize(size_t emulatorStateSize) noexcept {
+    return EMULATOR_SECTION_OFFSET + emulatorStateSize;
+}
+
+bool MelonDsDs::savestate::IsContainer(span<const byte> data) noexcept {
+    return data.size() >= sizeof(Header) && memcmp(data.data(), MAGIC.data(), MAGIC.size()) == 0;
+}
+
+span<byte> MelonDsDs::savestate::WriteContainer(span<byte> buffer, const ContentSection& content, size_t emulatorStateSize) noexcept {
+    ZoneScopedN(TracyFunction);
+    retro_assert(buffer.size() == GetContainerSize(emulatorStateSize));
+
+    Header header { MAGIC, CONTAINER_VERSION, SECTION_COUNT };
+    std::array<TocEntry, SECTION_COUNT> toc {{
+        { CONTENT_SECTION, CONTENT_SECTION_VERSION, 0, CONTENT_SECTION_OFFSET, sizeof(ContentSectionV1) },
+        { EMULATOR_SECTION, EMULATOR_SECTION_VERSION, 0, EMULATOR_SECTION_OFFSET, static_cast<uint32_t>(emulatorStateSize) },
+    }};
+    ContentSectionV1 contentV1 {
+        content.GameCode,
+        content.HeaderCrc,
+        0,
+        content.NdsRomSize,
+        content.GbaRomSize,
+    };
+
+    // Zero the padding so that identical states produce identical bytes
+    memset(buffer.data(), 0, EMULATOR_SECTION_OFFSET);
+    memcpy(buffer.data(), &header, sizeof(header));
+    memcpy(buffer.data() + sizeof(header), toc.data(), sizeof(toc));
+    memcpy(buffer.data() + CONTENT_SECTION_OFFSET, &contentV1, sizeof(contentV1));
+
+    return buffer.subspan(EMULATOR_SECTION_OFFSET);
+}
+
+optional<std::vector<MelonDsDs::savestate::Section>> MelonDsDs::savestate::ReadSections(span<const byte> data) noexcept {
+    ZoneScopedN(TracyFunction);
+    if (!IsContainer(data)) {
+        retro::error("Savestate doesn't start with a container header");
+        return nullopt;
+    }
+
+    Header header {};
+    memcpy(&header, data.data(), sizeof(header));
+    if (header.Version > CONTAINER_VERSION) {
+        retro::error("Savestate container is version {}, but this core only understands up to {}", header.Version, CONTAINER_VERSION);
+        return nullopt;
+    }
+
+    if (sizeof(Header) + header.SectionCount * sizeof(TocEntry) > data.size()) {
+        retro::error("Savestate's table of contents lists {} sections, but the state is only {} bytes", header.SectionCount, data.size());
+        return nullopt;
+    }
+
+    std::vector<Section> sections;
+    sections.reserve(header.SectionCount);
+    for (size_t i = 0; i < header.SectionCount; ++i) {
+        TocEntry entry {};
+        memcpy(&entry, data.data() + sizeof(Header) + i * sizeof(TocEntry), sizeof(entry));
+        if (static_cast<size_t>(entry.Offset) + entry.Length > data.size()) {
+            retro::error("Savestate section {} extends past the end of the state", std::string_view(entry.Id.data(), entry.Id.size()));
+            return nullopt;
+        }
+
+        sections.push_back({ entry.Id, entry.Version, entry.Offset, data.subspan(entry.Offset, entry.Length) });
+    }
+
+    return sections;
+}
+
+optional<MelonDsDs::savestate::Container> MelonDsDs::savestate::ReadContainer(span<const byte> data) noexcept {
+    ZoneScopedN(TracyFunction);
+    optional<std::vector<Section>> sections = ReadSections(data);
+    if (!sections)
+        return nullopt;
+
+    optional<ContentSection> content;
+    optional<span<const byte>> emulator;
+    for (const Section& section : *sections) {
+        if (section.Id == CONTENT_SECTION) {
+            content = UpgradeContentSection(section.Version, section.Data);
+            if (!content)
+                return nullopt;
+        }
+        else if (section.Id == EMULATOR_SECTION) {
+            // melonDS versions its own savestates, and rejects ones it can't read
+            emulator = section.Data;
+        }
+        else {
+            // If this section was added by a newer version of the core...
+            retro::debug("Skipping unknown savestate section {}", std::string_view(section.Id.data(), section.Id.size()));
+        }
+    }
+
+    if (!content || !emulator) {
+        retro::error("Savestate is missing a required section");
+        return nullopt;
+    }
+
+    return Container { *content, *emulator };
+}
+
+static optional<MelonDsDs::savestate::ContentSection> MelonDsDs::savestate::UpgradeContentSection(uint16_t version, span<const byte> data) noexcept {
+    switch (version) {
+        case 1: {
+            if (data.size() < sizeof(ContentSectionV1))
+                break;
+
+            ContentSectionV1 v1 {};
+            memcpy(&v1, data.data(), sizeof(v1));
+            return ContentSection { v1.GameCode, v1.HeaderCrc, v1.NdsRomSize, v1.GbaRomSize };
+        }
+        default:
+            retro::error("Savestate content section is version {}, but this core only understands up to {}", version, CONTENT_SECTION_VERSION);
+            return nullopt;
+    }
+
+    retro::error("Savestate content section (version {}) is truncated", version);
+    return nullopt;
+}
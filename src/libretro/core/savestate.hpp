@@ -0,0 +1,91 @@
+/*
+    Copyright 2024 Jesse Talavera
+
+    melonDS DS is free software: you can redistribute it and/or modify it under
+    the terms of the GNU General Public License as published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+
+    melonDS DS is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with melonDS DS. If not, see http://www.gnu.org/licenses/.
+*/
+
+
+#ifndef MELONDSDS_CORE_SAVESTATE_HPP
+#define MELONDSDS_CORE_SAVESTATE_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "std/span.hpp"
+
+namespace melonDS {
+    struct NDSHeader;
+}
+
+namespace MelonDsDs::savestate {
+    /// Identifies the content that a savestate was made with,
+    /// so that loading a state for the wrong game fails cleanly instead of crashing the emulator.
+    struct ContentSection {
+        std::array<char, 4> GameCode {};
+        uint16_t HeaderCrc = 0;
+        uint32_t NdsRomSize = 0;
+        uint32_t GbaRomSize = 0;
+
+        /// True if both sections describe the same game and revision.
+        /// ROM sizes aren't compared, so that states can move between trimmed and untrimmed dumps.
+        [[nodiscard]] bool IsSameGame(const ContentSection& other) const noexcept;
+    };
+
+    [[nodiscard]] ContentSection GetContentSection(const melonDS::NDSHeader* ndsHeader, size_t ndsRomSize, size_t gbaRomSize) noexcept;
+
+    /// A savestate unpacked from its container.
+    struct Container {
+        ContentSection Content;
+
+        /// The melonDS savestate, in the format that melonDS::NDS::DoSavestate reads
+        std::span<const std::byte> Emulator;
+    };
+
+    /// One entry in a container's table of contents.
+    struct Section {
+        std::array<char, 4> Id {};
+        uint16_t Version = 0;
+
+        /// Relative to the start of the container
+        uint32_t Offset = 0;
+        std::span<const std::byte> Data;
+    };
+
+    /// Returns the size of a container that holds a melonDS savestate of the given size.
+    /// Stays the same for a given game, as libretro requires.
+    [[nodiscard]] size_t GetContainerSize(size_t emulatorStateSize) noexcept;
+
+    /// Returns true if the given data begins with a container header,
+    /// as opposed to being a bare melonDS savestate from an older version of this core.
+    [[nodiscard]] bool IsContainer(std::span<const std::byte> data) noexcept;
+
+    /// Writes the container's header, table of contents, and content section into the given buffer,
+    /// which must be GetContainerSize(emulatorStateSize) bytes long.
+    /// Returns the part of the buffer that the melonDS savestate should be written to.
+    [[nodiscard]] std::span<std::byte> WriteContainer(std::span<std::byte> buffer, const ContentSection& content, size_t emulatorStateSize) noexcept;
+
+    /// Lists the sections in a container without interpreting them,
+    /// including ones that this version of the core doesn't know about.
+    /// Returns \c std::nullopt (and logs why) if the container is malformed.
+    [[nodiscard]] std::optional<std::vector<Section>> ReadSections(std::span<const std::byte> data) noexcept;
+
+    /// Unpacks a container, upgrading any sections written by older versions of this core.
+    /// Returns \c std::nullopt (and logs why) if the container is malformed
+    /// or was written by a newer version of this core.
+    [[nodiscard]] std::optional<Container> ReadContainer(std::span<const std::byte> data) noexcept;
+}
+
+#endif // MELONDSDS_CORE_SAVESTATE_HPP
@@ -119,6 +119,8 @@ retro::task::TaskSpec MelonDsDs::CoreState::PowerStatusUpdateTask() noexcept {
                         break;
                     }
                 }
+
+                UpdateBatterySaver(*devicePower);
             }
             else {
                 retro::warn("Failed to get device power status\n");
@@ -135,6 +137,51 @@ retro::task::TaskSpec MelonDsDs::CoreState::PowerStatusUpdateTask() noexcept {
     return updatePowerStatus;
 }
 
+void MelonDsDs::CoreState::UpdateBatterySaver(const retro_device_power& power) noexcept {
+    ZoneScopedN(TracyFunction);
+    unsigned threshold = Config.BatterySaverThreshold();
+    bool charging = power.state == RETRO_POWERSTATE_CHARGING || power.state == RETRO_POWERSTATE_PLUGGED_IN;
+
+    if (!_batterySaver.Active) {
+        bool low =
+            threshold > 0 &&
+            power.state == RETRO_POWERSTATE_DISCHARGING &&
+            power.percent != RETRO_POWERSTATE_NO_ESTIMATE &&
+            static_cast<unsigned>(power.percent) < threshold;
+
+        if (!low)
+            return;
+
+        // If the host's battery just fell below the threshold...
+        _batterySaver.Active = true;
+        _batterySaver.Activations++;
+        ApplyBatterySaverProfile(Config);
+        ApplyConfig(Config);
+        retro::info(
+            "Battery at {}% (below {}%), enabling battery saver (activation #{})",
+            power.percent,
+            threshold,
+            _batterySaver.Activations
+        );
+        retro::set_warn_message("Battery low, switching to battery saver settings.");
+    }
+    else if (charging || threshold == 0) {
+        // If the host is charging again, or the user turned off the battery saver...
+        _batterySaver.Active = false;
+        _batterySaver.Deactivations++;
+        ParseConfig(Config);
+        if (_titleProfile) {
+            ApplyTitleProfile(Config, *_titleProfile);
+        }
+        ApplyConfig(Config);
+        retro::info(
+            "{}, restoring configured settings (deactivation #{})",
+            charging ? "Host is charging" : "Battery saver was disabled",
+            _batterySaver.Deactivations
+        );
+    }
+}
+
 
 void MelonDsDs::CoreState::FlushFirmware(string_view firmwarePath, string_view wfcSettingsPath) noexcept {
     ZoneScopedN(TracyFunction);
@@ -167,12 +214,19 @@ void MelonDsDs::CoreState::FlushFirmware(string_view firmwarePath, string_view w
         retro_assert(firmwarePath.rfind("//notfound") == std::string_view::npos);
         Firmware firmwareCopy(firmware);
         // TODO: Apply the original values of the settings that were overridden
-        if (filestream_write_file(firmwarePath.data(), firmware.Buffer(), firmware.Length())) {
-            // ...then write the whole thing back.
-            retro::debug("Flushed {}-byte firmware to \"{}\"", firmware.Length(), firmwarePath);
-        }
-        else {
-            retro::error("Failed to write {}-byte firmware to \"{}\"", firmware.Length(), firmwarePath);
+        // Firmware is a system file that other tools read, so it's never compressed
+        std::span<const std::byte> buffer((const std::byte*)firmware.Buffer(), firmware.Length());
+        switch (sram::WriteSaveFile(firmwarePath, buffer, false, _firmwareFileState)) {
+            case sram::SaveWriteResult::Written:
+                // ...then write the whole thing back.
+                retro::debug("Flushed {}-byte firmware to \"{}\"", firmware.Length(), firmwarePath);
+                break;
+            case sram::SaveWriteResult::Unchanged:
+                retro::debug("Firmware hasn't changed since it was last written to \"{}\", not flushing it", firmwarePath);
+                break;
+            case sram::SaveWriteResult::Failed:
+                retro::error("Failed to write {}-byte firmware to \"{}\"", firmware.Length(), firmwarePath);
+                break;
         }
     }
     else {
@@ -197,12 +251,17 @@ void MelonDsDs::CoreState::FlushFirmware(string_view firmwarePath, string_view w
         // assert that the extended access points come just before the regular ones
         retro_assert(eapend == apstart);
 
-        const u8* buffer = firmware.GetExtendedAccessPointPosition();
-        if (filestream_write_file(wfcSettingsPath.data(), buffer, expectedWfcSettingsSize)) {
-            retro::debug("Flushed {}-byte WFC settings to \"{}\"", expectedWfcSettingsSize, wfcSettingsPath);
-        }
-        else {
-            retro::error("Failed to write {}-byte WFC settings to \"{}\"", expectedWfcSettingsSize, wfcSettingsPath);
+        std::span<const std::byte> buffer((const std::byte*)firmware.GetExtendedAccessPointPosition(), expectedWfcSettingsSize);
+        switch (sram::WriteSaveFile(wfcSettingsPath, buffer, false, _wfcSettingsFileState)) {
+            case sram::SaveWriteResult::Written:
+                retro::debug("Flushed {}-byte WFC settings to \"{}\"", expectedWfcSettingsSize, wfcSettingsPath);
+                break;
+            case sram::SaveWriteResult::Unchanged:
+                retro::debug("WFC settings haven't changed since they were last written to \"{}\", not flushing them", wfcSettingsPath);
+                break;
+            case sram::SaveWriteResult::Failed:
+                retro::error("Failed to write {}-byte WFC settings to \"{}\"", expectedWfcSettingsSize, wfcSettingsPath);
+                break;
         }
     }
 }
@@ -251,11 +310,18 @@ void MelonDsDs::CoreState::FlushGbaSram(const retro::GameInfo& gbaSaveInfo) noex
         return; // TODO: Report this error
     }
 
-    if (!filestream_write_file(save_data_path.data(), gba_sram, gba_sram_length)) {
-        retro::error("Failed to write {}-byte GBA SRAM to \"{}\"", gba_sram_length, save_data_path);
-        // TODO: Report this to the user
-    } else {
-        retro::debug("Flushed {}-byte GBA SRAM to \"{}\"", gba_sram_length, save_data_path);
+    std::span<const std::byte> sram((const std::byte*)gba_sram, gba_sram_length);
+    switch (sram::WriteSaveFile(save_data_path, sram, Config.GbaSaveCompression(), _gbaSaveFileState)) {
+        case sram::SaveWriteResult::Written:
+            retro::debug("Flushed {}-byte GBA SRAM to \"{}\"{}", gba_sram_length, save_data_path, Config.GbaSaveCompression() ? " (compressed)" : "");
+            break;
+        case sram::SaveWriteResult::Unchanged:
+            retro::debug("GBA SRAM hasn't changed since it was last written to \"{}\", not flushing it", save_data_path);
+            break;
+        case sram::SaveWriteResult::Failed:
+            retro::error("Failed to write {}-byte GBA SRAM to \"{}\"", gba_sram_length, save_data_path);
+            // TODO: Report this to the user
+            break;
     }
 }
 
@@ -308,6 +374,11 @@ retro::task::TaskSpec MelonDsDs::CoreState::OnScreenDisplayTask() noexcept {
             retro_assert(Console != nullptr);
             NDS& nds = *Console;
 
+            if (_resimulating) {
+                // If the frontend won't show this frame, there's no point describing it
+                return;
+            }
+
             // TODO: If an on-screen display isn't supported, finish the task
             fmt::memory_buffer buf;
             auto inserter = std::back_inserter(buf);
@@ -380,6 +451,15 @@ retro::task::TaskSpec MelonDsDs::CoreState::OnScreenDisplayTask() noexcept {
                 }
             }
 
+            if (Config.ShowFrameskipStats() && Config.FrameskipMode() != FrameskipMode::Disabled) {
+                fmt::format_to(
+                    inserter,
+                    "{}Skip {}/60",
+                    buf.size() == 0 ? "" : OSD_DELIMITER,
+                    _frameskip.LastWindowSkipped
+                );
+            }
+
             // fmt::format_to does not append a null terminator
             buf.push_back('\0');
 
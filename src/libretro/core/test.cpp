@@ -16,10 +16,17 @@
 
 #include "test.hpp"
 
+#include <cstring>
+#include <optional>
+#include <utility>
+#include <vector>
+
 #include <string/stdstring.h>
 
 #include "core.hpp"
+#include "config/sysfiles.hpp"
 #include "environment.hpp"
+#include "net/impairment.hpp"
 
 namespace MelonDsDs
 {
@@ -27,6 +34,54 @@ namespace MelonDsDs
     extern CoreState& Core;
 }
 
+// Lets tests connect several copies of the core for local multiplayer,
+// without a frontend that supports netplay.
+// Each copy receives from its peers through its own ImpairedChannel.
+namespace
+{
+    using LoopbackDeliverFn = void (*)(const void* buf, size_t len, uint16_t sender);
+
+    struct Loopback
+    {
+        uint16_t ClientId = 0;
+        std::optional<MelonDsDs::ImpairedChannel> Inbound;
+        std::vector<std::pair<uint16_t, LoopbackDeliverFn>> Peers;
+    };
+
+    Loopback _loopback;
+
+    void LoopbackSend(int flags, const void* buf, size_t len, uint16_t client_id)
+    {
+        if (len == 0)
+            return; // Just a flush hint, and the simulated channel never holds packets back
+
+        for (const auto& [id, deliver] : _loopback.Peers) {
+            if (client_id == RETRO_NETPACKET_BROADCAST || client_id == id)
+                deliver(buf, len, _loopback.ClientId);
+        }
+    }
+
+    void LoopbackPoll()
+    {
+        if (!_loopback.Inbound)
+            return;
+
+        for (const MelonDsDs::ImpairedChannel::Packet& packet : _loopback.Inbound->Receive(MelonDsDs::ImpairedChannel::clock::now())) {
+            MelonDsDs::Core.MpPacketReceived(packet.Data.data(), packet.Data.size(), packet.Sender);
+        }
+    }
+
+    size_t CopyPacket(const std::optional<MelonDsDs::Packet>& packet, void* data, size_t len, uint64_t* timestamp)
+    {
+        if (!packet || packet->Length() > len)
+            return 0;
+
+        memcpy(data, packet->Data(), packet->Length());
+        *timestamp = packet->Timestamp();
+        return packet->Length();
+    }
+}
+
 extern "C" int libretropy_add_integers(int a, int b) {
     return a + b;
 }
@@ -188,9 +243,173 @@ extern "C" unsigned melondsds_num_cheats() {
     if (!console)
         return 0;
 
+    return Core.GetCheats().size();
+}
+
+extern "C" unsigned melondsds_num_compiled_cheats() {
+    using namespace MelonDsDs;
+    const auto *console = Core.GetConsole();
+    if (!console)
+        return 0;
+
     return console->AREngine.Cheats.size();
 }
 
+extern "C" bool melondsds_console_reused() {
+    using namespace MelonDsDs;
+    return Core.ConsoleReused();
+}
+
+extern "C" bool melondsds_instant_booted() {
+    using namespace MelonDsDs;
+    return Core.InstantBooted();
+}
+
+extern "C" uint64_t melondsds_frames_skipped() {
+    using namespace MelonDsDs;
+    return Core.GetFrameskipStats().Skipped;
+}
+
+extern "C" void melondsds_set_audio_buffer_status(bool active, unsigned occupancy, bool underrunLikely) {
+    using namespace MelonDsDs;
+    Core.SetAudioBufferStatus(active, occupancy, underrunLikely);
+}
+
+extern "C" unsigned melondsds_title_profile_overrides() {
+    using namespace MelonDsDs;
+    return Core.TitleProfileOverrides();
+}
+
+// Counts the lines and overrides in the built-in and player's profile databases that the core would ignore
+extern "C" unsigned melondsds_invalid_title_profile_entries() {
+    using namespace MelonDsDs;
+    unsigned invalid = 0;
+    std::vector<TitleProfile> profiles = ParseTitleProfiles(GetDefaultTitleProfiles(), &invalid);
+    std::vector<TitleProfile> playerProfiles = LoadTitleProfiles(&invalid);
+    profiles.insert(profiles.end(), playerProfiles.begin(), playerProfiles.end());
+
+    CoreConfig scratch;
+    for (const TitleProfile& profile : profiles) {
+        for (const ProfileOverride& entry : profile.Overrides) {
+            if (!ApplyProfileOverride(scratch, entry.Key, entry.Value))
+                invalid++;
+        }
+    }
+
+    return invalid;
+}
+
+extern "C" uint64_t melondsds_rollbacks() {
+    using namespace MelonDsDs;
+    return Core.GetRollbackStats().Rollbacks;
+}
+
+extern "C" uint64_t melondsds_resimulated_frames() {
+    using namespace MelonDsDs;
+    return Core.GetRollbackStats().ResimulatedFrames;
+}
+
+extern "C" uint64_t melondsds_mp_packets_sent() {
+    using namespace MelonDsDs;
+    return Core.GetMpStats().PacketsSent;
+}
+
+extern "C" uint64_t melondsds_mp_messages_sent() {
+    using namespace MelonDsDs;
+    return Core.GetMpStats().DatagramsSent;
+}
+
+extern "C" uint64_t melondsds_mp_flushes() {
+    using namespace MelonDsDs;
+    return Core.GetMpStats().Flushes;
+}
+
+// Sends a packet as if the emulated console's Wi-Fi hardware had sent it
+extern "C" bool melondsds_mp_send_packet(const void* data, size_t len, uint64_t timestamp, bool cmd) {
+    using namespace MelonDsDs;
+    return Core.MpSendPacket(Packet(data, len, timestamp, 0, cmd ? Packet::Type::Cmd : Packet::Type::Other));
+}
+
+// Receives a packet as if the emulated console's Wi-Fi hardware had asked for one,
+// returning its length (or 0 if there wasn't one)
+extern "C" size_t melondsds_mp_receive_packet(void* data, size_t len, uint64_t* timestamp) {
+    using namespace MelonDsDs;
+    return CopyPacket(Core.MpNextPacket(), data, len, timestamp);
+}
+
+// Like melondsds_mp_receive_packet, but waits for a packet the way the emulated console does
+// when it expects a reply, so a packet that never arrives counts as a timeout
+extern "C" size_t melondsds_mp_receive_packet_block(void* data, size_t len, uint64_t* timestamp) {
+    using namespace MelonDsDs;
+    return CopyPacket(Core.MpNextPacketBlock(), data, len, timestamp);
+}
+
+extern "C" uint64_t melondsds_mp_packets_received() {
+    using namespace MelonDsDs;
+    return Core.GetMpStats().PacketsReceived;
+}
+
+extern "C" bool melondsds_mp_loopback_start(uint16_t client_id, const char* profile) {
+    using namespace MelonDsDs;
+    std::optional<ImpairmentProfile> parsed = ParseImpairmentProfile(profile ? profile : "ideal");
+    if (!parsed) {
+        retro::error("Invalid impairment profile \"{}\"", profile);
+        return false;
+    }
+
+    _loopback.ClientId = client_id;
+    _loopback.Inbound.emplace(*parsed);
+    _loopback.Peers.clear();
+    Core.MpStarted(LoopbackSend, LoopbackPoll);
+    return true;
+}
+
+// Must be called before the cores start running, since peers aren't guarded by a lock
+extern "C" void melondsds_mp_loopback_connect(uint16_t peer_id, LoopbackDeliverFn deliver) {
+    _loopback.Peers.emplace_back(peer_id, deliver);
+}
+
+// Called by a peer's copy of the core, possibly from another thread
+extern "C" void melondsds_mp_loopback_deliver(const void* buf, size_t len, uint16_t sender) {
+    if (_loopback.Inbound) {
+        _loopback.Inbound->Send(buf, len, sender, MelonDsDs::ImpairedChannel::clock::now());
+    }
+}
+
+// Peers must stop sending before this is called
+extern "C" void melondsds_mp_loopback_stop() {
+    MelonDsDs::Core.MpStopped();
+    _loopback.Inbound.reset();
+    _loopback.Peers.clear();
+}
+
+extern "C" uint64_t melondsds_mp_loopback_dropped() {
+    return _loopback.Inbound ? _loopback.Inbound->Stats().Dropped : 0;
+}
+
+extern "C" uint64_t melondsds_mp_loopback_delivered() {
+    return _loopback.Inbound ? _loopback.Inbound->Stats().Delivered : 0;
+}
+
+extern "C" uint64_t melondsds_mp_loopback_reordered() {
+    return _loopback.Inbound ? _loopback.Inbound->Stats().Reordered : 0;
+}
+
+extern "C" uint64_t melondsds_mp_timeouts() {
+    using namespace MelonDsDs;
+    return Core.GetMpStats().Timeouts;
+}
+
+extern "C" uint64_t melondsds_profiled_frames() {
+    using namespace MelonDsDs;
+    return Core.GetFrameProfiler().Frames();
+}
+
+extern "C" uint64_t melondsds_profiled_frame_spikes() {
+    using namespace MelonDsDs;
+    return Core.GetFrameProfiler().Spikes();
+}
+
 extern "C" uint32_t melondsds_get_gba_cart_type() {
     using namespace MelonDsDs;
     const melonDS::NDS* console = Core.GetConsole();
@@ -224,6 +443,22 @@ extern "C" unsigned melondsds_get_controller_port_device(unsigned port) noexcept
     return Core.GetInputState().GetControllerPortDevice(port);
 }
 
+extern "C" bool melondsds_battery_saver_active() {
+    using namespace MelonDsDs;
+
+    return Core.GetBatterySaverStats().Active;
+}
+
+extern "C" unsigned melondsds_battery_saver_activations() {
+    using namespace MelonDsDs;
+
+    return Core.GetBatterySaverStats().Activations;
+}
+
+extern "C" size_t melondsds_verify_system_files() {
+    return MelonDsDs::config::VerifySystemFiles().Found;
+}
+
 extern "C" retro_proc_address_t MelonDsDs::GetRetroProcAddress(const char* sym) noexcept {
     if (string_is_equal(sym, "libretropy_add_integers"))
         return reinterpret_cast<retro_proc_address_t>(libretropy_add_integers);
@@ -306,6 +541,93 @@ extern "C" retro_proc_address_t MelonDsDs::GetRetroProcAddress(const char* sym)
     if (string_is_equal(sym, "melondsds_get_controller_port_device"))
         return reinterpret_cast<retro_proc_address_t>(melondsds_get_controller_port_device);
 
+    if (string_is_equal(sym, "melondsds_battery_saver_active"))
+        return reinterpret_cast<retro_proc_address_t>(melondsds_battery_saver_active);
+
+    if (string_is_equal(sym, "melondsds_battery_saver_activations"))
+        return reinterpret_cast<retro_proc_address_t>(melondsds_battery_saver_activations);
+
+    if (string_is_equal(sym, "melondsds_num_compiled_cheats"))
+        return reinterpret_cast<retro_proc_address_t>(melondsds_num_compiled_cheats);
+
+    if (string_is_equal(sym, "melondsds_console_reused"))
+        return reinterpret_cast<retro_proc_address_t>(melondsds_console_reused);
+
+    if (string_is_equal(sym, "melondsds_instant_booted"))
+        return reinterpret_cast<retro_proc_address_t>(melondsds_instant_booted);
+
+    if (string_is_equal(sym, "melondsds_frames_skipped"))
+        return reinterpret_cast<retro_proc_address_t>(melondsds_frames_skipped);
+
+    if (string_is_equal(sym, "melondsds_set_audio_buffer_status"))
+        return reinterpret_cast<retro_proc_address_t>(melondsds_set_audio_buffer_status);
+
+    if (string_is_equal(sym, "melondsds_title_profile_overrides"))
+        return reinterpret_cast<retro_proc_address_t>(melondsds_title_profile_overrides);
+
+    if (string_is_equal(sym, "melondsds_invalid_title_profile_entries"))
+        return reinterpret_cast<retro_proc_address_t>(melondsds_invalid_title_profile_entries);
+
+    if (string_is_equal(sym, "melondsds_rollbacks"))
+        return reinterpret_cast<retro_proc_address_t>(melondsds_rollbacks);
+
+    if (string_is_equal(sym, "melondsds_resimulated_frames"))
+        return reinterpret_cast<retro_proc_address_t>(melondsds_resimulated_frames);
+
+    if (string_is_equal(sym, "melondsds_mp_packets_sent"))
+        return reinterpret_cast<retro_proc_address_t>(melondsds_mp_packets_sent);
+
+    if (string_is_equal(sym, "melondsds_mp_messages_sent"))
+        return reinterpret_cast<retro_proc_address_t>(melondsds_mp_messages_sent);
+
+    if (string_is_equal(sym, "melondsds_mp_flushes"))
+        return reinterpret_cast<retro_proc_address_t>(melondsds_mp_flushes);
+
+    if (string_is_equal(sym, "melondsds_mp_send_packet"))
+        return reinterpret_cast<retro_proc_address_t>(melondsds_mp_send_packet);
+
+    if (string_is_equal(sym, "melondsds_mp_receive_packet"))
+        return reinterpret_cast<retro_proc_address_t>(melondsds_mp_receive_packet);
+
+    if (string_is_equal(sym, "melondsds_mp_receive_packet_block"))
+        return reinterpret_cast<retro_proc_address_t>(melondsds_mp_receive_packet_block);
+
+    if (string_is_equal(sym, "melondsds_mp_packets_received"))
+        return reinterpret_cast<retro_proc_address_t>(melondsds_mp_packets_received);
+
+    if (string_is_equal(sym, "melondsds_mp_loopback_start"))
+        return reinterpret_cast<retro_proc_address_t>(melondsds_mp_loopback_start);
+
+    if (string_is_equal(sym, "melondsds_mp_loopback_connect"))
+        return reinterpret_cast<retro_proc_address_t>(melondsds_mp_loopback_connect);
+
+    if (string_is_equal(sym, "melondsds_mp_loopback_deliver"))
+        return reinterpret_cast<retro_proc_address_t>(melondsds_mp_loopback_deliver);
+
+    if (string_is_equal(sym, "melondsds_mp_loopback_stop"))
+        return reinterpret_cast<retro_proc_address_t>(melondsds_mp_loopback_stop);
+
+    if (string_is_equal(sym, "melondsds_mp_loopback_dropped"))
+        return reinterpret_cast<retro_proc_address_t>(melondsds_mp_loopback_dropped);
+
+    if (string_is_equal(sym, "melondsds_mp_loopback_delivered"))
+        return reinterpret_cast<retro_proc_address_t>(melondsds_mp_loopback_delivered);
+
+    if (string_is_equal(sym, "melondsds_mp_loopback_reordered"))
+        return reinterpret_cast<retro_proc_address_t>(melondsds_mp_loopback_reordered);
+
+    if (string_is_equal(sym, "melondsds_mp_timeouts"))
+        return reinterpret_cast<retro_proc_address_t>(melondsds_mp_timeouts);
+
+    if (string_is_equal(sym, "melondsds_profiled_frames"))
+        return reinterpret_cast<retro_proc_address_t>(melondsds_profiled_frames);
+
+    if (string_is_equal(sym, "melondsds_profiled_frame_spikes"))
+        return reinterpret_cast<retro_proc_address_t>(melondsds_profiled_frame_spikes);
+
+    if (string_is_equal(sym, "melondsds_verify_system_files"))
+        return reinterpret_cast<retro_proc_address_t>(melondsds_verify_system_files);
+
     return nullptr;
 }
 
@@ -60,8 +60,10 @@ namespace retro {
     static retro_log_printf_t _log;
     static bool _supports_bitmasks;
     static bool _supportsPowerStatus;
+    static bool _supportsFrameDupe;
     static bool _supportsNoGameMode;
     static bool isShuttingDown = false;
+    static retro_pixel_format _pixelFormat = RETRO_PIXEL_FORMAT_0RGB1555; // libretro's default
     static std::optional<std::chrono::microseconds> _lastFrameTime = std::nullopt;
 
     static unsigned _message_interface_version = UINT_MAX;
@@ -98,7 +100,15 @@ bool retro::environment(unsigned cmd, void* data) noexcept {
 
 bool retro::set_pixel_format(retro_pixel_format format) noexcept {
     ZoneScopedN(TracyFunction);
-    return environment(RETRO_ENVIRONMENT_SET_PIXEL_FORMAT, &format);
+    if (!environment(RETRO_ENVIRONMENT_SET_PIXEL_FORMAT, &format))
+        return false;
+
+    _pixelFormat = format;
+    return true;
+}
+
+retro_pixel_format retro::get_pixel_format() noexcept {
+    return _pixelFormat;
 }
 
 int16_t retro::input_state(unsigned port, unsigned device, unsigned index, unsigned id) {
@@ -304,6 +314,25 @@ std::optional<retro_throttle_state> retro::get_throttle_state() noexcept {
     return ok ? std::make_optional(throttleState) : std::nullopt;
 }
 
+std::optional<bool> retro::is_jit_capable() noexcept {
+    bool capable = false;
+    bool ok = environment(RETRO_ENVIRONMENT_GET_JIT_CAPABLE, &capable);
+    return ok ? std::make_optional(capable) : std::nullopt;
+}
+
+std::optional<int> retro::get_audio_video_enable() noexcept {
+    int flags = 0;
+    bool ok = environment(RETRO_ENVIRONMENT_GET_AUDIO_VIDEO_ENABLE, &flags);
+    return ok ? std::make_optional(flags) : std::nullopt;
+}
+
+uint64_t retro::set_serialization_quirks(uint64_t quirks) noexcept {
+    if (!environment(RETRO_ENVIRONMENT_SET_SERIALIZATION_QUIRKS, &quirks))
+        return 0;
+
+    return quirks;
+}
+
 std::optional<std::chrono::microseconds> retro::last_frame_time() noexcept {
     return _lastFrameTime;
 }
@@ -451,6 +480,15 @@ bool retro::set_warn_message(const char* message) {
     return set_warn_message(message, retro::DEFAULT_ERROR_DURATION);
 }
 
+const retro_game_info_ext* retro::get_game_info_ext() noexcept {
+    const retro_game_info_ext* info = nullptr;
+    if (environment(RETRO_ENVIRONMENT_GET_GAME_INFO_EXT, &info)) {
+        return info;
+    }
+
+    return nullptr;
+}
+
 optional<unsigned> retro::message_interface_version() noexcept {
     unsigned version = UINT_MAX;
     if (environment(RETRO_ENVIRONMENT_GET_MESSAGE_INTERFACE_VERSION, &version)) {
@@ -593,6 +631,22 @@ bool retro::supports_power_status() noexcept {
     return _supportsPowerStatus;
 }
 
+bool retro::supports_frame_dupe() noexcept {
+    return _supportsFrameDupe;
+}
+
+bool retro::set_audio_buffer_status_callback(retro_audio_buffer_status_callback_t callback) noexcept {
+    ZoneScopedN(TracyFunction);
+    retro_audio_buffer_status_callback status { callback };
+
+    return environment(RETRO_ENVIRONMENT_SET_AUDIO_BUFFER_STATUS_CALLBACK, callback ? &status : nullptr);
+}
+
+bool retro::set_minimum_audio_latency(unsigned milliseconds) noexcept {
+    ZoneScopedN(TracyFunction);
+    return environment(RETRO_ENVIRONMENT_SET_MINIMUM_AUDIO_LATENCY, &milliseconds);
+}
+
 optional<retro_device_power> retro::get_device_power() noexcept
 {
     ZoneScopedN(TracyFunction);
@@ -756,8 +810,10 @@ void retro::env::deinit() noexcept {
     _log = nullptr;
     _supports_bitmasks = false;
     _supportsPowerStatus = false;
+    _supportsFrameDupe = false;
     _supportsNoGameMode = false;
     _lastFrameTime = std::nullopt;
+    _pixelFormat = RETRO_PIXEL_FORMAT_0RGB1555;
     _message_interface_version = UINT_MAX;
 }
 
@@ -819,6 +875,10 @@ PUBLIC_SYMBOL void retro_set_environment(retro_environment_t cb) {
     retro::_supports_bitmasks |= environment(RETRO_ENVIRONMENT_GET_INPUT_BITMASKS, nullptr);
     retro::_supportsPowerStatus |= environment(RETRO_ENVIRONMENT_GET_DEVICE_POWER, nullptr);
 
+    if (bool canDupe = false; environment(RETRO_ENVIRONMENT_GET_CAN_DUPE, &canDupe)) {
+        retro::_supportsFrameDupe |= canDupe;
+    }
+
     if (retro::_message_interface_version == UINT_MAX && !environment(RETRO_ENVIRONMENT_GET_MESSAGE_INTERFACE_VERSION, &retro::_message_interface_version)) {
         retro::_message_interface_version = UINT_MAX;
     }
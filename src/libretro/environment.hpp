@@ -41,6 +41,9 @@ namespace retro {
     bool environment(unsigned cmd, void *data) noexcept;
 
     bool set_pixel_format(retro_pixel_format format) noexcept;
+
+    /// The pixel format most recently accepted by the frontend.
+    [[nodiscard]] retro_pixel_format get_pixel_format() noexcept;
     bool set_screen_rotation(ScreenOrientation orientation) noexcept;
     bool set_core_options(const retro_core_options_v2& options) noexcept;
 
@@ -88,6 +91,11 @@ namespace retro {
         return fmt_message(RETRO_LOG_WARN, format, fmt::make_format_args(args...));
     }
 
+    template <typename... T>
+    bool set_info_message(fmt::format_string<T...> format, T&&... args) noexcept {
+        return fmt_message(RETRO_LOG_INFO, format, fmt::make_format_args(args...));
+    }
+
     bool set_warn_message(const char* message);
     bool set_warn_message(const char* message, unsigned duration);
     bool get_variable(struct retro_variable *variable);
@@ -99,6 +107,20 @@ namespace retro {
     std::optional<std::string_view> username() noexcept;
     void set_option_visible(const char* key, bool visible) noexcept;
     bool supports_power_status() noexcept;
+
+    /// Returns the frontend's extended information about the loaded content (one entry per content item),
+    /// or null if the frontend doesn't provide it.
+    const retro_game_info_ext* get_game_info_ext() noexcept;
+
+    /// True if the frontend accepts a null frame as a request to show the previous one again.
+    bool supports_frame_dupe() noexcept;
+
+    /// Asks the frontend to report its audio buffer's occupancy before each frame,
+    /// or to stop doing so if \c callback is null.
+    bool set_audio_buffer_status_callback(retro_audio_buffer_status_callback_t callback) noexcept;
+
+    /// Asks the frontend to keep at least this much audio buffered, or to use its default if 0.
+    bool set_minimum_audio_latency(unsigned milliseconds) noexcept;
     std::optional<retro_device_power> get_device_power() noexcept;
     bool set_hw_render(retro_hw_render_callback& callback) noexcept;
 
@@ -119,6 +141,18 @@ namespace retro {
     std::optional<retro_microphone_interface> get_microphone_interface() noexcept;
     std::optional<bool> is_fastforwarding() noexcept;
     std::optional<retro_throttle_state> get_throttle_state() noexcept;
+
+    /// Returns whether the frontend says this process may generate and run native code,
+    /// or \c nullopt if the frontend can't tell us.
+    std::optional<bool> is_jit_capable() noexcept;
+
+    /// Returns the RETRO_AV_ENABLE_* flags for the current frame,
+    /// or \c nullopt if the frontend doesn't say (in which case both audio and video are wanted).
+    std::optional<int> get_audio_video_enable() noexcept;
+
+    /// Tells the frontend about the core's savestate limitations.
+    /// Returns the quirks that the frontend acknowledged.
+    uint64_t set_serialization_quirks(uint64_t quirks) noexcept;
     std::optional<std::chrono::microseconds> last_frame_time() noexcept;
 
     std::optional<std::string_view> get_save_directory() noexcept;
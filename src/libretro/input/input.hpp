@@ -65,6 +65,7 @@ namespace MelonDsDs {
         void Apply(melonDS::NDS& nds, ScreenLayoutData& layout, MicrophoneState& mic) const noexcept;
         [[nodiscard]] bool CursorVisible() const noexcept { return _cursor.CursorVisible(); }
         [[nodiscard]] bool IsTouching() const noexcept { return _cursor.IsTouching(); }
+        [[nodiscard]] bool AnyConsoleInput() const noexcept { return _joypad.AnyConsoleButtonDown() || IsTouching(); }
         [[nodiscard]] bool TouchReleased() const noexcept {
             return _pointer.CursorReleased() || _joypad.TouchReleased();
         }
@@ -60,6 +60,9 @@ namespace MelonDsDs {
         [[nodiscard]] bool MicButtonReleased() const noexcept { return !_micButton && _previousMicButton; }
 
         [[nodiscard]] bool IsTouching() const noexcept { return _joystickTouchButton; }
+
+        /// Return true if any of the emulated console's buttons are held down
+        [[nodiscard]] bool AnyConsoleButtonDown() const noexcept { return (_consoleButtons & 0xFFF) != 0xFFF; }
         [[nodiscard]] bool TouchReleased() const noexcept {
             return !_joystickTouchButton && _previousJoystickTouchButton;
         }
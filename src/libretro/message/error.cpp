@@ -41,9 +41,14 @@ static constexpr const char* const THANK_YOU = "Thank you for using melonDS DS!"
 using std::span;
 using MelonDsDs::NDS_SCREEN_AREA;
 
-// I intentionally fix the error message to the DS screen size to simplify the layout.
 MelonDsDs::error::ErrorScreen::ErrorScreen(const config_exception& e) noexcept : exception(e) {
+}
+
+// I intentionally fix the error message to the DS screen size to simplify the layout.
+void MelonDsDs::error::ErrorScreen::Draw() const noexcept {
     ZoneScopedN(TracyFunction);
+    if (topScreen && bottomScreen)
+        return;
 
     pntr_font* titleFont = pntr_load_font_ttf_from_memory(
         embedded_melondsds_error_title_font,
@@ -74,8 +79,11 @@ MelonDsDs::error::ErrorScreen::ErrorScreen(const config_exception& e) noexcept :
 }
 
 MelonDsDs::error::ErrorScreen::~ErrorScreen() {
-    pntr_unload_image(topScreen);
-    pntr_unload_image(bottomScreen);
+    if (topScreen)
+        pntr_unload_image(topScreen);
+
+    if (bottomScreen)
+        pntr_unload_image(bottomScreen);
 }
 
 void MelonDsDs::error::ErrorScreen::DrawTopScreen(pntr_font* titleFont, pntr_font* bodyFont) const noexcept {
@@ -179,9 +187,11 @@ void MelonDsDs::error::ErrorScreen::DrawBottomScreen(pntr_font* titleFont, pntr_
 }
 
 span<const uint32_t, NDS_SCREEN_AREA<size_t>> MelonDsDs::error::ErrorScreen::TopScreen() const noexcept {
+    Draw();
     return span<const uint32_t, NDS_SCREEN_AREA<size_t>>{(const uint32_t*)topScreen->data, NDS_SCREEN_AREA<size_t>};
 }
 
 span<const uint32_t, NDS_SCREEN_AREA<size_t>> MelonDsDs::error::ErrorScreen::BottomScreen() const noexcept {
+    Draw();
     return span<const uint32_t, NDS_SCREEN_AREA<size_t>>{(const uint32_t*)bottomScreen->data, NDS_SCREEN_AREA<size_t>};
 }
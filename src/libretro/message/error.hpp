@@ -25,7 +25,6 @@ struct pntr_image;
 
 namespace MelonDsDs {
     class ScreenLayoutData;
-    class PixelBuffer;
 }
 
 namespace MelonDsDs::error {
@@ -41,11 +40,15 @@ namespace MelonDsDs::error {
         std::span<const uint32_t, NDS_SCREEN_AREA<size_t>> TopScreen() const noexcept;
         std::span<const uint32_t, NDS_SCREEN_AREA<size_t>> BottomScreen() const noexcept;
     private:
+        void Draw() const noexcept;
         void DrawTopScreen(pntr_font* titleFont, pntr_font* bodyFont) const noexcept;
         void DrawBottomScreen(pntr_font* titleFont, pntr_font* bodyFont) const noexcept;
         config_exception exception;
-        pntr_image* bottomScreen = nullptr;
-        pntr_image* topScreen = nullptr;
+
+        // Both screens are drawn the first time either one is requested,
+        // so the fonts aren't parsed unless the error is actually shown.
+        mutable pntr_image* bottomScreen = nullptr;
+        mutable pntr_image* topScreen = nullptr;
     };
 }
 
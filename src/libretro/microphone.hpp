@@ -48,6 +48,9 @@ namespace MelonDsDs {
 
         void SetMicButtonState(bool down) noexcept;
 
+        /// Restarts the white noise sequence, so that the same seed always produces the same noise.
+        void SeedNoise(uint32_t seed) noexcept { _randomEngine.seed(seed); }
+
     private:
         std::optional<retro_microphone_interface> _micInterface {};
         std::optional<retro::Microphone> _microphone {};
@@ -0,0 +1,190 @@
+/*
+    Copyright 2024 Jesse Talavera
+
+    melonDS DS is free software: you can redistribute it and/or modify it under
+    the terms of the GNU General Public License as published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+
+    melonDS DS is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with melonDS DS. If not, see http://www.gnu.org/licenses/.
+*/
+
+
+#include "impairment.hpp"
+
+#include <algorithm>
+
+#include "config/parse.hpp"
+#include "tracy.hpp"
+
+using std::optional;
+using std::nullopt;
+using std::string_view;
+using std::chrono::milliseconds;
+
+namespace MelonDsDs
+{
+    // Rough stand-ins for the connections that players actually use
+    static optional<ImpairmentProfile> GetImpairmentPreset(string_view name) noexcept
+    {
+        if (name == "ideal")
+            return ImpairmentProfile {};
+
+        if (name == "lan")
+            return ImpairmentProfile { .Delay = milliseconds(1), .Jitter = milliseconds(1) };
+
+        if (name == "wifi")
+            return ImpairmentProfile { .Delay = milliseconds(8), .Jitter = milliseconds(4), .Distribution = JitterDistribution::Normal, .Loss = 1 };
+
+        if (name == "congested")
+            return ImpairmentProfile { .Delay = milliseconds(30), .Jitter = milliseconds(15), .Distribution = JitterDistribution::Normal, .Loss = 5, .Bandwidth = 100000 };
+
+        return nullopt;
+    }
+}
+
+optional<MelonDsDs::ImpairmentProfile> MelonDsDs::ParseImpairmentProfile(string_view text) noexcept
+{
+    ZoneScopedN(TracyFunction);
+    if (optional<ImpairmentProfile> preset = GetImpairmentPreset(text))
+        return preset;
+
+    ImpairmentProfile profile;
+    while (!text.empty()) {
+        size_t comma = text.find(',');
+        string_view setting = text.substr(0, comma);
+        text = (comma == string_view::npos) ? string_view() : text.substr(comma + 1);
+
+        size_t equals = setting.find('=');
+        if (equals == string_view::npos)
+            return nullopt;
+
+        string_view key = setting.substr(0, equals);
+        string_view value = setting.substr(equals + 1);
+        if (key == "delay" || key == "jitter") {
+            optional<unsigned> ms = config::ParseIntegerInRange(value, 0u, 10000u);
+            if (!ms)
+                return nullopt;
+
+            (key == "delay" ? profile.Delay : profile.Jitter) = milliseconds(*ms);
+        }
+        else if (key == "dist") {
+            if (value == "uniform")
+                profile.Distribution = JitterDistribution::Uniform;
+            else if (value == "normal")
+                profile.Distribution = JitterDistribution::Normal;
+            else
+                return nullopt;
+        }
+        else if (key == "loss") {
+            optional<unsigned> loss = config::ParseIntegerInRange(value, 0u, 100u);
+            if (!loss)
+                return nullopt;
+
+            profile.Loss = *loss;
+        }
+        else if (key == "bandwidth") {
+            optional<unsigned> kbps = config::ParseIntegerInRange(value, 0u, 1000000u);
+            if (!kbps)
+                return nullopt;
+
+            profile.Bandwidth = *kbps * 1000ull;
+        }
+        else if (key == "seed") {
+            optional<uint32_t> seed = config::ParseIntegerInRange<uint32_t>(value, 0, UINT32_MAX);
+            if (!seed)
+                return nullopt;
+
+            profile.Seed = *seed;
+        }
+        else {
+            return nullopt;
+        }
+    }
+
+    return profile;
+}
+
+MelonDsDs::ImpairedChannel::ImpairedChannel(const ImpairmentProfile& profile) noexcept :
+    _profile(profile),
+    _random(profile.Seed)
+{
+}
+
+void MelonDsDs::ImpairedChannel::Send(const void* data, size_t length, uint16_t sender, clock::time_point now) noexcept
+{
+    ZoneScopedN(TracyFunction);
+    std::lock_guard lock(_mutex);
+    _stats.Sent++;
+    uint64_t sequence = ++_nextSequence;
+
+    if (_profile.Loss > 0 && std::uniform_int_distribution<unsigned>(0, 99)(_random) < _profile.Loss) {
+        _stats.Dropped++;
+        return;
+    }
+
+    clock::time_point departsAt = now;
+    if (_profile.Bandwidth > 0) {
+        // The link can only carry one packet at a time, so packets queue up behind each other
+        departsAt = std::max(now, _linkFreeAt) + std::chrono::duration_cast<clock::duration>(
+            std::chrono::duration<double>(static_cast<double>(length) / _profile.Bandwidth)
+        );
+        _linkFreeAt = departsAt;
+    }
+
+    const std::byte* bytes = static_cast<const std::byte*>(data);
+    _inFlight.push({
+        departsAt + SampleDelay(),
+        sequence,
+        { std::vector<std::byte>(bytes, bytes + length), sender },
+    });
+}
+
+std::vector<MelonDsDs::ImpairedChannel::Packet> MelonDsDs::ImpairedChannel::Receive(clock::time_point now) noexcept
+{
+    ZoneScopedN(TracyFunction);
+    std::lock_guard lock(_mutex);
+    std::vector<Packet> arrived;
+    while (!_inFlight.empty() && _inFlight.top().ArrivesAt <= now) {
+        // priority_queue::top is const, but we're about to pop it anyway
+        InFlight& packet = const_cast<InFlight&>(_inFlight.top());
+        if (packet.Sequence < _lastDeliveredSequence) {
+            _stats.Reordered++;
+        }
+        _lastDeliveredSequence = std::max(_lastDeliveredSequence, packet.Sequence);
+        _stats.Delivered++;
+        arrived.push_back(std::move(packet.Contents));
+        _inFlight.pop();
+    }
+
+    return arrived;
+}
+
+MelonDsDs::ImpairmentStats MelonDsDs::ImpairedChannel::Stats() const noexcept
+{
+    std::lock_guard lock(_mutex);
+    return _stats;
+}
+
+MelonDsDs::ImpairedChannel::clock::duration MelonDsDs::ImpairedChannel::SampleDelay() noexcept
+{
+    double delay = std::chrono::duration<double>(_profile.Delay).count();
+    double jitter = std::chrono::duration<double>(_profile.Jitter).count();
+    if (jitter > 0) {
+        switch (_profile.Distribution) {
+            case JitterDistribution::Uniform:
+                delay += std::uniform_real_distribution<double>(-jitter, jitter)(_random);
+                break;
+            case JitterDistribution::Normal:
+                delay += std::normal_distribution<double>(0, jitter)(_random);
+                break;
+        }
+    }
+
+    return std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(std::max(delay, 0.0)));
+}
@@ -0,0 +1,111 @@
+/*
+    Copyright 2024 Jesse Talavera
+
+    melonDS DS is free software: you can redistribute it and/or modify it under
+    the terms of the GNU General Public License as published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+
+    melonDS DS is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with melonDS DS. If not, see http://www.gnu.org/licenses/.
+*/
+
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <queue>
+#include <random>
+#include <string_view>
+#include <vector>
+
+namespace MelonDsDs
+{
+    enum class JitterDistribution
+    {
+        Uniform,
+        Normal,
+    };
+
+    /// Network conditions for ImpairedChannel to simulate.
+    struct ImpairmentProfile
+    {
+        std::chrono::microseconds Delay {};
+
+        /// Half-width of the uniform distribution, or the standard deviation of the normal one.
+        /// Packets with independent delays can arrive out of order, as on real networks.
+        std::chrono::microseconds Jitter {};
+        JitterDistribution Distribution = JitterDistribution::Uniform;
+
+        /// In percent
+        unsigned Loss = 0;
+
+        /// In bytes per second; 0 means unlimited
+        uint64_t Bandwidth = 0;
+        uint32_t Seed = 0;
+    };
+
+    /// Parses a preset name ("ideal", "lan", "wifi", or "congested"),
+    /// or a comma-separated list of settings like "delay=20,jitter=5,dist=normal,loss=2,bandwidth=250,seed=1".
+    /// Delays are in milliseconds and bandwidth is in KB/s.
+    [[nodiscard]] std::optional<ImpairmentProfile> ParseImpairmentProfile(std::string_view text) noexcept;
+
+    struct ImpairmentStats
+    {
+        uint64_t Sent = 0;
+        uint64_t Dropped = 0;
+        uint64_t Delivered = 0;
+
+        /// Packets that arrived after one that was sent later
+        uint64_t Reordered = 0;
+    };
+
+    /// A one-way link that delays, reorders, and drops packets, for testing local multiplayer
+    /// without real network hardware. Packets may be sent and received from different threads.
+    class ImpairedChannel
+    {
+    public:
+        using clock = std::chrono::steady_clock;
+
+        struct Packet
+        {
+            std::vector<std::byte> Data;
+            uint16_t Sender;
+        };
+
+        explicit ImpairedChannel(const ImpairmentProfile& profile) noexcept;
+        void Send(const void* data, size_t length, uint16_t sender, clock::time_point now) noexcept;
+
+        /// Removes and returns the packets that have arrived by now, in arrival order.
+        [[nodiscard]] std::vector<Packet> Receive(clock::time_point now) noexcept;
+        [[nodiscard]] ImpairmentStats Stats() const noexcept;
+    private:
+        struct InFlight
+        {
+            clock::time_point ArrivesAt;
+            uint64_t Sequence;
+            Packet Contents;
+
+            bool operator>(const InFlight& other) const noexcept { return ArrivesAt > other.ArrivesAt; }
+        };
+
+        clock::duration SampleDelay() noexcept;
+
+        ImpairmentProfile _profile;
+        mutable std::mutex _mutex;
+        std::priority_queue<InFlight, std::vector<InFlight>, std::greater<>> _inFlight;
+        std::mt19937 _random;
+        clock::time_point _linkFreeAt {};
+        uint64_t _nextSequence = 0;
+        uint64_t _lastDeliveredSequence = 0;
+        ImpairmentStats _stats;
+    };
+}
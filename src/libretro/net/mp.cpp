@@ -1,5 +1,6 @@
 #include "mp.hpp"
 #include "environment.hpp"
+#include <cstring>
 #include <ctime>
 #include <libretro.h>
 #include <retro_assert.h>
@@ -12,6 +13,10 @@ uint64_t swapToNetwork(uint64_t n) {
     return swap_if_little64(n);
 }
 
+uint16_t swapToNetwork(uint16_t n) {
+    return swap_if_little16(n);
+}
+
 Packet Packet::parsePk(const void *buf, uint64_t len) {
     // Necessary because arithmetic on void* is forbidden
     const char *indexableBuf = (const char *)buf;
@@ -76,14 +81,53 @@ bool MpState::IsReady() const noexcept {
 
 void MpState::SetSendFn(retro_netpacket_send_t sendFn) noexcept {
     _sendFn = sendFn;
+    if (sendFn == nullptr) {
+        // The session is over, so there's no one to send the rest of the batch to
+        _batch.clear();
+        _unflushed = false;
+    }
 }
 
 void MpState::SetPollFn(retro_netpacket_poll_receive_t pollFn) noexcept {
     _pollFn = pollFn;
 }
 
+void MpState::SetBatching(bool batching) noexcept {
+    if (_batching && !batching && IsReady()) {
+        SendBatch(true);
+    }
+    _batching = batching;
+}
+
 void MpState::PacketReceived(const void *buf, size_t len, uint16_t client_id) noexcept {
     retro_assert(IsReady());
+    _stats.DatagramsReceived++;
+    const uint8_t *bytes = (const uint8_t *)buf;
+    if (len < BatchMagic.size() || memcmp(bytes, BatchMagic.data(), BatchMagic.size()) != 0) {
+        ReceivePacket(buf, len, client_id);
+        return;
+    }
+
+    for (size_t offset = BatchMagic.size(); offset < len;) {
+        uint16_t netLength;
+        if (offset + sizeof(netLength) > len) {
+            retro::warn("Ignoring truncated MP batch from client {}", client_id);
+            return;
+        }
+        memcpy(&netLength, bytes + offset, sizeof(netLength));
+        uint16_t length = swapToNetwork(netLength);
+        offset += sizeof(netLength);
+        if (length < HeaderSize || offset + length > len) {
+            retro::warn("Ignoring malformed MP batch from client {}", client_id);
+            return;
+        }
+        ReceivePacket(bytes + offset, length, client_id);
+        offset += length;
+    }
+}
+
+void MpState::ReceivePacket(const void *buf, size_t len, uint16_t client_id) noexcept {
+    _stats.PacketsReceived++;
     Packet p = Packet::parsePk(buf, len);
     if(p.PacketType() == Packet::Type::Cmd) {
         _hostId = client_id;
@@ -95,8 +139,13 @@ void MpState::PacketReceived(const void *buf, size_t len, uint16_t client_id) no
 std::optional<Packet> MpState::NextPacket() noexcept {
     retro_assert(IsReady());
     if(receivedPackets.empty()) {
-        _sendFn(RETRO_NETPACKET_FLUSH_HINT, NULL, 0, RETRO_NETPACKET_BROADCAST);
-        _pollFn();
+        if (_batching) {
+            // Nobody is waiting on us yet, so let the frontend send the batch whenever it next flushes
+            SendBatch(false);
+        } else {
+            Send(RETRO_NETPACKET_FLUSH_HINT, NULL, 0, RETRO_NETPACKET_BROADCAST);
+        }
+        Poll();
     }
     if(receivedPackets.empty()) {
         return std::nullopt;
@@ -110,9 +159,15 @@ std::optional<Packet> MpState::NextPacket() noexcept {
 std::optional<Packet> MpState::NextPacketBlock() noexcept {
     retro_assert(IsReady());
     if (receivedPackets.empty()) {
+        if (_batching) {
+            // We're about to wait for a reply, so whatever we've batched has to go out now
+            SendBatch(true);
+        }
         for(std::clock_t start = std::clock(); std::clock() < (start + (RECV_TIMEOUT_MS * CLOCKS_PER_SEC / 1000));) {
-            _sendFn(RETRO_NETPACKET_FLUSH_HINT, NULL, 0, RETRO_NETPACKET_BROADCAST);
-            _pollFn();
+            if (!_batching) {
+                Send(RETRO_NETPACKET_FLUSH_HINT, NULL, 0, RETRO_NETPACKET_BROADCAST);
+            }
+            Poll();
             if(!receivedPackets.empty()) {
                 return NextPacket();
             }
@@ -120,6 +175,7 @@ std::optional<Packet> MpState::NextPacketBlock() noexcept {
     } else {
         return NextPacket();
     }
+    _stats.Timeouts++;
     retro::debug("Timeout while waiting for packet");
     return std::nullopt;
 }
@@ -133,7 +189,66 @@ void MpState::SendPacket(const Packet &p) noexcept {
     if(p.PacketType() == Packet::Type::Reply && _hostId.has_value()) {
         dest = _hostId.value();
     }
-    _sendFn(RETRO_NETPACKET_UNSEQUENCED | RETRO_NETPACKET_UNRELIABLE | RETRO_NETPACKET_FLUSH_HINT, p.ToBuf().data(), p.Length() + HeaderSize, dest);
+    _stats.PacketsSent++;
+    std::vector<uint8_t> buf = p.ToBuf();
+    if (!_batching) {
+        Send(RETRO_NETPACKET_UNSEQUENCED | RETRO_NETPACKET_UNRELIABLE | RETRO_NETPACKET_FLUSH_HINT, buf.data(), buf.size(), dest);
+        return;
+    }
+
+    if (!_batch.empty() && (dest != _batchDest || _batch.size() + sizeof(uint16_t) + buf.size() > MaxBatchSize)) {
+        // Each batch has one destination
+        SendBatch(false);
+    }
+    if (_batch.empty()) {
+        _batch.insert(_batch.end(), BatchMagic.begin(), BatchMagic.end());
+        _batchDest = dest;
+    }
+    uint16_t netLength = swapToNetwork((uint16_t)buf.size());
+    _batch.insert(_batch.end(), (const uint8_t *)&netLength, (const uint8_t *)&netLength + sizeof(netLength));
+    _batch.insert(_batch.end(), buf.begin(), buf.end());
+
+    if (p.PacketType() == Packet::Type::Reply) {
+        // The host is blocked until it gets this
+        SendBatch(true);
+    }
+}
+
+void MpState::EndTimeSlice() noexcept {
+    retro_assert(IsReady());
+    if (_batching) {
+        SendBatch(true);
+    }
+}
+
+void MpState::SendBatch(bool flush) noexcept {
+    if (!_batch.empty()) {
+        int flags = RETRO_NETPACKET_UNSEQUENCED | RETRO_NETPACKET_UNRELIABLE;
+        if (flush) {
+            flags |= RETRO_NETPACKET_FLUSH_HINT;
+        }
+        Send(flags, _batch.data(), _batch.size(), _batchDest);
+        _batch.clear();
+        _unflushed = !flush;
+    } else if (flush && _unflushed) {
+        Send(RETRO_NETPACKET_FLUSH_HINT, NULL, 0, RETRO_NETPACKET_BROADCAST);
+    }
+}
+
+void MpState::Send(int flags, const void *buf, size_t len, uint16_t dest) noexcept {
+    if (len > 0) {
+        _stats.DatagramsSent++;
+    }
+    if (flags & RETRO_NETPACKET_FLUSH_HINT) {
+        _stats.Flushes++;
+        _unflushed = false;
+    }
+    _sendFn(flags, buf, len, dest);
+}
+
+void MpState::Poll() noexcept {
+    _stats.Polls++;
+    _pollFn();
 }
 
 
@@ -1,4 +1,5 @@
 #pragma once
+#include <array>
 #include <cstdint>
 #include <queue>
 #include <optional>
@@ -9,6 +10,31 @@ namespace MelonDsDs {
 // timestamp, aid, and isReply, respectively.
 constexpr size_t HeaderSize = sizeof(uint64_t) + sizeof(uint8_t) + sizeof(uint8_t);
 
+// A batch is this magic number, then each packet as a 16-bit length (in network order)
+// followed by the packet as Packet::ToBuf writes it.
+// A lone packet can't be mistaken for a batch, since that would need a timestamp of at least 0x4D44534200000000.
+constexpr std::array<uint8_t, 4> BatchMagic = {'M', 'D', 'S', 'B'};
+
+// Keeps batches well under the size of a netplay buffer
+constexpr size_t MaxBatchSize = 16384;
+
+struct MpStats {
+    // MP frames sent or received by the emulated console
+    uint64_t PacketsSent = 0;
+    uint64_t PacketsReceived = 0;
+
+    // Messages handed to or received from the frontend, one per batch in batching mode
+    uint64_t DatagramsSent = 0;
+    uint64_t DatagramsReceived = 0;
+
+    // Calls that make the frontend do network I/O
+    uint64_t Flushes = 0;
+    uint64_t Polls = 0;
+
+    // Blocking receives that gave up waiting, e.g. because a reply was lost or late
+    uint64_t Timeouts = 0;
+};
+
 class Packet {
 public:
     enum Type {
@@ -51,10 +77,29 @@ public:
     void SendPacket(const Packet &p) noexcept;
     std::optional<Packet> NextPacket() noexcept;
     std::optional<Packet> NextPacketBlock() noexcept;
+
+    // Batching only changes how this peer sends packets; batches are always accepted.
+    void SetBatching(bool batching) noexcept;
+
+    // Sends any packets batched during this emulated frame
+    void EndTimeSlice() noexcept;
+    [[nodiscard]] const MpStats& Stats() const noexcept { return _stats; }
 private:
+    void ReceivePacket(const void *buf, size_t len, uint16_t client_id) noexcept;
+    void Send(int flags, const void *buf, size_t len, uint16_t dest) noexcept;
+    void SendBatch(bool flush) noexcept;
+    void Poll() noexcept;
+
     retro_netpacket_send_t _sendFn;
     retro_netpacket_poll_receive_t _pollFn;
     std::optional<uint16_t> _hostId;
     std::queue<Packet> receivedPackets;
+    bool _batching = false;
+    std::vector<uint8_t> _batch;
+    uint16_t _batchDest = RETRO_NETPACKET_BROADCAST;
+
+    // True if a batch was handed to the frontend without asking it to flush
+    bool _unflushed = false;
+    MpStats _stats;
 };
 }
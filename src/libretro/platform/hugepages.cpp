@@ -0,0 +1,115 @@
+/*
+    Copyright 2024 Jesse Talavera
+
+    melonDS DS is free software: you can redistribute it and/or modify it under
+    the terms of the GNU General Public License as published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+
+    melonDS DS is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with melonDS DS. If not, see http://www.gnu.org/licenses/.
+*/
+
+
+#include "hugepages.hpp"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "tracy.hpp"
+
+using std::min;
+using std::max;
+
+MelonDsDs::HugePageMode MelonDsDs::GetHugePageMode() noexcept {
+    ZoneScopedN(TracyFunction);
+    FILE* file = fopen("/sys/kernel/mm/transparent_hugepage/enabled", "r");
+    if (!file)
+        return HugePageMode::Unavailable;
+
+    char buffer[64] {};
+    size_t length = fread(buffer, 1, sizeof(buffer) - 1, file);
+    fclose(file);
+    buffer[length] = '\0';
+
+    // The file lists every mode and brackets the active one, e.g. "always [madvise] never"
+    if (strstr(buffer, "[always]"))
+        return HugePageMode::Always;
+
+    if (strstr(buffer, "[madvise]"))
+        return HugePageMode::Madvise;
+
+    if (strstr(buffer, "[never]"))
+        return HugePageMode::Never;
+
+    return HugePageMode::Unavailable;
+}
+
+size_t MelonDsDs::AdviseHugePages(const void* data, size_t size) noexcept {
+    ZoneScopedN(TracyFunction);
+    if (!data || size == 0)
+        return 0;
+
+#ifdef MADV_HUGEPAGE
+    // madvise needs a page-aligned start, so narrow the region to the pages that lie entirely within it
+    uintptr_t pageSize = sysconf(_SC_PAGESIZE);
+    uintptr_t begin = (reinterpret_cast<uintptr_t>(data) + pageSize - 1) & ~(pageSize - 1);
+    uintptr_t end = (reinterpret_cast<uintptr_t>(data) + size) & ~(pageSize - 1);
+    if (end <= begin)
+        return 0;
+
+    if (madvise(reinterpret_cast<void*>(begin), end - begin, MADV_HUGEPAGE) != 0)
+        return 0;
+
+    return end - begin;
+#else
+    return 0;
+#endif
+}
+
+size_t MelonDsDs::GetHugePageBackedSize(const void* data, size_t size) noexcept {
+    ZoneScopedN(TracyFunction);
+    if (!data || size == 0)
+        return 0;
+
+    FILE* file = fopen("/proc/self/smaps", "r");
+    if (!file)
+        return 0;
+
+    uintptr_t regionBegin = reinterpret_cast<uintptr_t>(data);
+    uintptr_t regionEnd = regionBegin + size;
+    size_t overlap = 0;
+    size_t backed = 0;
+    char line[256];
+    while (fgets(line, sizeof(line), file)) {
+        uintptr_t mappingBegin = 0;
+        uintptr_t mappingEnd = 0;
+        size_t kilobytes = 0;
+        if (sscanf(line, "%" SCNxPTR "-%" SCNxPTR " ", &mappingBegin, &mappingEnd) == 2) {
+            // If this line starts a new mapping, see how much of it our region covers
+            uintptr_t begin = max(mappingBegin, regionBegin);
+            uintptr_t end = min(mappingEnd, regionEnd);
+            overlap = end > begin ? end - begin : 0;
+        }
+        else if (overlap > 0 && (
+            sscanf(line, "AnonHugePages: %zu kB", &kilobytes) == 1 ||
+            sscanf(line, "ShmemPmdMapped: %zu kB", &kilobytes) == 1
+        )) {
+            // Fast memory keeps main RAM in shared memory, so count both kinds of huge page
+            backed += min(kilobytes * 1024, overlap);
+        }
+    }
+
+    fclose(file);
+    return backed;
+}
@@ -0,0 +1,49 @@
+/*
+    Copyright 2024 Jesse Talavera
+
+    melonDS DS is free software: you can redistribute it and/or modify it under
+    the terms of the GNU General Public License as published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+
+    melonDS DS is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with melonDS DS. If not, see http://www.gnu.org/licenses/.
+*/
+
+
+#ifndef MELONDSDS_PLATFORM_HUGEPAGES_HPP
+#define MELONDSDS_PLATFORM_HUGEPAGES_HPP
+
+#include <cstddef>
+
+namespace MelonDsDs {
+    enum class HugePageMode {
+        /// The host doesn't support transparent huge pages (or we couldn't tell).
+        Unavailable,
+        /// Transparent huge pages are disabled system-wide; advice will be ignored.
+        Never,
+        /// Only regions that ask for huge pages get them.
+        Madvise,
+        /// Every eligible region gets huge pages, whether or not it asks.
+        Always,
+    };
+
+    [[nodiscard]] HugePageMode GetHugePageMode() noexcept;
+
+    /// Asks the kernel to back the whole pages within the given region with transparent huge pages.
+    /// The region doesn't need to be page-aligned;
+    /// partial pages at either end are left alone, since they may belong to other allocations.
+    /// Returns the number of bytes that were advised, or 0 on failure.
+    size_t AdviseHugePages(const void* data, size_t size) noexcept;
+
+    /// Returns how many bytes of the given region the kernel currently backs with huge pages,
+    /// as reported by /proc/self/smaps.
+    /// Approximate, since smaps reports per-mapping totals.
+    [[nodiscard]] size_t GetHugePageBackedSize(const void* data, size_t size) noexcept;
+}
+
+#endif // MELONDSDS_PLATFORM_HUGEPAGES_HPP
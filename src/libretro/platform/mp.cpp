@@ -39,7 +39,17 @@ void MelonDsDs::CoreState::MpStopped() noexcept {
     ZoneScopedN(TracyFunction);
     _mpState.SetSendFn(nullptr);
     _mpState.SetPollFn(nullptr);
-    retro::info("Stopping multiplayer on libretro side");
+    const MpStats& stats = _mpState.Stats();
+    retro::info(
+        "Stopping multiplayer on libretro side; sent {} packets in {} messages, received {} packets in {} messages, with {} flushes, {} polls, and {} timeouts",
+        stats.PacketsSent,
+        stats.DatagramsSent,
+        stats.PacketsReceived,
+        stats.DatagramsReceived,
+        stats.Flushes,
+        stats.Polls,
+        stats.Timeouts
+    );
 }
 
 bool MelonDsDs::CoreState::MpSendPacket(const MelonDsDs::Packet &p) noexcept {
@@ -14,8 +14,11 @@
     with melonDS DS. If not, see http://www.gnu.org/licenses/.
 */
 
+#include <chrono>
+
 #include <Platform.h>
 
+#include "threadstats.hpp"
 #include "tracy.hpp"
 
 #include "std/semaphore.hpp"
@@ -46,7 +49,10 @@ bool Platform::Semaphore_TryWait(Semaphore* sema, int timeout_ms)
     if (!timeout_ms)
         return sema->semaphore.try_acquire();
 
-    return sema->semaphore.try_acquire_for(std::chrono::milliseconds(timeout_ms));
+    auto start = std::chrono::steady_clock::now();
+    bool acquired = sema->semaphore.try_acquire_for(std::chrono::milliseconds(timeout_ms));
+    MelonDsDs::RecordSemaphoreWait(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start));
+    return acquired;
 }
 
 void Platform::Semaphore_Post(Semaphore *sema, int count)
@@ -58,7 +64,9 @@ void Platform::Semaphore_Post(Semaphore *sema, int count)
 void Platform::Semaphore_Wait(Semaphore *sema)
 {
     ZoneScopedN(TracyFunction);
+    auto start = std::chrono::steady_clock::now();
     sema->semaphore.acquire();
+    MelonDsDs::RecordSemaphoreWait(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start));
 }
 
 void Platform::Semaphore_Free(Semaphore *sema)
@@ -20,6 +20,8 @@
 
 #include <utility>
 
+#include "threadstats.hpp"
+
 using namespace melonDS;
 using Platform::Thread;
 struct Platform::Thread {
@@ -31,6 +33,7 @@ struct ThreadData {
 
 static void function_trampoline(void *param) {
     auto *data = (ThreadData *) param;
+    MelonDsDs::MarkWorkerThread();
     data->fn();
     delete data;
 }
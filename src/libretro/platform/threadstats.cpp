@@ -0,0 +1,44 @@
+/*
+    Copyright 2024 Jesse Talavera
+
+    melonDS DS is free software: you can redistribute it and/or modify it under
+    the terms of the GNU General Public License as published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+
+    melonDS DS is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with melonDS DS. If not, see http://www.gnu.org/licenses/.
+*/
+
+#include "threadstats.hpp"
+
+#include <atomic>
+#include <cstdint>
+
+using std::chrono::microseconds;
+
+namespace MelonDsDs {
+    static thread_local bool IsWorkerThread = false;
+    static std::atomic_uint64_t EmulatorWaitUsec = 0;
+    static std::atomic_uint64_t WorkerWaitUsec = 0;
+}
+
+void MelonDsDs::MarkWorkerThread() noexcept {
+    IsWorkerThread = true;
+}
+
+void MelonDsDs::RecordSemaphoreWait(microseconds duration) noexcept {
+    std::atomic_uint64_t& total = IsWorkerThread ? WorkerWaitUsec : EmulatorWaitUsec;
+    total.fetch_add(duration.count(), std::memory_order_relaxed);
+}
+
+MelonDsDs::ThreadWaitStats MelonDsDs::GetThreadWaitStats() noexcept {
+    return {
+        microseconds(EmulatorWaitUsec.load(std::memory_order_relaxed)),
+        microseconds(WorkerWaitUsec.load(std::memory_order_relaxed)),
+    };
+}
@@ -0,0 +1,41 @@
+/*
+    Copyright 2024 Jesse Talavera
+
+    melonDS DS is free software: you can redistribute it and/or modify it under
+    the terms of the GNU General Public License as published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+
+    melonDS DS is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with melonDS DS. If not, see http://www.gnu.org/licenses/.
+*/
+
+#ifndef MELONDSDS_PLATFORM_THREADSTATS_HPP
+#define MELONDSDS_PLATFORM_THREADSTATS_HPP
+
+#include <chrono>
+
+namespace MelonDsDs {
+    /// Time spent blocked on melonDS's semaphores, split by which kind of thread was waiting.
+    /// With the threaded software renderer, the emulator thread's waits are stalls on the 3D render thread,
+    /// and the worker threads' waits are the render thread's idle time.
+    struct ThreadWaitStats {
+        std::chrono::microseconds EmulatorWait {};
+        std::chrono::microseconds WorkerWait {};
+
+        ThreadWaitStats operator-(const ThreadWaitStats& other) const noexcept {
+            return { EmulatorWait - other.EmulatorWait, WorkerWait - other.WorkerWait };
+        }
+    };
+
+    /// Marks the calling thread as one that melonDS created through Platform::Thread_Create.
+    void MarkWorkerThread() noexcept;
+    void RecordSemaphoreWait(std::chrono::microseconds duration) noexcept;
+    [[nodiscard]] ThreadWaitStats GetThreadWaitStats() noexcept;
+}
+
+#endif // MELONDSDS_PLATFORM_THREADSTATS_HPP
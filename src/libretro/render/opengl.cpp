@@ -372,6 +372,13 @@ void MelonDsDs::OpenGLRenderState::Render(
     TracyGpuZone(TracyFunction);
     retro_assert(nds.GetRenderer3D().Accelerated);
 
+    if (nds.IsLidClosed() && _lidClosedFrameSent && !_needsRefresh && retro::supports_frame_dupe()) [[unlikely]] {
+        // If the emulated lid is still closed and we've already drawn the blank frame,
+        // then there's no need to touch any GL state; just show the last frame again.
+        retro::video_refresh(nullptr, screenLayout.BufferWidth(), screenLayout.BufferHeight(), 0);
+        return;
+    }
+
     glsm_ctl(GLSM_CTL_STATE_BIND, nullptr);
 
     GLuint current_fbo = glsm_get_current_framebuffer();
@@ -439,6 +446,7 @@ void MelonDsDs::OpenGLRenderState::Render(
     glFlush();
 
     glsm_ctl(GLSM_CTL_STATE_UNBIND, nullptr);
+    _lidClosedFrameSent = nds.IsLidClosed();
 
 #ifdef HAVE_TRACY
     if (_tracyCapture) {
@@ -463,6 +471,7 @@ void MelonDsDs::OpenGLRenderState::ContextDestroyed() {
     glsm_ctl(GLSM_CTL_STATE_CONTEXT_DESTROY, nullptr);
     _openGlDebugAvailable = false;
     _needsRefresh = false;
+    _lidClosedFrameSent = false;
     _contextInitialized = false;
     _screenProgram = 0;
     screen_framebuffer_texture = 0;
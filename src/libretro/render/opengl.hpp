@@ -73,6 +73,7 @@ namespace MelonDsDs {
         void InitVertices(const ScreenLayoutData& screenLayout) noexcept;
         bool _openGlDebugAvailable = false;
         bool _needsRefresh = true;
+        bool _lidClosedFrameSent = false;
         bool _contextInitialized = false;
         GLuint _screenProgram = 0;
         GLuint screen_framebuffer_texture = 0;
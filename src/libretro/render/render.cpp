@@ -95,8 +95,9 @@ void MelonDsDs::RenderStateWrapper::SetRenderer(const CoreConfig& config) {
 void MelonDsDs::RenderStateWrapper::UpdateRenderer(const CoreConfig& config, melonDS::NDS& nds) noexcept {
     assert(_renderState != nullptr);
 
-    if (dynamic_cast<SoftwareRenderState*>(_renderState.get())) {
+    if (auto* softwareState = dynamic_cast<SoftwareRenderState*>(_renderState.get())) {
         // If we're configured to use the software renderer...
+        softwareState->SetThreadedComposition(config.ThreadedComposition());
         if (auto* softRender = dynamic_cast<melonDS::SoftRenderer*>(&nds.GetRenderer3D())) {
             // ...and we already are...
             softRender->SetThreaded(config.ThreadedSoftRenderer(), nds.GPU);
@@ -44,6 +44,10 @@ namespace MelonDsDs {
         virtual bool Ready() const noexcept = 0;
         virtual void Render(melonDS::NDS& nds, const InputState& input, const CoreConfig& config, const ScreenLayoutData& screenLayout) noexcept = 0;
         virtual void RequestRefresh() noexcept {}
+
+        /// Blocks until any rendering still in progress on another thread is done.
+        /// Must be called before the emulator's framebuffers are freed or overwritten outside of a frame.
+        virtual void Flush() noexcept {}
     };
 
     class RenderStateWrapper {
@@ -57,6 +61,12 @@ namespace MelonDsDs {
             }
         }
 
+        void Flush() noexcept {
+            if (_renderState) {
+                _renderState->Flush();
+            }
+        }
+
         void Apply(const CoreConfig& config) noexcept;
         [[gnu::cold]] void UpdateRenderer(const CoreConfig& config, melonDS::NDS& nds) noexcept;
         void ContextReset(melonDS::NDS& nds, const CoreConfig& config);
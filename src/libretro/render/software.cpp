@@ -16,13 +16,17 @@
 
 #include "software.hpp"
 
+#include <type_traits>
+
 #include <retro_assert.h>
 
 #include <NDS.h>
+#include <Platform.h>
 #include <gfx/scaler/pixconv.h>
 
 #include "config/config.hpp"
 #include "config/types.hpp"
+#include "environment.hpp"
 #include "input/input.hpp"
 #include "message/error.hpp"
 #include "screenlayout.hpp"
@@ -35,7 +39,9 @@ using glm::uvec2;
 using std::span;
 
 MelonDsDs::SoftwareRenderState::SoftwareRenderState(const CoreConfig& config) noexcept :
+    outputFormat(retro::get_pixel_format() == RETRO_PIXEL_FORMAT_RGB565 ? RETRO_PIXEL_FORMAT_RGB565 : RETRO_PIXEL_FORMAT_XRGB8888),
     buffer(1, 1),
+    buffer565(1, 1),
     hybridBuffer(1, 1),
     hybridScaler(
         SCALER_FMT_ARGB8888,
@@ -45,7 +51,88 @@ MelonDsDs::SoftwareRenderState::SoftwareRenderState(const CoreConfig& config) no
         NDS_SCREEN_HEIGHT,
         NDS_SCREEN_WIDTH * config.HybridRatio(),
         NDS_SCREEN_HEIGHT * config.HybridRatio()
-    ) {
+    ),
+    frontBuffer(1, 1),
+    frontBuffer565(1, 1) {
+    SetThreadedComposition(config.ThreadedComposition());
+}
+
+MelonDsDs::SoftwareRenderState::~SoftwareRenderState() noexcept {
+    SetThreadedComposition(false);
+}
+
+void MelonDsDs::SoftwareRenderState::SetThreadedComposition(bool threaded) noexcept {
+    ZoneScopedN(TracyFunction);
+    using namespace melonDS;
+
+    if (threaded && !compositionThread) {
+        // If we need to start the composition thread...
+        compositionStart = Platform::Semaphore_Create();
+        compositionDone = Platform::Semaphore_Create();
+        compositionQuit = false;
+        compositionThread = Platform::Thread_Create([this] { CompositionThreadMain(); });
+        if (!compositionThread) {
+            // If this platform doesn't support threads...
+            retro::warn("Failed to start the screen composition thread; compositing on the emulator thread instead");
+            Platform::Semaphore_Free(compositionStart);
+            Platform::Semaphore_Free(compositionDone);
+            compositionStart = nullptr;
+            compositionDone = nullptr;
+            return;
+        }
+
+        retro::debug("Started the screen composition thread");
+    }
+    else if (!threaded && compositionThread) {
+        // If we need to stop the composition thread...
+        Flush();
+        compositionQuit = true;
+        Platform::Semaphore_Post(compositionStart, 1);
+        Platform::Thread_Wait(compositionThread);
+        Platform::Thread_Free(compositionThread);
+        Platform::Semaphore_Free(compositionStart);
+        Platform::Semaphore_Free(compositionDone);
+        compositionThread = nullptr;
+        compositionStart = nullptr;
+        compositionDone = nullptr;
+        hasComposedFrame = false;
+        retro::debug("Stopped the screen composition thread");
+    }
+}
+
+void MelonDsDs::SoftwareRenderState::CompositionThreadMain() noexcept {
+    using namespace melonDS;
+
+    while (true) {
+        Platform::Semaphore_Wait(compositionStart);
+        if (compositionQuit)
+            return;
+
+        retro_assert(compositionJob.has_value());
+        Compose(*compositionJob);
+        Platform::Semaphore_Post(compositionDone, 1);
+    }
+}
+
+void MelonDsDs::SoftwareRenderState::FinishComposition() noexcept {
+    ZoneScopedN(TracyFunction);
+    if (!compositionPending)
+        return;
+
+    melonDS::Platform::Semaphore_Wait(compositionDone);
+    compositionPending = false;
+    compositionJob = std::nullopt;
+
+    // The finished frame becomes the one we present,
+    // and the one we presented becomes the next composition target.
+    std::swap(buffer, frontBuffer);
+    std::swap(buffer565, frontBuffer565);
+    hasComposedFrame = true;
+}
+
+void MelonDsDs::SoftwareRenderState::Flush() noexcept {
+    // The composition thread reads the emulator's framebuffers directly
+    FinishComposition();
 }
 
 // TODO: Consider using RETRO_ENVIRONMENT_GET_CURRENT_SOFTWARE_FRAMEBUFFER
@@ -57,7 +144,18 @@ void MelonDsDs::SoftwareRenderState::Render(
 ) noexcept {
     ZoneScopedN(TracyFunction);
 
-    buffer.SetSize(screenLayout.BufferSize());
+    // We're about to draw over the cached error screen
+    cachedErrorFrame.Screen = nullptr;
+
+    // The hybrid scaler can't be reconfigured while the last frame is still being composited
+    FinishComposition();
+
+    if (nds.IsLidClosed()) [[unlikely]] {
+        // If the emulated lid is closed, the screens are off; there's nothing to composite
+        RenderLidClosed(screenLayout);
+        return;
+    }
+    lidClosedFrameReady = false;
 
     if (IsHybridLayout(screenLayout.Layout())) {
         uvec2 requiredHybridBufferSize = NDS_SCREEN_SIZE<unsigned> * screenLayout.HybridRatio();
@@ -70,33 +168,39 @@ void MelonDsDs::SoftwareRenderState::Render(
 
     const uint32_t* topScreenBuffer = nds.GPU.Framebuffer[nds.GPU.FrontBuffer][0].get();
     const uint32_t* bottomScreenBuffer = nds.GPU.Framebuffer[nds.GPU.FrontBuffer][1].get();
-    CombineScreens(
+    CompositionJob job {
         span<const uint32_t, NDS_SCREEN_AREA<size_t>>(topScreenBuffer, NDS_SCREEN_AREA<size_t>),
         span<const uint32_t, NDS_SCREEN_AREA<size_t>>(bottomScreenBuffer, NDS_SCREEN_AREA<size_t>),
-        screenLayout
-    );
-
-    if (!nds.IsLidClosed() && inputState.CursorVisible()) {
-        DrawCursor(inputState, config, screenLayout);
+        screenLayout,
+        !nds.IsLidClosed() && inputState.CursorVisible(),
+        inputState.TouchPosition(),
+        config.CursorSize(),
+    };
+
+    if (!compositionThread) {
+        // If we're compositing on this thread...
+        Compose(job);
+        if (outputFormat == RETRO_PIXEL_FORMAT_RGB565) {
+            SendFrame(buffer565);
+        }
+        else {
+            SendFrame(buffer);
+        }
+        return;
     }
 
-    retro::video_refresh(buffer[0], buffer.Width(), buffer.Height(), buffer.Stride());
+    // melonDS won't write to the front buffer until the end of the next frame,
+    // so the worker can composite it while the next frame is being emulated.
+    compositionJob = std::move(job);
+    compositionPending = true;
+    melonDS::Platform::Semaphore_Post(compositionStart, 1);
 
-#ifdef HAVE_TRACY
-    if (tracy::ProfilerAvailable()) {
-        // If Tracy is connected...
-        ZoneScopedN("MelonDsDs::render::RenderSoftware::SendFrameToTracy");
-        std::unique_ptr<uint8_t[]> frame = std::make_unique<uint8_t[]>(buffer.Width() * buffer.Height() * 4);
-        {
-            ZoneScopedN("conv_argb8888_abgr8888");
-            conv_argb8888_abgr8888(frame.get(), buffer[0], buffer.Width(), buffer.Height(), buffer.Stride(), buffer.Stride());
-        }
-        // libretro wants pixels in XRGB8888 format,
-        // but Tracy wants them in XBGR8888 format.
-
-        FrameImage(frame.get(), buffer.Width(), buffer.Height(), 0, false);
+    if (!hasComposedFrame) {
+        // If there's no earlier frame to show...
+        FinishComposition(); // ...then just wait for this one.
     }
-#endif
+
+    SendFrontFrame();
 }
 
 void MelonDsDs::SoftwareRenderState::Render(
@@ -105,13 +209,145 @@ void MelonDsDs::SoftwareRenderState::Render(
 ) noexcept {
     ZoneScopedN(TracyFunction);
 
-    buffer.SetSize(screenLayout.BufferSize());
-    CombineScreens(error.TopScreen(), error.BottomScreen(), screenLayout);
+    // The error screen is always composited on this thread
+    FinishComposition();
+    hasComposedFrame = false;
 
-    retro::video_refresh(buffer[0], buffer.Width(), buffer.Height(), buffer.Stride());
+    ErrorFrameKey errorFrame(error, screenLayout);
+    bool recomposite = cachedErrorFrame != errorFrame;
+    if (recomposite) {
+        // If we haven't already composited this error screen with this layout...
+        cachedErrorFrame = errorFrame;
+    }
+
+    if (outputFormat == RETRO_PIXEL_FORMAT_RGB565) {
+        if (recomposite) {
+            buffer565.SetSize(screenLayout.BufferSize());
+            CombineScreens(buffer565, error.TopScreen(), error.BottomScreen(), screenLayout);
+        }
+        retro::video_refresh(buffer565[0], buffer565.Width(), buffer565.Height(), buffer565.Stride());
+    }
+    else {
+        if (recomposite) {
+            buffer.SetSize(screenLayout.BufferSize());
+            CombineScreens(buffer, error.TopScreen(), error.BottomScreen(), screenLayout);
+        }
+        retro::video_refresh(buffer[0], buffer.Width(), buffer.Height(), buffer.Stride());
+    }
 }
 
-void MelonDsDs::SoftwareRenderState::CopyScreen(const uint32_t* src, uvec2 destTranslation, ScreenLayout layout) noexcept {
+MelonDsDs::SoftwareRenderState::ErrorFrameKey::ErrorFrameKey(
+    const error::ErrorScreen& screen,
+    const ScreenLayoutData& screenLayout
+) noexcept :
+    Screen(&screen),
+    Layout(screenLayout.Layout()),
+    HybridSmallScreenLayout(screenLayout.HybridSmallScreenLayout()),
+    HybridRatio(screenLayout.HybridRatio()),
+    BufferSize(screenLayout.BufferSize()),
+    TopScreenTranslation(screenLayout.GetTopScreenTranslation()),
+    BottomScreenTranslation(screenLayout.GetBottomScreenTranslation()),
+    HybridScreenTranslation(screenLayout.GetHybridScreenTranslation()) {
+}
+
+bool MelonDsDs::SoftwareRenderState::ErrorFrameKey::operator==(const ErrorFrameKey& other) const noexcept {
+    return Screen == other.Screen &&
+        Layout == other.Layout &&
+        HybridSmallScreenLayout == other.HybridSmallScreenLayout &&
+        HybridRatio == other.HybridRatio &&
+        BufferSize == other.BufferSize &&
+        TopScreenTranslation == other.TopScreenTranslation &&
+        BottomScreenTranslation == other.BottomScreenTranslation &&
+        HybridScreenTranslation == other.HybridScreenTranslation;
+}
+
+void MelonDsDs::SoftwareRenderState::RenderLidClosed(const ScreenLayoutData& screenLayout) noexcept {
+    ZoneScopedN(TracyFunction);
+
+    // Don't show a frame from before the lid was closed when it's opened again
+    hasComposedFrame = false;
+
+    uvec2 size = screenLayout.BufferSize();
+    if (lidClosedFrameReady && retro::supports_frame_dupe()) {
+        // If we've already sent a black frame and the frontend can show it again...
+        retro::video_refresh(nullptr, size.x, size.y, 0);
+        return;
+    }
+
+    if (!lidClosedFrameReady) {
+        // If this is the first frame since the lid was closed (or since the layout changed)...
+        if (outputFormat == RETRO_PIXEL_FORMAT_RGB565) {
+            frontBuffer565.SetSize(size);
+            frontBuffer565.Clear();
+        }
+        else {
+            frontBuffer.SetSize(size);
+            frontBuffer.Clear();
+        }
+        lidClosedFrameReady = true;
+    }
+
+    SendFrontFrame();
+}
+
+void MelonDsDs::SoftwareRenderState::Compose(const CompositionJob& job) noexcept {
+    if (outputFormat == RETRO_PIXEL_FORMAT_RGB565) {
+        Compose(buffer565, job);
+    }
+    else {
+        Compose(buffer, job);
+    }
+}
+
+template<typename TBuffer>
+void MelonDsDs::SoftwareRenderState::Compose(TBuffer& dest, const CompositionJob& job) noexcept {
+    ZoneScopedN(TracyFunction);
+    dest.SetSize(job.Layout.BufferSize());
+    CombineScreens(dest, job.TopScreen, job.BottomScreen, job.Layout);
+    if (job.ShowCursor) {
+        DrawCursor(dest, job.TouchPosition, job.CursorSize, job.Layout);
+    }
+}
+
+void MelonDsDs::SoftwareRenderState::SendFrontFrame() const noexcept {
+    if (outputFormat == RETRO_PIXEL_FORMAT_RGB565) {
+        SendFrame(frontBuffer565);
+    }
+    else {
+        SendFrame(frontBuffer);
+    }
+}
+
+template<typename TBuffer>
+void MelonDsDs::SoftwareRenderState::SendFrame(const TBuffer& frame) noexcept {
+    ZoneScopedN(TracyFunction);
+    retro::video_refresh(frame[0], frame.Width(), frame.Height(), frame.Stride());
+
+#ifdef HAVE_TRACY
+    if (tracy::ProfilerAvailable()) {
+        // If Tracy is connected...
+        ZoneScopedN("MelonDsDs::render::RenderSoftware::SendFrameToTracy");
+        unsigned tracyStride = frame.Width() * 4;
+        std::unique_ptr<uint8_t[]> tracyFrame = std::make_unique<uint8_t[]>(tracyStride * frame.Height());
+        // libretro wants pixels in XRGB8888 or RGB565 format,
+        // but Tracy wants them in XBGR8888 format.
+        if constexpr (std::is_same_v<TBuffer, Rgb565PixelBuffer>) {
+            ZoneScopedN("conv_rgb565_argb8888");
+            conv_rgb565_argb8888(tracyFrame.get(), frame[0], frame.Width(), frame.Height(), tracyStride, frame.Stride());
+            conv_argb8888_abgr8888(tracyFrame.get(), tracyFrame.get(), frame.Width(), frame.Height(), tracyStride, tracyStride);
+        }
+        else {
+            ZoneScopedN("conv_argb8888_abgr8888");
+            conv_argb8888_abgr8888(tracyFrame.get(), frame[0], frame.Width(), frame.Height(), tracyStride, frame.Stride());
+        }
+
+        FrameImage(tracyFrame.get(), frame.Width(), frame.Height(), 0, false);
+    }
+#endif
+}
+
+template<typename TBuffer>
+void MelonDsDs::SoftwareRenderState::CopyScreen(TBuffer& dest, const uint32_t* src, uvec2 destTranslation, ScreenLayout layout) noexcept {
     ZoneScopedN(TracyFunction);
     // Only used for software rendering
 
@@ -124,15 +360,25 @@ void MelonDsDs::SoftwareRenderState::CopyScreen(const uint32_t* src, uvec2 destT
     // then its pixels can't all be contiguous in memory.
     // In that case, we have to copy each row of pixels individually to a different offset.
     if (LayoutSupportsDirectCopy(layout)) {
-        buffer.CopyDirect(src, destTranslation);
+        dest.CopyDirect(src, destTranslation);
     }
     else {
         // Not all of this screen's pixels will be contiguous in memory, so we have to copy them row by row
-        buffer.CopyRows(src, destTranslation, NDS_SCREEN_SIZE<unsigned>);
+        dest.CopyRows(src, destTranslation, NDS_SCREEN_SIZE<unsigned>);
     }
 }
 
-void MelonDsDs::SoftwareRenderState::DrawCursor(const InputState& input, const CoreConfig& config,
+static uint32_t InvertPixel(uint32_t pixel) noexcept {
+    return (0xFFFFFF - pixel) | 0xFF000000;
+}
+
+static uint16_t InvertPixel(uint16_t pixel) noexcept {
+    // RGB565 has no unused bits, so every channel can be inverted at once
+    return static_cast<uint16_t>(~pixel);
+}
+
+template<typename TBuffer>
+void MelonDsDs::SoftwareRenderState::DrawCursor(TBuffer& dest, ivec2 touchPosition, float cursorSize,
     const ScreenLayoutData& screenLayout
 ) noexcept {
     ZoneScopedN(TracyFunction);
@@ -141,37 +387,39 @@ void MelonDsDs::SoftwareRenderState::DrawCursor(const InputState& input, const C
     if (screenLayout.Layout() == ScreenLayout::TopOnly)
         return;
 
-    ivec2 cursorSize = ivec2(config.CursorSize());
-    ivec2 clampedTouch = clamp(input.TouchPosition(), ivec2(0), ivec2(NDS_SCREEN_WIDTH - 1, NDS_SCREEN_HEIGHT - 1));
+    ivec2 cursorExtent = ivec2(cursorSize);
+    ivec2 clampedTouch = clamp(touchPosition, ivec2(0), ivec2(NDS_SCREEN_WIDTH - 1, NDS_SCREEN_HEIGHT - 1));
     ivec2 transformedTouch = screenLayout.GetBottomScreenMatrix() * vec3(clampedTouch, 1);
 
-    uvec2 start = clamp(transformedTouch - ivec2(cursorSize), ivec2(0), ivec2(buffer.Size()));
-    uvec2 end = clamp(transformedTouch + ivec2(cursorSize), ivec2(0), ivec2(buffer.Size()));
+    uvec2 start = clamp(transformedTouch - cursorExtent, ivec2(0), ivec2(dest.Size()));
+    uvec2 end = clamp(transformedTouch + cursorExtent, ivec2(0), ivec2(dest.Size()));
 
     for (uint32_t y = start.y; y < end.y; y++) {
+        auto* row = dest[y];
         for (uint32_t x = start.x; x < end.x; x++) {
-            // TODO: Replace with SIMD (does GLM have a SIMD version of this?)
-            uint32_t& pixel = buffer[uvec2(x, y)];
-            pixel = (0xFFFFFF - pixel) | 0xFF000000;
+            row[x] = InvertPixel(row[x]);
         }
     }
 }
 
+template<typename TBuffer>
 void MelonDsDs::SoftwareRenderState::CombineScreens(
+    TBuffer& dest,
     std::span<const uint32_t, NDS_SCREEN_AREA<size_t>> topBuffer,
     std::span<const uint32_t, NDS_SCREEN_AREA<size_t>> bottomBuffer,
     const ScreenLayoutData& screenLayout
 ) noexcept {
     ZoneScopedN(TracyFunction);
 
-    buffer.Clear();
+    dest.Clear();
     ScreenLayout layout = screenLayout.Layout();
 
     if (IsHybridLayout(layout)) {
         auto primaryBuffer = layout == ScreenLayout::HybridTop || layout == ScreenLayout::FlippedHybridTop ? topBuffer : bottomBuffer;
 
+        // The scaler only works in XRGB8888, so the hybrid screen is converted when it's copied out of the staging area
         hybridScaler.Scale(hybridBuffer[0], primaryBuffer.data());
-        buffer.CopyRows(
+        dest.CopyRows(
             hybridBuffer[0],
             screenLayout.GetHybridScreenTranslation(),
             NDS_SCREEN_SIZE<unsigned> * screenLayout.HybridRatio()
@@ -181,20 +429,19 @@ void MelonDsDs::SoftwareRenderState::CombineScreens(
 
         if (smallScreenLayout == HybridSideScreenDisplay::Both || layout == ScreenLayout::HybridBottom || layout == ScreenLayout::FlippedHybridBottom) {
             // If we should display both screens, or if the bottom one is the primary...
-            buffer.CopyRows(topBuffer.data(), screenLayout.GetTopScreenTranslation(), NDS_SCREEN_SIZE<unsigned>);
+            dest.CopyRows(topBuffer.data(), screenLayout.GetTopScreenTranslation(), NDS_SCREEN_SIZE<unsigned>);
         }
 
         if (smallScreenLayout == HybridSideScreenDisplay::Both || layout == ScreenLayout::HybridTop || layout == ScreenLayout::FlippedHybridTop) {
             // If we should display both screens, or if the top one is being focused...
-            buffer.CopyRows(bottomBuffer.data(), screenLayout.GetBottomScreenTranslation(), NDS_SCREEN_SIZE<unsigned>);
+            dest.CopyRows(bottomBuffer.data(), screenLayout.GetBottomScreenTranslation(), NDS_SCREEN_SIZE<unsigned>);
         }
     }
     else {
         if (layout != ScreenLayout::BottomOnly)
-            CopyScreen(topBuffer.data(), screenLayout.GetTopScreenTranslation(), layout);
+            CopyScreen(dest, topBuffer.data(), screenLayout.GetTopScreenTranslation(), layout);
 
         if (layout != ScreenLayout::TopOnly)
-            CopyScreen(bottomBuffer.data(), screenLayout.GetBottomScreenTranslation(), layout);
+            CopyScreen(dest, bottomBuffer.data(), screenLayout.GetBottomScreenTranslation(), layout);
     }
 }
-
@@ -22,12 +22,18 @@
 
 #include <glm/mat3x3.hpp>
 #include <glm/vec2.hpp>
+#include <libretro.h>
 
 #include "buffer.hpp"
 #include "render.hpp"
 #include "screenlayout.hpp"
 #include "retro/scaler.hpp"
 
+namespace melonDS::Platform {
+    struct Thread;
+    struct Semaphore;
+}
+
 namespace MelonDsDs {
     namespace error {
         class ErrorScreen;
@@ -38,6 +44,7 @@ namespace MelonDsDs {
     class SoftwareRenderState final : public RenderState {
     public:
         SoftwareRenderState(const CoreConfig& config) noexcept;
+        ~SoftwareRenderState() noexcept override;
         bool Ready() const noexcept override { return true; }
         void Render(
             melonDS::NDS& nds,
@@ -51,23 +58,97 @@ namespace MelonDsDs {
             const ScreenLayoutData& screenLayout
         ) noexcept;
 
-        unsigned BufferWidth() const noexcept { return buffer.Width(); }
-        unsigned BufferHeight() const noexcept { return buffer.Height(); }
-        glm::uvec2 BufferSize() const noexcept { return buffer.Size(); }
+        void RequestRefresh() noexcept override {
+            cachedErrorFrame.Screen = nullptr;
+            lidClosedFrameReady = false;
+        }
+        void Flush() noexcept override;
+
+        /// If enabled, each frame is composited on a worker thread while the next one is emulated,
+        /// at the cost of one frame of latency.
+        void SetThreadedComposition(bool threaded) noexcept;
+
+        unsigned BufferWidth() const noexcept { return BufferSize().x; }
+        unsigned BufferHeight() const noexcept { return BufferSize().y; }
+        glm::uvec2 BufferSize() const noexcept { return outputFormat == RETRO_PIXEL_FORMAT_RGB565 ? buffer565.Size() : buffer.Size(); }
 
     private:
-        void CopyScreen(const uint32_t* src, glm::uvec2 destTranslation, ScreenLayout layout) noexcept;
-        void DrawCursor(const InputState& input, const CoreConfig& config, const ScreenLayoutData& screenLayout) noexcept;
+        /// Everything needed to composite one frame, copied so that it can be done on another thread
+        struct CompositionJob {
+            std::span<const uint32_t, NDS_SCREEN_AREA<size_t>> TopScreen;
+            std::span<const uint32_t, NDS_SCREEN_AREA<size_t>> BottomScreen;
+            ScreenLayoutData Layout;
+            bool ShowCursor;
+            glm::ivec2 TouchPosition;
+            float CursorSize;
+        };
+
+        template<typename TBuffer>
+        static void CopyScreen(TBuffer& dest, const uint32_t* src, glm::uvec2 destTranslation, ScreenLayout layout) noexcept;
+        template<typename TBuffer>
+        static void DrawCursor(TBuffer& dest, glm::ivec2 touchPosition, float cursorSize, const ScreenLayoutData& screenLayout) noexcept;
+        template<typename TBuffer>
         void CombineScreens(
+            TBuffer& dest,
             std::span<const uint32_t, NDS_SCREEN_AREA<size_t>> topBuffer,
             std::span<const uint32_t, NDS_SCREEN_AREA<size_t>> bottomBuffer,
             const ScreenLayoutData& screenLayout
         ) noexcept;
+        template<typename TBuffer>
+        void Compose(TBuffer& dest, const CompositionJob& job) noexcept;
+        void Compose(const CompositionJob& job) noexcept;
+        template<typename TBuffer>
+        static void SendFrame(const TBuffer& frame) noexcept;
+        void SendFrontFrame() const noexcept;
+        void RenderLidClosed(const ScreenLayoutData& screenLayout) noexcept;
+        void CompositionThreadMain() noexcept;
+        void FinishComposition() noexcept;
 
+        // Negotiated with the frontend when the game was loaded; only one of the buffers is used
+        retro_pixel_format outputFormat;
         PixelBuffer buffer;
+        Rgb565PixelBuffer buffer565;
+
+        // Everything that CombineScreens needs to draw the error screen the same way twice
+        struct ErrorFrameKey {
+            const error::ErrorScreen* Screen = nullptr;
+            ScreenLayout Layout {};
+            HybridSideScreenDisplay HybridSmallScreenLayout {};
+            unsigned HybridRatio = 0;
+            glm::uvec2 BufferSize {};
+            glm::uvec2 TopScreenTranslation {};
+            glm::uvec2 BottomScreenTranslation {};
+            glm::uvec2 HybridScreenTranslation {};
+
+            ErrorFrameKey() noexcept = default;
+            ErrorFrameKey(const error::ErrorScreen& screen, const ScreenLayoutData& screenLayout) noexcept;
+            bool operator==(const ErrorFrameKey& other) const noexcept;
+            bool operator!=(const ErrorFrameKey& other) const noexcept { return !(*this == other); }
+        };
+
+        // The error screen never changes once it's drawn,
+        // so its composited frame is kept in buffer until the screen or anything about its layout changes.
+        ErrorFrameKey cachedErrorFrame {};
+
         // Used as a staging area for the hybrid screen to be scaled
         PixelBuffer hybridBuffer;
         retro::Scaler hybridScaler;
+
+        // Used for threaded composition; the worker composites into buffer (or buffer565)
+        // while the last finished frame is presented from frontBuffer (or frontBuffer565).
+        PixelBuffer frontBuffer;
+        Rgb565PixelBuffer frontBuffer565;
+        std::optional<CompositionJob> compositionJob;
+        melonDS::Platform::Thread* compositionThread = nullptr;
+        melonDS::Platform::Semaphore* compositionStart = nullptr;
+        melonDS::Platform::Semaphore* compositionDone = nullptr;
+        bool compositionPending = false;
+        bool compositionQuit = false;
+        bool hasComposedFrame = false;
+
+        // While the lid is closed, a black frame is kept in frontBuffer (or frontBuffer565)
+        // and sent (or duplicated) every frame instead of compositing the screens.
+        bool lidClosedFrameReady = false;
     };
 }
 
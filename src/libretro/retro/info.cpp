@@ -19,14 +19,15 @@ Copyright 2023 Jesse Talavera-Greenberg
 #include <cstring>
 #include <libretro.h>
 
-retro::GameInfo::GameInfo(const retro_game_info& info) noexcept :
+retro::GameInfo::GameInfo(const retro_game_info& info, bool persistent) noexcept :
     _path(info.path ? info.path : ""),
-    _data(info.data && info.size ? std::make_unique<std::byte[]>(info.size) : nullptr),
+    _ownedData(info.data && info.size && !persistent ? std::make_unique<std::byte[]>(info.size) : nullptr),
+    _data(persistent ? static_cast<const std::byte*>(info.data) : _ownedData.get()),
     _size(info.size),
     _meta(info.meta ? info.meta : "")
 {
-    if (_data) {
-        memcpy(_data.get(), info.data, info.size);
+    if (_ownedData) {
+        memcpy(_ownedData.get(), info.data, info.size);
     }
 }
 
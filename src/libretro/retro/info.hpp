@@ -30,16 +30,20 @@ namespace retro {
 
     class GameInfo {
     public:
-        GameInfo(const retro_game_info& info) noexcept;
+        /// Copies the content's data, unless \c persistent is true;
+        /// then the frontend has promised to keep \c info.data alive until the game is unloaded,
+        /// so it's used directly instead of being duplicated.
+        GameInfo(const retro_game_info& info, bool persistent = false) noexcept;
 
         std::string_view GetPath() const noexcept { return _path; }
         std::span<const std::byte> GetData() const noexcept {
-            return std::span(_data.get(), _size);
+            return std::span(_data, _size);
         }
         std::string_view GetMeta() const noexcept { return _meta; }
     private:
         std::string _path;
-        std::unique_ptr<std::byte[]> _data;
+        std::unique_ptr<std::byte[]> _ownedData;
+        const std::byte* _data;
         size_t _size;
         std::string _meta;
     };
@@ -56,7 +56,7 @@ namespace MelonDsDs {
     template<typename T>
     constexpr T NDS_SCREEN_AREA = NDS_SCREEN_WIDTH * NDS_SCREEN_HEIGHT;
 
-    // We require a pixel format of RETRO_PIXEL_FORMAT_XRGB8888, so we can assume 4 bytes here
+    // melonDS renders in XRGB8888 (and PixelBuffer stores it), so we can assume 4 bytes here
     constexpr int PIXEL_SIZE = 4;
 
     template<typename T>
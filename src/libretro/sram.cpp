@@ -21,6 +21,7 @@
 #include <optional>
 #include <string_view>
 
+#include <encodings/crc32.h>
 #include <file/file_path.h>
 #include <retro_assert.h>
 #include <streams/file_stream.h>
@@ -158,4 +159,66 @@ void MelonDsDs::CoreState::WriteFirmware(const Firmware& firmware, uint32_t writ
     _timeToFirmwareFlush = Config.FlushDelay();
 }
 
+// Finds out what's in an existing save file without loading all of it at once
+static optional<MelonDsDs::sram::SaveFileState> ReadSaveFileState(const char* path) noexcept {
+    ZoneScopedN(TracyFunction);
+    if (!path_is_valid(path))
+        return nullopt;
+
+    // rzipstream opens the file as-is if it's not rzip-formatted
+    rzipstream_t* file = rzipstream_open(path, RETRO_VFS_FILE_ACCESS_READ);
+    if (!file)
+        return nullopt;
+
+    MelonDsDs::sram::SaveFileState state { .Compressed = rzipstream_is_compressed(file) };
+    uint32_t checksum = 0;
+    uint8_t chunk[16384];
+    int64_t bytesRead = 0;
+    while ((bytesRead = rzipstream_read(file, chunk, sizeof(chunk))) > 0) {
+        checksum = encoding_crc32(checksum, chunk, bytesRead);
+    }
+    rzipstream_close(file);
+
+    if (bytesRead < 0)
+        return nullopt;
+
+    state.Checksum = checksum;
+    return state;
+}
+
+MelonDsDs::sram::SaveWriteResult MelonDsDs::sram::WriteSaveFile(
+    string_view path,
+    std::span<const std::byte> data,
+    bool compress,
+    SaveFileState& state
+) noexcept {
+    ZoneScopedN(TracyFunction);
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data.data());
+    uint32_t checksum = encoding_crc32(0, bytes, data.size());
+
+    if (!state.Checksum) {
+        // If we haven't read or written this file yet this session...
+        if (optional<SaveFileState> onDisk = ReadSaveFileState(path.data())) {
+            state = *onDisk;
+        }
+    }
+
+    if (state.Checksum == checksum && state.Compressed == compress) {
+        return SaveWriteResult::Unchanged;
+    }
 
+    // rzipstream compresses the data in chunks as it writes,
+    // so we don't need a second buffer for the compressed copy
+    bool written = compress
+        ? rzipstream_write_file(path.data(), bytes, data.size())
+        : filestream_write_file(path.data(), bytes, data.size());
+
+    if (!written) {
+        // We don't know what's on disk anymore
+        state = {};
+        return SaveWriteResult::Failed;
+    }
+
+    state = { checksum, compress };
+    return SaveWriteResult::Written;
+}
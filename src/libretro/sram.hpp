@@ -18,9 +18,12 @@
 #define MELONDS_DS_SRAM_HPP
 
 #include <cstdint>
+#include <optional>
+#include <string_view>
 #include <vector>
 
 #include "libretro.hpp"
+#include "std/span.hpp"
 
 //! Definitions for managing SRAM.
 
@@ -61,6 +64,25 @@ namespace MelonDsDs::sram  {
         std::unique_ptr<uint8_t[]> _sram;
         uint32_t _sram_length;
     };
+
+    /// What a save file held when it was last read or written,
+    /// so that flushing unchanged data doesn't wear out the host's storage.
+    struct SaveFileState {
+        /// CRC32 of the uncompressed contents, or \c std::nullopt if not yet known
+        std::optional<uint32_t> Checksum;
+        bool Compressed = false;
+    };
+
+    enum class SaveWriteResult {
+        Written,
+        Unchanged,
+        Failed,
+    };
+
+    /// Writes data to the file at path, compressed in libretro's rzip format if requested.
+    /// Skips the write if the file already holds this data in the requested format.
+    /// If state doesn't know what the file holds yet, the file is read back (in chunks) to find out.
+    SaveWriteResult WriteSaveFile(std::string_view path, std::span<const std::byte> data, bool compress, SaveFileState& state) noexcept;
 }
 
 #endif //MELONDS_DS_SRAM_HPP
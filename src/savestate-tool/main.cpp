@@ -0,0 +1,498 @@
+/*
+    Copyright 2024 Jesse Talavera
+
+    melonDS DS is free software: you can redistribute it and/or modify it under
+    the terms of the GNU General Public License as published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+
+    melonDS DS is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with melonDS DS. If not, see http://www.gnu.org/licenses/.
+*/
+
+
+// A command-line tool for looking inside savestates made by melonDS DS,
+// for investigating states that won't load, netplay desyncs, and state size regressions.
+// Needs no content, system files, or GPU, so it can run in CI.
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <encodings/crc32.h>
+#include <fmt/format.h>
+#include <streams/file_stream.h>
+#include <streams/rzip_stream.h>
+
+#include "core/savestate.hpp"
+#include "environment.hpp"
+
+using std::byte;
+using std::optional;
+using std::nullopt;
+using std::span;
+using std::string;
+using std::string_view;
+using std::vector;
+
+namespace {
+    // melonDS's savestate layout, as written by melonDS::Savestate:
+    //
+    //   Header: "MELN", u16 major version, u16 minor version, u32 total length, reserved  (0x20 bytes)
+    //   Sections: four-character code, u32 length (including this header), reserved     (0x10 bytes each)
+    constexpr std::array<char, 4> MELONDS_MAGIC = {'M', 'E', 'L', 'N'};
+    constexpr size_t MELONDS_HEADER_SIZE = 0x20;
+    constexpr size_t MELONDS_SECTION_HEADER_SIZE = 0x10;
+
+    // RetroArch may wrap the core's state in its own container,
+    // in which the core's state is the "MEM " block.
+    constexpr string_view RASTATE_MAGIC = "RASTATE";
+    constexpr size_t RASTATE_HEADER_SIZE = 8;
+    constexpr std::array<char, 4> RASTATE_MEMORY_BLOCK = {'M', 'E', 'M', ' '};
+    constexpr std::array<char, 4> RASTATE_END_BLOCK = {'E', 'N', 'D', ' '};
+
+    // As laid out by melonDS's ARM::DoSavestate: cycle count, halt state, R0-R15, CPSR
+    constexpr size_t ARM_REGISTERS_OFFSET = 8;
+    constexpr size_t ARM_REGISTER_COUNT = 16;
+
+    constexpr size_t MAX_REPORTED_RANGES = 16;
+
+    /// A contiguous part of a savestate file, e.g. a container section or a melonDS section.
+    struct Component {
+        string Name;
+        uint16_t Version = 0;
+
+        /// Relative to the start of the file
+        size_t Offset = 0;
+        span<const byte> Data;
+    };
+
+    struct State {
+        vector<byte> Buffer;
+
+        /// The core's state, without any frontend-specific wrapping
+        span<const byte> Core;
+
+        /// Where Core begins within Buffer
+        size_t CoreOffset = 0;
+        bool Compressed = false;
+    };
+
+    uint32_t ReadU32(span<const byte> data, size_t offset) noexcept {
+        uint32_t value = 0;
+        memcpy(&value, data.data() + offset, sizeof(value));
+        return value;
+    }
+
+    uint16_t ReadU16(span<const byte> data, size_t offset) noexcept {
+        uint16_t value = 0;
+        memcpy(&value, data.data() + offset, sizeof(value));
+        return value;
+    }
+
+    string_view Tag(span<const byte> data, size_t offset) noexcept {
+        return { reinterpret_cast<const char*>(data.data() + offset), 4 };
+    }
+
+    uint32_t Checksum(span<const byte> data) noexcept {
+        return encoding_crc32(0, reinterpret_cast<const uint8_t*>(data.data()), data.size());
+    }
+
+    bool IsMelonDsState(span<const byte> data) noexcept {
+        return data.size() >= MELONDS_HEADER_SIZE && memcmp(data.data(), MELONDS_MAGIC.data(), MELONDS_MAGIC.size()) == 0;
+    }
+
+    // Finds the core's state within a RetroArch state file
+    optional<span<const byte>> UnwrapRetroArchState(span<const byte> data, size_t& offset) noexcept {
+        offset = RASTATE_HEADER_SIZE;
+        while (offset + 8 <= data.size()) {
+            string_view id = Tag(data, offset);
+            uint32_t length = ReadU32(data, offset + 4);
+            offset += 8;
+            if (offset + length > data.size()) {
+                fmt::print(stderr, "RetroArch state block \"{}\" extends past the end of the file\n", id);
+                return nullopt;
+            }
+
+            if (id == string_view(RASTATE_MEMORY_BLOCK.data(), RASTATE_MEMORY_BLOCK.size()))
+                return data.subspan(offset, length);
+
+            if (id == string_view(RASTATE_END_BLOCK.data(), RASTATE_END_BLOCK.size()))
+                break;
+
+            offset += (length + 7) & ~7u; // Blocks are padded to 8 bytes
+        }
+
+        fmt::print(stderr, "RetroArch state doesn't contain the core's state\n");
+        return nullopt;
+    }
+
+    // Reads a state from disk, decompressing it if RetroArch compressed it
+    optional<State> LoadState(const char* path) noexcept {
+        void* buffer = nullptr;
+        int64_t length = 0;
+        if (!rzipstream_read_file(path, &buffer, &length)) {
+            fmt::print(stderr, "Failed to read \"{}\"\n", path);
+            return nullopt;
+        }
+
+        State state;
+        state.Buffer.resize(length);
+        memcpy(state.Buffer.data(), buffer, length);
+        free(buffer);
+
+        if (RFILE* file = filestream_open(path, RETRO_VFS_FILE_ACCESS_READ, RETRO_VFS_FILE_ACCESS_HINT_NONE)) {
+            // rzipstream reads uncompressed files as-is, so compare the sizes to tell them apart
+            state.Compressed = filestream_get_size(file) != length;
+            filestream_close(file);
+        }
+
+        span<const byte> data = state.Buffer;
+        if (data.size() >= RASTATE_HEADER_SIZE && memcmp(data.data(), RASTATE_MAGIC.data(), RASTATE_MAGIC.size()) == 0) {
+            optional<span<const byte>> core = UnwrapRetroArchState(data, state.CoreOffset);
+            if (!core)
+                return nullopt;
+
+            state.Core = *core;
+        }
+        else {
+            state.Core = data;
+        }
+
+        return state;
+    }
+
+    // Splits a melonDS savestate into its sections
+    bool ReadMelonDsSections(span<const byte> data, size_t baseOffset, string_view prefix, vector<Component>& components) noexcept {
+        if (!IsMelonDsState(data)) {
+            fmt::print(stderr, "{}: not a melonDS savestate\n", prefix);
+            return false;
+        }
+
+        components.push_back({ fmt::format("{}header", prefix), ReadU16(data, 4), baseOffset, data.subspan(0, MELONDS_HEADER_SIZE) });
+
+        size_t offset = MELONDS_HEADER_SIZE;
+        size_t end = std::min<size_t>(ReadU32(data, 8), data.size());
+        while (offset + MELONDS_SECTION_HEADER_SIZE <= end) {
+            string_view id = Tag(data, offset);
+            uint32_t length = ReadU32(data, offset + 4);
+            if (length < MELONDS_SECTION_HEADER_SIZE || offset + length > end) {
+                fmt::print(stderr, "{}{}: section at {:#x} has an invalid length of {} bytes\n", prefix, id, baseOffset + offset, length);
+                return false;
+            }
+
+            size_t dataOffset = offset + MELONDS_SECTION_HEADER_SIZE;
+            components.push_back({ fmt::format("{}{}", prefix, id), 0, baseOffset + dataOffset, data.subspan(dataOffset, length - MELONDS_SECTION_HEADER_SIZE) });
+            offset += length;
+        }
+
+        return true;
+    }
+
+    // Lists every component of the core's state, in file order
+    optional<vector<Component>> GetComponents(const State& state) noexcept {
+        vector<Component> components;
+        if (!MelonDsDs::savestate::IsContainer(state.Core)) {
+            // Savestates from before the container was introduced
+            if (!ReadMelonDsSections(state.Core, state.CoreOffset, "", components))
+                return nullopt;
+
+            return components;
+        }
+
+        optional<vector<MelonDsDs::savestate::Section>> sections = MelonDsDs::savestate::ReadSections(state.Core);
+        if (!sections)
+            return nullopt;
+
+        for (const MelonDsDs::savestate::Section& section : *sections) {
+            string name(section.Id.data(), section.Id.size());
+            size_t offset = state.CoreOffset + section.Offset;
+            components.push_back({ name, section.Version, offset, section.Data });
+
+            if (IsMelonDsState(section.Data)) {
+                if (!ReadMelonDsSections(section.Data, offset, name + "/", components))
+                    return nullopt;
+            }
+        }
+
+        return components;
+    }
+
+    void PrintHexDump(span<const byte> data, size_t baseOffset) noexcept {
+        for (size_t row = 0; row < data.size(); row += 16) {
+            fmt::print("{:08x} ", baseOffset + row);
+            for (size_t i = row; i < row + 16; ++i) {
+                if (i < data.size())
+                    fmt::print(" {:02x}", static_cast<uint8_t>(data[i]));
+                else
+                    fmt::print("   ");
+            }
+
+            fmt::print("  ");
+            for (size_t i = row; i < std::min(row + 16, data.size()); ++i) {
+                char c = static_cast<char>(data[i]);
+                fmt::print("{}", (c >= 0x20 && c < 0x7f) ? c : '.');
+            }
+            fmt::print("\n");
+        }
+    }
+
+    int Info(const char* path) noexcept {
+        optional<State> state = LoadState(path);
+        if (!state)
+            return 2;
+
+        optional<vector<Component>> components = GetComponents(*state);
+        if (!components)
+            return 2;
+
+        fmt::print("{}: {} bytes{}\n", path, state->Buffer.size(), state->Compressed ? " (decompressed)" : "");
+        if (state->CoreOffset != 0)
+            fmt::print("Core state begins at {:#x} within a RetroArch state\n", state->CoreOffset);
+
+        if (MelonDsDs::savestate::IsContainer(state->Core)) {
+            if (optional<MelonDsDs::savestate::Container> container = MelonDsDs::savestate::ReadContainer(state->Core)) {
+                const MelonDsDs::savestate::ContentSection& content = container->Content;
+                fmt::print(
+                    "Content: game code {}, header CRC {:#06x}, NDS ROM {} bytes, GBA ROM {} bytes\n",
+                    string_view(content.GameCode.data(), content.GameCode.size()),
+                    content.HeaderCrc,
+                    content.NdsRomSize,
+                    content.GbaRomSize
+                );
+            }
+        }
+        else {
+            fmt::print("Bare melonDS savestate (made before savestate containers were introduced)\n");
+        }
+
+        fmt::print("\n{:<16} {:>7} {:>10} {:>10} {:>10}\n", "Section", "Version", "Offset", "Size", "CRC32");
+        for (const Component& component : *components) {
+            fmt::print(
+                "{:<16} {:>7} {:#10x} {:>10} {:#010x}\n",
+                component.Name,
+                component.Version,
+                component.Offset,
+                component.Data.size(),
+                Checksum(component.Data)
+            );
+        }
+
+        return 0;
+    }
+
+    int Dump(const char* path, string_view name, bool raw) noexcept {
+        optional<State> state = LoadState(path);
+        if (!state)
+            return 2;
+
+        optional<vector<Component>> components = GetComponents(*state);
+        if (!components)
+            return 2;
+
+        auto component = std::find_if(components->begin(), components->end(), [name](const Component& c) {
+            // Allow melonDS sections to be named without the container prefix
+            return c.Name == name || (c.Name.size() > name.size() && c.Name.compare(c.Name.size() - name.size(), name.size(), name) == 0 && c.Name[c.Name.size() - name.size() - 1] == '/');
+        });
+
+        if (component == components->end()) {
+            fmt::print(stderr, "{}: no section named \"{}\"\n", path, name);
+            return 2;
+        }
+
+        if (raw) {
+            fwrite(component->Data.data(), 1, component->Data.size(), stdout);
+        }
+        else {
+            PrintHexDump(component->Data, component->Offset);
+        }
+
+        return 0;
+    }
+
+    int Registers(const char* path) noexcept {
+        optional<State> state = LoadState(path);
+        if (!state)
+            return 2;
+
+        optional<vector<Component>> components = GetComponents(*state);
+        if (!components)
+            return 2;
+
+        bool found = false;
+        for (const Component& component : *components) {
+            string_view name = component.Name;
+            name = name.substr(name.find_last_of('/') + 1);
+            if (name != "ARM9" && name != "ARM7")
+                continue;
+
+            size_t cpsrOffset = ARM_REGISTERS_OFFSET + ARM_REGISTER_COUNT * sizeof(uint32_t);
+            if (component.Data.size() < cpsrOffset + sizeof(uint32_t)) {
+                fmt::print(stderr, "{}: section is too small to hold the CPU registers\n", component.Name);
+                return 2;
+            }
+
+            found = true;
+            fmt::print("{}:\n", name);
+            for (size_t i = 0; i < ARM_REGISTER_COUNT; ++i) {
+                fmt::print("  R{:<2} = {:#010x}{}", i, ReadU32(component.Data, ARM_REGISTERS_OFFSET + i * sizeof(uint32_t)), (i % 4 == 3) ? "\n" : "");
+            }
+            fmt::print("  CPSR = {:#010x}\n", ReadU32(component.Data, cpsrOffset));
+        }
+
+        if (!found) {
+            fmt::print(stderr, "{}: no CPU sections found\n", path);
+            return 2;
+        }
+
+        return 0;
+    }
+
+    // Prints the ranges of bytes that differ between two components of the same size
+    void PrintDifferingRanges(const Component& a, const Component& b) noexcept {
+        size_t ranges = 0;
+        size_t differingBytes = 0;
+        for (size_t i = 0; i < a.Data.size();) {
+            if (a.Data[i] == b.Data[i]) {
+                ++i;
+                continue;
+            }
+
+            size_t start = i;
+            while (i < a.Data.size() && a.Data[i] != b.Data[i])
+                ++i;
+
+            differingBytes += i - start;
+            if (ranges++ < MAX_REPORTED_RANGES) {
+                fmt::print(
+                    "  +{:#x}..+{:#x} ({} bytes; file offsets {:#x} vs {:#x})\n",
+                    start,
+                    i,
+                    i - start,
+                    a.Offset + start,
+                    b.Offset + start
+                );
+            }
+        }
+
+        if (ranges > MAX_REPORTED_RANGES)
+            fmt::print("  ...and {} more ranges\n", ranges - MAX_REPORTED_RANGES);
+
+        fmt::print("  {} of {} bytes differ\n", differingBytes, a.Data.size());
+    }
+
+    int Diff(const char* pathA, const char* pathB) noexcept {
+        optional<State> stateA = LoadState(pathA);
+        optional<State> stateB = LoadState(pathB);
+        if (!stateA || !stateB)
+            return 2;
+
+        optional<vector<Component>> componentsA = GetComponents(*stateA);
+        optional<vector<Component>> componentsB = GetComponents(*stateB);
+        if (!componentsA || !componentsB)
+            return 2;
+
+        std::map<string_view, const Component*> byName;
+        for (const Component& component : *componentsB)
+            byName.emplace(component.Name, &component);
+
+        bool different = false;
+        for (const Component& a : *componentsA) {
+            auto found = byName.find(a.Name);
+            if (found == byName.end()) {
+                fmt::print("{}: only in {}\n", a.Name, pathA);
+                different = true;
+                continue;
+            }
+
+            const Component& b = *found->second;
+            byName.erase(found);
+
+            if (a.Version != b.Version) {
+                fmt::print("{}: version {} vs {}\n", a.Name, a.Version, b.Version);
+                different = true;
+            }
+
+            if (a.Data.size() != b.Data.size()) {
+                fmt::print("{}: {} bytes vs {} bytes\n", a.Name, a.Data.size(), b.Data.size());
+                different = true;
+                continue;
+            }
+
+            if (memcmp(a.Data.data(), b.Data.data(), a.Data.size()) != 0) {
+                fmt::print("{}: contents differ\n", a.Name);
+                PrintDifferingRanges(a, b);
+                different = true;
+            }
+        }
+
+        for (const auto& [name, component] : byName) {
+            fmt::print("{}: only in {}\n", name, pathB);
+            different = true;
+        }
+
+        if (!different)
+            fmt::print("States are identical\n");
+
+        return different ? 1 : 0;
+    }
+
+    void PrintUsage(const char* program) noexcept {
+        fmt::print(stderr,
+            "Usage:\n"
+            "  {0} info <state>                   List the state's sections with their sizes and checksums\n"
+            "  {0} dump <state> <section> [--raw] Print one section as a hex dump, or write it to stdout as-is\n"
+            "  {0} regs <state>                   Print the ARM9 and ARM7 registers\n"
+            "  {0} diff <state> <state>           Compare two states section by section\n"
+            "\n"
+            "States may be compressed by RetroArch or wrapped in its state format.\n"
+            "diff exits with 0 if the states are identical, 1 if they differ, or 2 on error.\n",
+            program
+        );
+    }
+}
+
+// Defined here instead of linking environment.cpp, which needs a frontend
+void retro::fmt_log(retro_log_level level, fmt::string_view fmt, fmt::format_args args) noexcept {
+    if (level < RETRO_LOG_WARN)
+        return;
+
+    fmt::vprint(stderr, fmt, args);
+    fmt::print(stderr, "\n");
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        PrintUsage(argv[0]);
+        return 2;
+    }
+
+    string_view command = argv[1];
+    if (command == "info" && argc == 3)
+        return Info(argv[2]);
+
+    if (command == "dump" && (argc == 4 || (argc == 5 && string_view(argv[4]) == "--raw")))
+        return Dump(argv[2], argv[3], argc == 5);
+
+    if (command == "regs" && argc == 3)
+        return Registers(argv[2]);
+
+    if (command == "diff" && argc == 4)
+        return Diff(argv[2], argv[3]);
+
+    PrintUsage(argv[0]);
+    return 2;
+}
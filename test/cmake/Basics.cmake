@@ -105,6 +105,13 @@ add_python_test(
     CONTENT "${NDS_ROM}"
 )
 
+add_python_test(
+    NAME "Core restores instant-boot snapshot"
+    TEST_MODULE basics.core_instant_boots_from_snapshot
+    CONTENT "${NDS_ROM}"
+    CORE_OPTION melonds_instant_boot=30
+)
+
 add_python_test(
     NAME "Core exposes emulated RAM"
     TEST_MODULE basics.core_exposes_ram
@@ -160,6 +167,23 @@ add_python_test(
     CONTENT "${NDS_ROM}"
 )
 
+add_python_test(
+    NAME "Core shows a black screen while the lid is closed"
+    TEST_MODULE basics.core_blanks_screen_with_lid_closed
+    CONTENT "${NDS_ROM}"
+    CORE_OPTION "melonds_boot_mode=direct"
+    CORE_OPTION "melonds_sysfile_mode=builtin"
+)
+
+add_python_test(
+    NAME "Core sets pixel format to RGB565 if configured"
+    TEST_MODULE basics.core_sets_rgb565_pixel_format
+    CONTENT "${NDS_ROM}"
+    CORE_OPTION "melonds_pixel_format=rgb565"
+    CORE_OPTION "melonds_boot_mode=direct"
+    CORE_OPTION "melonds_sysfile_mode=builtin"
+)
+
 add_python_test(
     NAME "Core sets input descriptors"
     TEST_MODULE basics.core_defines_input_descriptors
@@ -227,6 +251,12 @@ add_python_test(
     NDS_SYSFILES
 )
 
+add_python_test(
+    NAME "Core reuses the console when switching games"
+    TEST_MODULE basics.core_reuses_console
+    CONTENT "${NDS_ROM}"
+)
+
 add_python_test(
     NAME "Core loads and unloads with subsystem content"
     TEST_MODULE basics.core_loads_subsystems
@@ -236,6 +266,37 @@ add_python_test(
     CONTENT "${GBA_SRAM}"
 )
 
+add_python_test(
+    NAME "Core loads compressed GBA SRAM"
+    TEST_MODULE save.gba_sram_file
+    SUBSYSTEM gba
+    CONTENT "${NDS_ROM}"
+    CONTENT "${GBA_ROM}"
+    CONTENT "${GBA_SRAM}"
+    CORE_OPTION GBA_SRAM_TEST=load_compressed
+)
+
+add_python_test(
+    NAME "Core writes compressed GBA SRAM"
+    TEST_MODULE save.gba_sram_file
+    SUBSYSTEM gba
+    CONTENT "${NDS_ROM}"
+    CONTENT "${GBA_ROM}"
+    CONTENT "${GBA_SRAM}"
+    CORE_OPTION GBA_SRAM_TEST=write_compressed
+    CORE_OPTION melonds_gba_save_compression=enabled
+)
+
+add_python_test(
+    NAME "Core doesn't rewrite unchanged GBA SRAM"
+    TEST_MODULE save.gba_sram_file
+    SUBSYSTEM gba
+    CONTENT "${NDS_ROM}"
+    CONTENT "${GBA_ROM}"
+    CONTENT "${GBA_SRAM}"
+    CORE_OPTION GBA_SRAM_TEST=skip_unchanged
+)
+
 add_python_test(
     NAME "Core defines controller info"
     TEST_MODULE basics.core_defines_controller_info
@@ -337,3 +398,62 @@ add_python_test(
     TEST_MODULE basics.core_gets_power_state
     CONTENT "${NDS_ROM}"
 )
+
+add_python_test(
+    NAME "Core enables battery saver when the host battery is low"
+    TEST_MODULE basics.core_enables_battery_saver
+    CONTENT "${NDS_ROM}"
+)
+
+add_python_test(
+    NAME "Core runs for multiple frames with huge pages requested"
+    TEST_MODULE basics.core_run_frames
+    CONTENT "${NDS_ROM}"
+    CORE_OPTION melonds_huge_pages=enabled
+)
+
+add_python_test(
+    NAME "Core profiles emulated frames"
+    TEST_MODULE basics.core_profiles_frames
+    CONTENT "${NDS_ROM}"
+    CORE_OPTION melonds_frame_profile=enabled
+)
+
+add_python_test(
+    NAME "Core applies title profiles from the system directory"
+    TEST_MODULE basics.core_applies_title_profile
+    CONTENT "${NDS_ROM}"
+)
+
+add_python_test(
+    NAME "Core replays frames deterministically in rollback mode"
+    TEST_MODULE basics.core_replays_deterministically
+    CONTENT "${NDS_ROM}"
+    CORE_OPTION melonds_rollback_mode=enabled
+    CORE_OPTION melonds_mic_input=noise
+    CORE_OPTION melonds_mic_input_active=always
+)
+
+if (TARGET melondsds_savestate)
+    add_python_test(
+        NAME "Savestate tool inspects and compares the core's savestates"
+        TEST_MODULE basics.savestate_tool_inspects_states
+        CONTENT "${NDS_ROM}"
+        CORE_OPTION "SAVESTATE_TOOL=$<TARGET_FILE:melondsds_savestate>"
+    )
+endif ()
+
+add_python_test(
+    NAME "Core batches local multiplayer packets"
+    TEST_MODULE basics.core_batches_mp_packets
+    CONTENT "${NDS_ROM}"
+    CORE_OPTION melonds_mp_batching=enabled
+)
+
+add_python_test(
+    NAME "Core benchmarks local multiplayer over simulated network conditions"
+    TEST_MODULE basics.mp_loopback_benchmark
+    CONTENT "${NDS_ROM}"
+    TIMEOUT 300
+    LABELS benchmark
+)
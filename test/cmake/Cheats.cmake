@@ -15,3 +15,9 @@ add_python_test(
     TEST_MODULE cheats.not_enabled_if_invalid
     CONTENT "${NDS_ROM}"
 )
+
+add_python_test(
+    NAME "Enabled cheats are compiled into fewer codes"
+    TEST_MODULE cheats.compiled_into_fewer_codes
+    CONTENT "${NDS_ROM}"
+)
@@ -20,6 +20,12 @@ add_python_test(
     NDS_SYSFILES
 )
 
+add_python_test(
+    NAME "Core caches and re-verifies system files"
+    TEST_MODULE firmware.core_caches_verified_system_files
+    NDS_SYSFILES
+)
+
 ### Ensuring firmware is not overwritten
 
 # See https://github.com/JesseTG/melonds-ds/issues/59
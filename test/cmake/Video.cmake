@@ -9,6 +9,16 @@ add_python_test(
     CORE_OPTION "melonds_threaded_renderer=enabled"
 )
 
+add_python_test(
+    NAME "Core runs with the threaded software renderer set to auto"
+    TEST_MODULE basics.core_run_frames
+    CONTENT "${NDS_ROM}"
+    CORE_OPTION "melonds_boot_mode=direct"
+    CORE_OPTION "melonds_sysfile_mode=builtin"
+    CORE_OPTION "melonds_console_mode=ds"
+    CORE_OPTION "melonds_threaded_renderer=auto"
+)
+
 add_python_test(
     NAME "Core runs for multiple frames with OpenGL"
     TEST_MODULE opengl.core_loads_unloads
@@ -73,3 +83,43 @@ add_python_test(
     REQUIRES_OPENGL
     NO_SKIP_ERROR_SCREEN
 )
+
+add_python_test(
+    NAME "Core runs for multiple frames with threaded screen composition"
+    TEST_MODULE basics.core_generates_video
+    CONTENT "${NDS_ROM}"
+    CORE_OPTION "melonds_threaded_composition=enabled"
+)
+
+add_python_test(
+    NAME "Core runs with threaded screen composition in a hybrid layout"
+    TEST_MODULE basics.core_run_frames
+    CONTENT "${NDS_ROM}"
+    CORE_OPTION "melonds_threaded_composition=enabled"
+    CORE_OPTION "melonds_screen_layout1=hybrid-top"
+)
+
+add_python_test(
+    NAME "Core runs for multiple frames with automatic frameskip"
+    TEST_MODULE basics.core_generates_video
+    CONTENT "${NDS_ROM}"
+    CORE_OPTION "melonds_frameskip=auto"
+)
+
+add_python_test(
+    NAME "Core runs for multiple frames with threshold frameskip"
+    TEST_MODULE basics.core_run_frames
+    CONTENT "${NDS_ROM}"
+    CORE_OPTION "melonds_frameskip=threshold"
+    CORE_OPTION "melonds_frameskip_threshold=60"
+    CORE_OPTION "melonds_show_frameskip_stats=enabled"
+)
+
+add_python_test(
+    NAME "Core skips frames with threaded screen composition"
+    TEST_MODULE basics.core_skips_frames
+    CONTENT "${NDS_ROM}"
+    CORE_OPTION "melonds_frameskip=threshold"
+    CORE_OPTION "melonds_frameskip_threshold=50"
+    CORE_OPTION "melonds_threaded_composition=enabled"
+)
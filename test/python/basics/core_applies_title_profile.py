@@ -0,0 +1,51 @@
+import os
+from ctypes import CFUNCTYPE, c_uint
+
+from libretro import Session
+
+import prelude
+
+with open(prelude.content_path, "rb") as rom:
+    rom.seek(0x0C)
+    game_code = rom.read(4).decode("ascii")
+
+profiles_path = os.path.join(prelude.core_system_dir, b"profiles.cfg")
+with open(profiles_path, "w") as profiles:
+    profiles.write("# Written by the test suite\n")
+    profiles.write(f"{game_code} melonds_audio_interpolation=cubic melonds_touch_mode=joystick\n")
+    profiles.write("XYZ melonds_audio_interpolation=cubic\n")  # Not a valid game code
+    profiles.write(f"{game_code}:FFFF melonds_touch_mode=sideways\n")  # Not a valid touch mode
+
+session: Session
+with prelude.session() as session:
+    title_profile_overrides = session.get_proc_address(b"melondsds_title_profile_overrides", CFUNCTYPE(c_uint))
+    invalid_title_profile_entries = session.get_proc_address(b"melondsds_invalid_title_profile_entries", CFUNCTYPE(c_uint))
+
+    assert invalid_title_profile_entries() == 2, f"Expected 2 invalid title profile entries, got {invalid_title_profile_entries()}"
+    assert title_profile_overrides() == 2, f"Expected 2 overrides for {game_code}, got {title_profile_overrides()}"
+
+    for i in range(60):
+        session.run()
+
+# The player's own profiles apply even to options that they've changed from the defaults
+with prelude.builder().with_options({"melonds_touch_mode": "touch"}).build() as session:
+    title_profile_overrides = session.get_proc_address(b"melondsds_title_profile_overrides", CFUNCTYPE(c_uint))
+
+    assert title_profile_overrides() == 2, f"Expected 2 overrides for {game_code}, got {title_profile_overrides()}"
+
+    for i in range(60):
+        session.run()
+
+# The player can turn off title profiles (including built-in ones) for a particular game
+with open(profiles_path, "w") as profiles:
+    profiles.write(f"{game_code} none\n")
+
+with prelude.session() as session:
+    title_profile_overrides = session.get_proc_address(b"melondsds_title_profile_overrides", CFUNCTYPE(c_uint))
+    invalid_title_profile_entries = session.get_proc_address(b"melondsds_invalid_title_profile_entries", CFUNCTYPE(c_uint))
+
+    assert invalid_title_profile_entries() == 0, f"Expected no invalid title profile entries, got {invalid_title_profile_entries()}"
+    assert title_profile_overrides() == 0, f"Expected no overrides for {game_code}, got {title_profile_overrides()}"
+
+    for i in range(60):
+        session.run()
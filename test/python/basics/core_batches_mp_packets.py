@@ -0,0 +1,43 @@
+# Connects two copies of the core over the simulated loopback link with batching enabled,
+# sends packets as the emulated Wi-Fi hardware would, and checks that they arrive intact
+# in fewer messages than there were packets.
+
+from ctypes import c_uint64, create_string_buffer
+
+import prelude
+from mploopback import Peer, connect, peer_session
+
+FRAMES = 10
+PACKETS_PER_FRAME = 4
+
+
+with peer_session(0) as first, peer_session(1) as second:
+    sender = Peer(first, 0)
+    receiver = Peer(second, 1)
+    connect(sender, receiver)
+
+    expected = []
+    received = []
+    buffer = create_string_buffer(2048)
+    timestamp = c_uint64()
+    for frame in range(FRAMES):
+        for i in range(PACKETS_PER_FRAME):
+            payload = f"frame {frame} packet {i}".encode()
+            packet_timestamp = frame * PACKETS_PER_FRAME + i
+            assert sender.send(payload, len(payload), packet_timestamp, i == 0)
+            expected.append((packet_timestamp, payload))
+
+        sender.session.run()  # The batch goes out at the end of the frame
+
+        while length := receiver.receive(buffer, len(buffer), timestamp):
+            received.append((timestamp.value, buffer.raw[:length]))
+
+    assert received == expected, f"Sent {expected}, but received {received}"
+    assert sender.packets_sent() == FRAMES * PACKETS_PER_FRAME, f"Sent {sender.packets_sent()} packets"
+    assert receiver.packets_received() == FRAMES * PACKETS_PER_FRAME, f"Received {receiver.packets_received()} packets"
+    assert sender.messages_sent() < sender.packets_sent(), \
+        f"Sent {sender.packets_sent()} packets in {sender.messages_sent()} messages; expected them to be batched"
+    assert 0 < sender.flushes() <= FRAMES, f"Flushed {sender.flushes()} times over {FRAMES} frames"
+
+    for peer in (sender, receiver):
+        peer.stop()
@@ -0,0 +1,28 @@
+from itertools import repeat
+
+from libretro import JoypadState, Session, Screenshot
+import prelude
+
+
+def generate_input():
+    yield from repeat(0, 60)
+    yield JoypadState(l3=True)
+    yield from repeat(0)
+
+
+session: Session
+with prelude.builder().with_input(generate_input).build() as session:
+    for i in range(60):
+        session.run()
+
+    frame1 = session.video.screenshot()
+    assert isinstance(frame1, Screenshot)
+    assert any(frame1.data)
+
+    for i in range(120):
+        session.run()
+
+    frame2 = session.video.screenshot()
+    assert isinstance(frame2, Screenshot)
+    assert (frame1.width, frame1.height) == (frame2.width, frame2.height)
+    assert not any(frame2.data[i] for i in range(len(frame2.data)) if i % 4 != 3), "Expected a black frame with the lid closed"
@@ -0,0 +1,25 @@
+from ctypes import CFUNCTYPE, c_bool, c_uint
+
+from libretro import Session
+
+import prelude
+from libretro.api.power import retro_device_power, PowerState
+
+options = {
+    b"melonds_battery_saver_threshold": b"20",
+    b"melonds_battery_update_interval": b"1",
+}
+
+power = retro_device_power(PowerState.DISCHARGING, 600, 10)
+session: Session
+with prelude.builder().with_options(options).with_power(power).build() as session:
+    battery_saver_active = session.get_proc_address("melondsds_battery_saver_active", CFUNCTYPE(c_bool))
+    battery_saver_activations = session.get_proc_address("melondsds_battery_saver_activations", CFUNCTYPE(c_uint))
+    assert battery_saver_active is not None, "melondsds_battery_saver_active not found"
+    assert battery_saver_activations is not None, "melondsds_battery_saver_activations not found"
+
+    for i in range(5):
+        session.run()
+
+    assert battery_saver_active(), "Battery saver should be enabled when the battery is below the threshold"
+    assert battery_saver_activations() == 1, f"Expected 1 activation, got {battery_saver_activations()}"
@@ -0,0 +1,40 @@
+import os
+import struct
+from ctypes import CFUNCTYPE, c_bool
+
+from libretro import Session
+
+import prelude
+
+instant_boot_dir = os.path.join(prelude.core_system_dir, b"instantboot")
+
+with open(prelude.content_path, "rb") as rom:
+    header = rom.read(0x160)
+    game_code = header[0x0C:0x10].decode("ascii")
+    (header_crc,) = struct.unpack_from("<H", header, 0x15E)
+
+session: Session
+with prelude.session() as session:
+    instant_booted = session.get_proc_address(b"melondsds_instant_booted", CFUNCTYPE(c_bool))
+
+    for i in range(45):
+        session.run()
+
+    assert not instant_booted(), "Instant-booted without a snapshot"
+
+assert os.path.isdir(instant_boot_dir), f"{instant_boot_dir} wasn't created"
+snapshots = os.listdir(instant_boot_dir)
+assert len(snapshots) == 1, f"Expected 1 snapshot, found {snapshots}"
+
+expected_suffix = f"-{game_code}-{header_crc:04x}.state".encode()
+assert snapshots[0].endswith(expected_suffix), f"Expected the snapshot's name to end with {expected_suffix}, got {snapshots[0]}"
+
+with prelude.session() as session:
+    instant_booted = session.get_proc_address(b"melondsds_instant_booted", CFUNCTYPE(c_bool))
+
+    session.run()
+
+    assert instant_booted(), "Didn't restore the instant-boot snapshot"
+
+    for i in range(30):
+        session.run()
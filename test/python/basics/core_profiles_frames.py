@@ -0,0 +1,16 @@
+from ctypes import CFUNCTYPE, c_uint64
+
+from libretro import Session
+
+import prelude
+
+session: Session
+with prelude.session() as session:
+    profiled_frames = session.get_proc_address(b"melondsds_profiled_frames", CFUNCTYPE(c_uint64))
+    profiled_frame_spikes = session.get_proc_address(b"melondsds_profiled_frame_spikes", CFUNCTYPE(c_uint64))
+
+    for i in range(120):
+        session.run()
+
+    assert profiled_frames() == 120, f"Expected 120 profiled frames, got {profiled_frames()}"
+    assert profiled_frame_spikes() <= profiled_frames()
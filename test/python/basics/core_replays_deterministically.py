@@ -0,0 +1,50 @@
+from ctypes import CFUNCTYPE, c_uint64
+
+from libretro import Session
+
+import prelude
+
+session: Session
+with prelude.session() as session:
+    rollbacks = session.get_proc_address(b"melondsds_rollbacks", CFUNCTYPE(c_uint64))
+
+    for i in range(30):
+        session.run()
+
+    size = session.core.serialize_size()
+    assert size > 0
+
+    start = bytearray(size)
+    assert session.core.serialize(start)
+
+    for i in range(30):
+        session.run()
+
+    first = bytearray(size)
+    assert session.core.serialize(first)
+
+    assert not session.core.unserialize(bytearray(size)), "Loaded a blank savestate"
+    assert rollbacks() == 0, f"Counted a failed load as a rollback ({rollbacks()} rollbacks)"
+
+    assert session.core.unserialize(start)
+    assert rollbacks() == 1, f"Expected 1 rollback, got {rollbacks()}"
+
+    for i in range(30):
+        session.run()
+
+    replayed = bytearray(size)
+    assert session.core.serialize(replayed)
+
+    assert first == replayed, "Replaying the same frames produced a different state"
+
+# Outside of rollback mode, loading a state is the player's doing, not a rollback
+with prelude.builder().with_options({"melonds_rollback_mode": "disabled"}).build() as session:
+    rollbacks = session.get_proc_address(b"melondsds_rollbacks", CFUNCTYPE(c_uint64))
+
+    for i in range(30):
+        session.run()
+
+    state = bytearray(session.core.serialize_size())
+    assert session.core.serialize(state)
+    assert session.core.unserialize(state)
+    assert rollbacks() == 0, f"Counted a manual load as a rollback ({rollbacks()} rollbacks)"
@@ -0,0 +1,30 @@
+import os
+from ctypes import CFUNCTYPE, c_bool, c_void_p, cast, create_string_buffer
+
+from libretro import Session
+from libretro.api import retro_game_info
+
+import prelude
+
+with open(prelude.content_path, "rb") as rom:
+    content = rom.read()
+
+session: Session
+with prelude.session() as session:
+    console_reused = session.get_proc_address(b"melondsds_console_reused", CFUNCTYPE(c_bool))
+
+    for i in range(30):
+        session.run()
+
+    assert not console_reused(), "The first game can't have reused a console"
+
+    # Switch games without deinitializing the core, like a frontend loading from its history would
+    session.core.unload_game()
+
+    buffer = create_string_buffer(content, len(content))
+    game = retro_game_info(os.fsencode(prelude.content_path), cast(buffer, c_void_p), len(content), None)
+    assert session.core.load_game(game), "Failed to load the second game"
+    assert console_reused(), "The second game didn't reuse the first game's console"
+
+    for i in range(30):
+        session.run()
@@ -0,0 +1,14 @@
+from libretro import Session, PixelFormat, Screenshot
+
+import prelude
+
+session: Session
+with prelude.session() as session:
+    assert session.video.pixel_format == PixelFormat.RGB565
+
+    for i in range(70):
+        session.run()
+
+    frame = session.video.screenshot()
+    assert isinstance(frame, Screenshot)
+    assert any(frame.data)
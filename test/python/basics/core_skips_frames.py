@@ -0,0 +1,23 @@
+from ctypes import CFUNCTYPE, c_bool, c_uint, c_uint64
+
+from libretro import Session
+
+import prelude
+
+session: Session
+with prelude.session() as session:
+    frames_skipped = session.get_proc_address(b"melondsds_frames_skipped", CFUNCTYPE(c_uint64))
+    set_audio_buffer_status = session.get_proc_address(
+        b"melondsds_set_audio_buffer_status",
+        CFUNCTYPE(None, c_bool, c_uint, c_bool)
+    )
+
+    for i in range(300):
+        # Alternate between a starved and a healthy audio buffer,
+        # so skipped frames are interleaved with composited ones
+        low = (i // 3) % 2 == 0
+        set_audio_buffer_status(True, 10 if low else 90, low)
+        session.run()
+
+    assert frames_skipped() > 0, "No frames were skipped"
+    assert frames_skipped() < 300, "Every frame was skipped"
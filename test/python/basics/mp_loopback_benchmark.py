@@ -0,0 +1,75 @@
+# Runs two copies of the core against each other over the simulated loopback link,
+# once per impairment profile, and reports how local multiplayer holds up.
+# Each frame, the host sends a command and waits for the client's reply,
+# the way a DS in a local multiplayer mode does;
+# the packets go through the same hooks that the emulated Wi-Fi hardware uses,
+# so the test ROM doesn't need to start a multiplayer game.
+#
+# MP_PROFILES: semicolon-separated impairment profiles (see ParseImpairmentProfile),
+#              defaults to "ideal;lan;wifi;congested"
+# MP_FRAMES: frames to run per profile
+
+import os
+import threading
+import time
+from ctypes import c_uint64, create_string_buffer
+
+import prelude
+from mploopback import Peer, connect, peer_session
+
+PROFILES = os.environ.get("MP_PROFILES", "ideal;lan;wifi;congested").split(";")
+FRAMES = int(os.environ.get("MP_FRAMES", "60"))
+HOST_ID, CLIENT_ID = 0, 1
+
+
+def run(peer: Peer, frames: int, fps: dict[int, float]):
+    buffer = create_string_buffer(2048)
+    timestamp = c_uint64()
+    start = time.perf_counter()
+    for frame in range(frames):
+        if peer.client_id == HOST_ID:
+            payload = f"command {frame}".encode()
+            assert peer.send(payload, len(payload), frame, True)
+            peer.receive_block(buffer, len(buffer), timestamp)  # A reply that never comes is a timeout
+        elif peer.receive_block(buffer, len(buffer), timestamp):
+            payload = f"reply {timestamp.value}".encode()
+            assert peer.send(payload, len(payload), timestamp.value, False)
+
+        peer.session.run()
+    fps[peer.client_id] = frames / (time.perf_counter() - start)
+
+
+with peer_session(0) as first, peer_session(1) as second:
+    peers = (Peer(first, HOST_ID), Peer(second, CLIENT_ID))
+    assert not peers[0].start(HOST_ID, b"delay=nonsense"), "Invalid profile was accepted"
+
+    print(
+        f"{'Profile':<40} {'Peer':>4} {'FPS':>8} {'Sent':>6} {'Received':>8} {'Timeouts':>8} "
+        f"{'Delivered':>9} {'Dropped':>7} {'Reordered':>9}"
+    )
+    for profile in PROFILES:
+        # These are counted over the core's lifetime, unlike the loopback link's stats
+        before = [(peer.packets_sent(), peer.packets_received(), peer.timeouts()) for peer in peers]
+        connect(*peers, profile.encode())
+
+        fps = {}
+        threads = [threading.Thread(target=run, args=(peer, FRAMES, fps)) for peer in peers]
+        for thread in threads:
+            thread.start()
+        for thread in threads:
+            thread.join()
+
+        for peer, (sent, received, timeouts) in zip(peers, before):
+            sent = peer.packets_sent() - sent
+            received = peer.packets_received() - received
+            print(
+                f"{profile:<40} {peer.client_id:>4} {fps[peer.client_id]:>8.1f} {sent:>6} {received:>8} "
+                f"{peer.timeouts() - timeouts:>8} {peer.delivered():>9} {peer.dropped():>7} {peer.reordered():>9}"
+            )
+            assert fps[peer.client_id] > 0
+            if profile == "ideal":
+                assert received > 0, f"Peer {peer.client_id} received nothing over an ideal link"
+                assert peer.dropped() == 0, f"Peer {peer.client_id} lost {peer.dropped()} packets over an ideal link"
+
+        for peer in peers:
+            peer.stop()
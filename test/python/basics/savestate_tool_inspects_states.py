@@ -0,0 +1,56 @@
+import os
+import subprocess
+
+from libretro import Session
+
+import prelude
+
+tool = os.environ["SAVESTATE_TOOL"]
+first_path = os.path.join(prelude.testdir, b"first.state")
+second_path = os.path.join(prelude.testdir, b"second.state")
+
+
+def save_state(session: Session, path: bytes):
+    size = session.core.serialize_size()
+    assert size > 0
+
+    state = bytearray(size)
+    assert session.core.serialize(state)
+    with open(path, "wb") as f:
+        f.write(state)
+
+
+def run_tool(*args) -> subprocess.CompletedProcess:
+    result = subprocess.run([tool, *args], capture_output=True, text=True)
+    print(result.stdout)
+    print(result.stderr)
+    return result
+
+
+session: Session
+with prelude.session() as session:
+    for i in range(30):
+        session.run()
+
+    save_state(session, first_path)
+
+    for i in range(30):
+        session.run()
+
+    save_state(session, second_path)
+
+info = run_tool("info", first_path)
+assert info.returncode == 0, f"info exited with {info.returncode}"
+assert "CNTT" in info.stdout
+assert "MELN/ARM9" in info.stdout
+
+regs = run_tool("regs", first_path)
+assert regs.returncode == 0, f"regs exited with {regs.returncode}"
+assert "CPSR" in regs.stdout
+
+same = run_tool("diff", first_path, first_path)
+assert same.returncode == 0, f"diff of identical states exited with {same.returncode}"
+
+different = run_tool("diff", first_path, second_path)
+assert different.returncode == 1, f"diff of different states exited with {different.returncode}"
+assert "contents differ" in different.stdout
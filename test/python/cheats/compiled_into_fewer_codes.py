@@ -0,0 +1,34 @@
+from ctypes import CFUNCTYPE, c_uint
+
+from libretro import Session
+from libretro.h import RETRO_MEMORY_SYSTEM_RAM
+
+import prelude
+
+session: Session
+with prelude.session() as session:
+    num_cheats = session.get_proc_address(b"melondsds_num_cheats", CFUNCTYPE(c_uint))
+    num_compiled_cheats = session.get_proc_address(b"melondsds_num_compiled_cheats", CFUNCTYPE(c_uint))
+
+    # Consecutive constant writes are merged into one code, and disabled codes are dropped
+    session.core.cheat_set(0, True, b'02000000 DEADBEEF')
+    session.core.cheat_set(1, True, b'02000004 CAFEBABE 02000000 0BADF00D')
+    session.core.cheat_set(2, False, b'02000008 12345678')
+
+    assert num_cheats() == 3, f"Expected 3 cheats, got {num_cheats()}"
+    assert num_compiled_cheats() == 1, f"Expected 1 compiled cheat, got {num_compiled_cheats()}"
+
+    for i in range(60):
+        session.run()
+
+    memory = session.core.get_memory(RETRO_MEMORY_SYSTEM_RAM)
+    assert memory is not None
+    assert memory[0:4].tobytes() == b'\x0d\xf0\xad\x0b', f"Expected 0x0BADF00D, got {memory[0:4].tobytes()}"
+    assert memory[4:8].tobytes() == b'\xbe\xba\xfe\xca', f"Expected 0xCAFEBABE, got {memory[4:8].tobytes()}"
+    assert memory[8:12].tobytes() != b'\x78\x56\x34\x12', "Disabled cheat was applied"
+
+    session.core.cheat_set(2, True, b'02000008 12345678')
+    assert num_compiled_cheats() == 1, f"Expected 1 compiled cheat, got {num_compiled_cheats()}"
+
+    session.core.cheat_reset()
+    assert num_compiled_cheats() == 0, f"Expected 0 compiled cheats, got {num_compiled_cheats()}"
@@ -0,0 +1,36 @@
+import os
+import zlib
+from ctypes import CFUNCTYPE, c_size_t
+
+from libretro import Session
+
+import prelude
+
+cache_path = os.path.join(prelude.core_system_dir, b"sysfile_cache.txt")
+firmware_name = os.path.basename(os.environ["NDS_FIRMWARE"]).encode()
+
+with open(os.path.join(prelude.core_system_dir, firmware_name), "rb") as f:
+    firmware_crc32 = f"{zlib.crc32(f.read()):08x}".encode()
+
+session: Session
+with prelude.session() as session:
+    assert os.path.isfile(cache_path), f"Expected the system file cache at {cache_path}"
+
+    with open(cache_path, "rb") as f:
+        cache = f.read()
+
+    assert firmware_name in cache, f"Expected {firmware_name} to be in the system file cache"
+    firmware_entry = next(line for line in cache.splitlines() if line.endswith(firmware_name))
+    assert firmware_entry.split(b"\t")[4] == firmware_crc32, \
+        f"Expected {firmware_name}'s cache entry to record CRC32 {firmware_crc32}, got {firmware_entry}"
+
+    verify_system_files = session.get_proc_address("melondsds_verify_system_files", CFUNCTYPE(c_size_t))
+    assert verify_system_files is not None, "melondsds_verify_system_files not found"
+
+    found = verify_system_files()
+    assert found >= 1, f"Expected at least one system file to be verified, got {found}"
+
+    with open(cache_path, "rb") as f:
+        rebuilt_cache = f.read()
+
+    assert firmware_name in rebuilt_cache, f"Expected {firmware_name} to be in the rebuilt system file cache"
@@ -0,0 +1,59 @@
+# Shared fixture for tests that connect copies of the core over the simulated loopback link.
+# Import it after prelude, which parses the command line.
+
+import os
+import shutil
+from ctypes import CFUNCTYPE, POINTER, c_bool, c_char_p, c_size_t, c_uint16, c_uint64, c_void_p
+
+import libretro
+from libretro import Session
+
+import prelude
+
+DeliverFn = CFUNCTYPE(None, c_void_p, c_size_t, c_uint16)
+
+
+def peer_session(index: int) -> Session:
+    # Each copy of the core needs its own globals, so it must be loaded from its own file
+    core_path = os.fsdecode(prelude.core_path)
+    _, ext = os.path.splitext(core_path)
+    path = os.path.join(os.fsdecode(prelude.testdir), f"peer{index}{ext}")
+    shutil.copyfile(core_path, path)
+
+    return (
+        libretro
+        .defaults(path)
+        .with_content(prelude.content_path)
+        .with_paths(prelude.path_driver)
+        .with_options(prelude.options)
+        .build()
+    )
+
+
+class Peer:
+    def __init__(self, session: Session, client_id: int):
+        self.session = session
+        self.client_id = client_id
+        self.start = session.get_proc_address(b"melondsds_mp_loopback_start", CFUNCTYPE(c_bool, c_uint16, c_char_p))
+        self.connect = session.get_proc_address(b"melondsds_mp_loopback_connect", CFUNCTYPE(None, c_uint16, DeliverFn))
+        self.deliver = session.get_proc_address(b"melondsds_mp_loopback_deliver", DeliverFn)
+        self.stop = session.get_proc_address(b"melondsds_mp_loopback_stop", CFUNCTYPE(None))
+        self.send = session.get_proc_address(b"melondsds_mp_send_packet", CFUNCTYPE(c_bool, c_char_p, c_size_t, c_uint64, c_bool))
+        self.receive = session.get_proc_address(b"melondsds_mp_receive_packet", CFUNCTYPE(c_size_t, c_void_p, c_size_t, POINTER(c_uint64)))
+        self.receive_block = session.get_proc_address(b"melondsds_mp_receive_packet_block", CFUNCTYPE(c_size_t, c_void_p, c_size_t, POINTER(c_uint64)))
+        self.packets_sent = session.get_proc_address(b"melondsds_mp_packets_sent", CFUNCTYPE(c_uint64))
+        self.packets_received = session.get_proc_address(b"melondsds_mp_packets_received", CFUNCTYPE(c_uint64))
+        self.messages_sent = session.get_proc_address(b"melondsds_mp_messages_sent", CFUNCTYPE(c_uint64))
+        self.flushes = session.get_proc_address(b"melondsds_mp_flushes", CFUNCTYPE(c_uint64))
+        self.timeouts = session.get_proc_address(b"melondsds_mp_timeouts", CFUNCTYPE(c_uint64))
+        self.delivered = session.get_proc_address(b"melondsds_mp_loopback_delivered", CFUNCTYPE(c_uint64))
+        self.dropped = session.get_proc_address(b"melondsds_mp_loopback_dropped", CFUNCTYPE(c_uint64))
+        self.reordered = session.get_proc_address(b"melondsds_mp_loopback_reordered", CFUNCTYPE(c_uint64))
+
+
+def connect(first: Peer, second: Peer, profile: bytes = b"ideal"):
+    for peer in (first, second):
+        assert peer.start(peer.client_id, profile), f"Peer {peer.client_id} couldn't start with profile {profile}"
+
+    first.connect(second.client_id, second.deliver)
+    second.connect(first.client_id, first.deliver)
@@ -0,0 +1,90 @@
+# Loads a copy of the GBA save file and checks how the core reads and writes it back.
+# GBA_SRAM_TEST selects the behavior to test:
+#   load_compressed: the save is rzip-compressed, and must load as if it weren't
+#   write_compressed: the save is flushed in rzip format (needs melonds_gba_save_compression=enabled)
+#   skip_unchanged: the save isn't rewritten if the game didn't change it
+
+import os
+import struct
+import zlib
+
+from libretro import Session, SubsystemContent
+from ctypes import CFUNCTYPE, POINTER, c_size_t, c_uint8
+
+import prelude
+
+RZIP_MAGIC = b"#RZIPv\x01#"
+RZIP_CHUNK_SIZE = 131072
+OLD_MTIME_NS = 1_000_000_000 * 1_000_000_000
+
+mode = os.environ["GBA_SRAM_TEST"]
+nds_path, gba_path, sram_path = prelude.content_paths
+
+
+def rzip_compress(data: bytes) -> bytes:
+    # libretro's rzip format: magic, chunk size, uncompressed size, then zlib-compressed chunks
+    compressed = bytearray(RZIP_MAGIC)
+    compressed += struct.pack("<IQ", RZIP_CHUNK_SIZE, len(data))
+    for i in range(0, len(data), RZIP_CHUNK_SIZE):
+        chunk = zlib.compress(data[i:i + RZIP_CHUNK_SIZE])
+        compressed += struct.pack("<I", len(chunk)) + chunk
+
+    return bytes(compressed)
+
+
+def rzip_decompress(data: bytes) -> bytes:
+    assert data.startswith(RZIP_MAGIC), "Not an rzip stream"
+    _, size = struct.unpack_from("<IQ", data, len(RZIP_MAGIC))
+    offset = len(RZIP_MAGIC) + 12
+    decompressed = bytearray()
+    while offset < len(data):
+        (length,) = struct.unpack_from("<I", data, offset)
+        offset += 4
+        decompressed += zlib.decompress(data[offset:offset + length])
+        offset += length
+
+    assert len(decompressed) == size, f"rzip header says {size} bytes, but decompressed {len(decompressed)}"
+    return bytes(decompressed)
+
+
+with open(sram_path, "rb") as f:
+    original = f.read()
+
+# Never let the core write to the test suite's own copy of the save
+copy_path = os.path.join(prelude.testdir, b"gba_sram_file.srm")
+with open(copy_path, "wb") as f:
+    f.write(rzip_compress(original) if mode == "load_compressed" else original)
+
+if mode == "skip_unchanged":
+    os.utime(copy_path, ns=(OLD_MTIME_NS, OLD_MTIME_NS))
+
+content = SubsystemContent(prelude.subsystem, (nds_path, gba_path, os.fsdecode(copy_path)))
+
+session: Session
+with prelude.builder().with_content(content).build() as session:
+    gba_sram_length = session.get_proc_address(b"melondsds_gba_sram_length", CFUNCTYPE(c_size_t))
+    gba_sram = session.get_proc_address(b"melondsds_gba_sram", CFUNCTYPE(POINTER(c_uint8)))
+
+    length = gba_sram_length()
+    assert length > 0, "GBA SRAM not installed"
+    loaded = bytes(gba_sram()[:min(length, len(original))])
+    assert loaded == original[:len(loaded)], "GBA SRAM doesn't match the save file"
+
+    for i in range(60):
+        session.run()
+
+# Unloading the game flushes the save
+with open(copy_path, "rb") as f:
+    written = f.read()
+
+match mode:
+    case "load_compressed":
+        pass
+    case "write_compressed":
+        assert rzip_decompress(written) == original, "Compressed save doesn't match the original"
+    case "skip_unchanged":
+        assert written == original, "Save file was changed"
+        mtime = os.stat(copy_path).st_mtime_ns
+        assert mtime == OLD_MTIME_NS, f"Unchanged save was rewritten (mtime is now {mtime})"
+    case _:
+        raise ValueError(f"Unknown GBA_SRAM_TEST {mode}")